@@ -8,6 +8,17 @@ const aiRouter = require('../local-api/services/aiRequest');
 
 const RAMDISK_DIR = path.resolve(__dirname, '../recorder/ramdisk/snapshots');
 const GO2RTC_API = 'http://127.0.0.1:1984/api/frame.jpeg';
+const GO2RTC_RTSP = 'rtsp://127.0.0.1:8554';
+// DSS_NATIVE_INGEST=1: analiza continua in proces pe restream-ul RTSP (libmotionfilter + libav);
+// snapshot-ul pe ramdisk ramane doar ca preview, la rata redusa
+const NATIVE_INGEST = process.env.DSS_NATIVE_INGEST === '1';
+const NATIVE_INGEST_FPS = parseFloat(process.env.DSS_NATIVE_INGEST_FPS || '5');
+const PREVIEW_INTERVAL_MS = 5000;
+// Ingest-ul nativ care nu ajunge RUNNING (reconectare, URL gresit) in atatea ms:
+// analiza revine pe snapshot-uri (1 FPS) pana cand stream-ul ruleaza din nou
+const NATIVE_STALL_MS = 5000;
+// IngestState din native/stream_ingest.h
+const INGEST_RUNNING = 2;
 
 class DecoderManager {
     constructor() {
@@ -23,15 +34,45 @@ class DecoderManager {
     startDecoder(cam) {
         if (this.timers.has(cam.id)) return;
 
-        console.log(`[Decoder] Starting snapshot poller for ${cam.id}`);
+        const native = NATIVE_INGEST &&
+            aiRouter.startStreamIngest(cam.id, `${GO2RTC_RTSP}/${cam.id}_low`, NATIVE_INGEST_FPS);
+        console.log(`[Decoder] Starting ${native ? 'native stream ingest + preview' : 'snapshot'} poller for ${cam.id}`);
 
         // Poll immediately then interval
-        this.pollSnapshot(cam);
-        const timer = setInterval(() => this.pollSnapshot(cam), 1000); // 1000ms (1 FPS Analysis)
+        this.pollSnapshot(cam, !native);
+        const timer = native ? this.startNativeWatch(cam)
+            : setInterval(() => this.pollSnapshot(cam, true), 1000); // 1000ms (1 FPS Analysis)
         this.timers.set(cam.id, timer);
     }
 
-    pollSnapshot(cam) {
+    // Cu ingest nativ: preview la PREVIEW_INTERVAL_MS cat timp stream-ul ruleaza; daca sta in
+    // CONNECTING / STOPPED mai mult de NATIVE_STALL_MS, analiza trece pe snapshot-uri la 1 FPS
+    startNativeWatch(cam) {
+        let stalledSince = null;
+        let fallback = false;
+        let sincePreview = 0;
+        return setInterval(() => {
+            const now = Date.now();
+            if (aiRouter.getStreamIngestState(cam.id) === INGEST_RUNNING) stalledSince = null;
+            else if (stalledSince === null) stalledSince = now;
+
+            const stalled = stalledSince !== null && now - stalledSince > NATIVE_STALL_MS;
+            if (stalled !== fallback) {
+                fallback = stalled;
+                console.log(`[Decoder] ${cam.id}: native ingest ${fallback ? 'not running, snapshot analysis' : 'running again, preview only'}`);
+            }
+
+            sincePreview += 1000;
+            if (fallback) {
+                this.pollSnapshot(cam, true);
+            } else if (sincePreview >= PREVIEW_INTERVAL_MS) {
+                sincePreview = 0;
+                this.pollSnapshot(cam, false);
+            }
+        }, 1000);
+    }
+
+    pollSnapshot(cam, triggerAnalysis = true) {
         const url = `${GO2RTC_API}?src=${cam.id}`;
 
         http.get(url, (res) => {
@@ -49,6 +90,7 @@ class DecoderManager {
                     // Write file
                     if (params.length > 0) {
                         fs.writeFile(snapPath, params, () => {
+                            if (!triggerAnalysis) return;
                             // Trigger AI Analysis only for valid snapshots
                             try {
                                 aiRouter.handleMotion(cam.id).catch(err => { });
@@ -74,11 +116,13 @@ class DecoderManager {
             this.timers.delete(id);
             console.log(`[Decoder] Stopped poller for ${id}`);
         }
+        aiRouter.stopStreamIngest(id);
     }
 
     stopAll() {
         for (const [id, timer] of this.timers) {
             clearInterval(timer);
+            aiRouter.stopStreamIngest(id);
         }
         this.timers.clear();
     }
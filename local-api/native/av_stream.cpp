@@ -0,0 +1,169 @@
+#include "av_stream.h"
+#include <iostream>
+
+#ifdef DSS_ENABLE_LIBAV
+
+bool AvStreamReader::open(const std::string& url, const AvStreamOptions& opt) {
+    close();
+
+    AVDictionary* fmtOpts = nullptr;
+    if (url.rfind("rtsp://", 0) == 0) {
+        if (opt.rtspTcp) av_dict_set(&fmtOpts, "rtsp_transport", "tcp", 0);
+        // RTSP socket timeout, microseconds
+        av_dict_set(&fmtOpts, "timeout", std::to_string((long long)opt.openTimeoutMs * 1000).c_str(), 0);
+    }
+
+    int r = avformat_open_input(&fmt, url.c_str(), nullptr, &fmtOpts);
+    av_dict_free(&fmtOpts);
+    if (r < 0) {
+        std::cerr << "[LibAV] Cannot open " << url << " (" << r << ")" << std::endl;
+        fmt = nullptr;
+        return false;
+    }
+    if (avformat_find_stream_info(fmt, nullptr) < 0) {
+        std::cerr << "[LibAV] No stream info: " << url << std::endl;
+        close();
+        return false;
+    }
+
+    videoIndex = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (videoIndex < 0) {
+        std::cerr << "[LibAV] No video stream: " << url << std::endl;
+        close();
+        return false;
+    }
+    AVStream* st = fmt->streams[videoIndex];
+    const AVCodec* codec = avcodec_find_decoder(st->codecpar->codec_id);
+    if (!codec) {
+        std::cerr << "[LibAV] No decoder for " << url << std::endl;
+        close();
+        return false;
+    }
+
+    dec = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(dec, st->codecpar);
+    dec->thread_count = opt.decoderThreads > 0 ? opt.decoderThreads : 1;
+    dec->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    dec->pkt_timebase = st->time_base;
+
+    AVDictionary* decOpts = nullptr;
+    if (opt.exportMotionVectors) av_dict_set(&decOpts, "flags2", "+export_mvs", 0);
+    r = avcodec_open2(dec, codec, &decOpts);
+    av_dict_free(&decOpts);
+    if (r < 0) {
+        std::cerr << "[LibAV] Cannot open decoder for " << url << std::endl;
+        close();
+        return false;
+    }
+
+    pkt = av_packet_alloc();
+    frm = av_frame_alloc();
+    draining = false;
+    frameSize = cv::Size(dec->width, dec->height);
+    codecIdValue = (int)codec->id;
+    decoderName = codec->name;
+    AVRational fr = st->avg_frame_rate.num > 0 ? st->avg_frame_rate : st->r_frame_rate;
+    fps = fr.num > 0 && fr.den > 0 ? av_q2d(fr) : 0.0;
+    return true;
+}
+
+void AvStreamReader::close() {
+    if (frm) av_frame_free(&frm);
+    if (pkt) av_packet_free(&pkt);
+    if (dec) avcodec_free_context(&dec);
+    if (fmt) avformat_close_input(&fmt);
+    codecIdValue = 0;
+    decoderName.clear();
+    videoIndex = -1;
+    draining = false;
+}
+
+bool AvStreamReader::isOpen() const {
+    return dec != nullptr;
+}
+
+int AvStreamReader::next(AVFrame*& frame) {
+    frame = nullptr;
+    if (!dec) return AVERROR(EINVAL);
+
+    for (;;) {
+        int r = avcodec_receive_frame(dec, frm);
+        if (r == 0) {
+            frame = frm;
+            return 0;
+        }
+        if (r == AVERROR_EOF) return 1;
+        if (r != AVERROR(EAGAIN)) return r;
+        if (draining) return 1;
+
+        r = av_read_frame(fmt, pkt);
+        if (r < 0) {
+            // EOF or network error: flush the frames still inside the decoder
+            draining = true;
+            avcodec_send_packet(dec, nullptr);
+            continue;
+        }
+        if (pkt->stream_index == videoIndex) {
+            r = avcodec_send_packet(dec, pkt);
+            // Pachete corupte (pierderi RTSP): le sarim, decoderul se resincronizeaza
+            if (r < 0 && r != AVERROR(EAGAIN) && r != AVERROR_INVALIDDATA) {
+                av_packet_unref(pkt);
+                return r;
+            }
+        }
+        av_packet_unref(pkt);
+    }
+}
+
+double AvStreamReader::frameTimeSec(const AVFrame* frame) const {
+    if (!frame || !fmt || videoIndex < 0) return -1.0;
+    int64_t ts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+    if (ts == AV_NOPTS_VALUE) return -1.0;
+    return ts * av_q2d(fmt->streams[videoIndex]->time_base);
+}
+
+bool wrapAvFrame(const AVFrame* frame, cv::Mat& luma, RawYuvPlanes& yuv) {
+    if (!frame || !frame->data[0]) return false;
+    const AVPixelFormat pf = (AVPixelFormat)frame->format;
+    if (pf != AV_PIX_FMT_YUV420P && pf != AV_PIX_FMT_YUVJ420P && pf != AV_PIX_FMT_NV12) return false;
+
+    luma = cv::Mat(frame->height, frame->width, CV_8UC1, frame->data[0], (size_t)frame->linesize[0]);
+    yuv.y = frame->data[0];
+    yuv.strideY = frame->linesize[0];
+    yuv.width = frame->width;
+    yuv.height = frame->height;
+    yuv.nv12 = pf == AV_PIX_FMT_NV12;
+    yuv.u = frame->data[1];
+    yuv.v = yuv.nv12 ? nullptr : frame->data[2];
+    // libav poate avea stride-uri diferite pe U si V doar teoretic; pentru 4:2:0 sunt egale
+    yuv.strideUV = frame->linesize[1];
+    return true;
+}
+
+#else
+
+bool wrapAvFrame(const AVFrame*, cv::Mat&, RawYuvPlanes&) {
+    return false;
+}
+
+bool AvStreamReader::open(const std::string& url, const AvStreamOptions&) {
+    std::cerr << "[LibAV] Not compiled in binary, cannot open " << url << std::endl;
+    return false;
+}
+
+void AvStreamReader::close() {}
+
+bool AvStreamReader::isOpen() const {
+    return false;
+}
+
+int AvStreamReader::next(AVFrame*& frame) {
+    frame = nullptr;
+    return -1;
+}
+
+double AvStreamReader::frameTimeSec(const AVFrame*) const {
+    return -1.0;
+}
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "raw_frame.h"
+
+#ifdef DSS_ENABLE_LIBAV
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+}
+#else
+struct AVFrame;
+#endif
+
+struct AvStreamOptions {
+    bool exportMotionVectors = false; // flags2 +export_mvs (H.264 / MPEG-4 / MPEG-1/2 / H.263 decoders only)
+    int decoderThreads = 1;           // 1 = no frame-threading delay
+    bool rtspTcp = true;
+    int openTimeoutMs = 5000;
+};
+
+// Cititor libavformat + libavcodec pentru un singur stream video
+// (RTSP, fisier .mp4 al recorderului, orice URL suportat de FFmpeg).
+// Fara DSS_ENABLE_LIBAV clasa exista, dar open() esueaza.
+class AvStreamReader {
+public:
+    AvStreamReader() = default;
+    AvStreamReader(const AvStreamReader&) = delete;
+    AvStreamReader& operator=(const AvStreamReader&) = delete;
+    ~AvStreamReader() { close(); }
+
+    bool open(const std::string& url, const AvStreamOptions& opt = AvStreamOptions());
+    void close();
+    bool isOpen() const;
+
+    // Next decoded video frame, owned by the reader and valid until the next call.
+    // Returns 0 = frame, 1 = end of stream, < 0 = error (AVERROR code).
+    int next(AVFrame*& frame);
+
+    cv::Size size() const { return frameSize; }
+    // Presentation time of `frame` in seconds (stream time base), -1 if unknown
+    double frameTimeSec(const AVFrame* frame) const;
+    // Nominal stream frame rate, 0 if unknown
+    double frameRate() const { return fps; }
+    // AVCodecID of the video stream (0 before open) and the decoder name
+    int codecId() const { return codecIdValue; }
+    const std::string& codecName() const { return decoderName; }
+
+private:
+    cv::Size frameSize;
+    double fps = 0.0;
+    int codecIdValue = 0;
+    std::string decoderName;
+#ifdef DSS_ENABLE_LIBAV
+    AVFormatContext* fmt = nullptr;
+    AVCodecContext* dec = nullptr;
+    AVPacket* pkt = nullptr;
+    AVFrame* frm = nullptr;
+    int videoIndex = -1;
+    bool draining = false;
+#endif
+};
+
+// Views over a decoded frame, no copy: luma as 8UC1 and, for 4:2:0 formats
+// (yuv420p, yuvj420p, nv12), the planes for direct ROI encoding.
+// False for any other pixel format.
+bool wrapAvFrame(const AVFrame* frame, cv::Mat& luma, RawYuvPlanes& yuv);
@@ -0,0 +1,160 @@
+#include "batch_processor.h"
+#include "jpeg_decode.h"
+#include "stripe_pool.h"
+#include <iostream>
+
+FrameBatchProcessor& FrameBatchProcessor::instance() {
+    static FrameBatchProcessor pool;
+    return pool;
+}
+
+FrameBatchProcessor::FrameBatchProcessor() {
+    // Acelasi buget ca workerii de benzi (stripe_pool.h): DSS_MOTION_THREADS sau nucleele
+    const unsigned n = (unsigned)motionThreadBudget();
+
+    workers.reserve(n);
+    for (unsigned i = 0; i < n; ++i) {
+        workers.emplace_back(&FrameBatchProcessor::workerLoop, this);
+    }
+    std::cout << "[BatchPool] Started " << n << " motion workers" << std::endl;
+}
+
+FrameBatchProcessor::~FrameBatchProcessor() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cvWork.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+int FrameBatchProcessor::submit(MotionDetector** detectors, const char** imagePaths, int count) {
+    if (!detectors || !imagePaths || count <= 0) return -1;
+
+    auto batch = std::make_shared<Batch>();
+    batch->results.assign(count, 0);
+    batch->remaining.store(count, std::memory_order_relaxed);
+
+    int id;
+    int wakeups = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        id = nextBatchId++;
+        if (nextBatchId <= 0) nextBatchId = 1; // wrap-around
+        batches[id] = batch;
+
+        for (int i = 0; i < count; ++i) {
+            MotionDetector* det = detectors[i];
+            if (!det || !imagePaths[i]) {
+                // Nothing to run, count it as done with "no motion"
+                batch->remaining.fetch_sub(1, std::memory_order_release);
+                continue;
+            }
+
+            auto& slot = strands[det];
+            if (!slot) {
+                slot = std::make_unique<Strand>();
+                slot->detector = det;
+            }
+            slot->jobs.push_back({batch, i, imagePaths[i]});
+            if (!slot->scheduled) {
+                slot->scheduled = true;
+                readyQueue.push_back(slot.get());
+                ++wakeups;
+            }
+        }
+    }
+
+    if (wakeups == 1) cvWork.notify_one();
+    else if (wakeups > 1) cvWork.notify_all();
+    return id;
+}
+
+int FrameBatchProcessor::poll(int batchId, int* results, int count) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = batches.find(batchId);
+    if (it == batches.end()) return -1;
+
+    Batch& b = *it->second;
+    if (b.remaining.load(std::memory_order_acquire) != 0) return 0;
+
+    if (results) {
+        int n = std::min(count, (int)b.results.size());
+        for (int i = 0; i < n; ++i) results[i] = b.results[i];
+    }
+    batches.erase(it);
+    return 1;
+}
+
+void FrameBatchProcessor::drain(MotionDetector* detector) {
+    std::unique_lock<std::mutex> lock(mtx);
+    auto it = strands.find(detector);
+    if (it == strands.end()) return;
+
+    Strand* s = it->second.get();
+    cvIdle.wait(lock, [s] { return !s->scheduled && s->jobs.empty(); });
+    strands.erase(detector);
+}
+
+int FrameBatchProcessor::runJob(MotionDetector* detector, const Job& job) {
+    // Buffer per worker thread, refolosit intre cadre
+    static thread_local std::vector<uint8_t> fileBuf;
+    uint64_t t0 = motionNowUs();
+    cv::Mat frame;
+    if (readFileBytes(job.imagePath.c_str(), fileBuf)) {
+        frame = decodeAnalysisFrame(fileBuf.data(), fileBuf.size(), detector->getAnalysisSize());
+    }
+    detector->stats().addStage(STAGE_DECODE, motionNowUs() - t0);
+    if (frame.empty()) {
+        detector->stats().add(STAT_SKIPPED_FRAMES, 1);
+        return 0;
+    }
+
+    auto lock = detector->lockFrame();
+    const std::vector<int>& validSlots = detector->processFrameLocked(frame);
+    return validSlots.empty() ? 0 : 1;
+}
+
+void FrameBatchProcessor::workerLoop() {
+    for (;;) {
+        Strand* s = nullptr;
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvWork.wait(lock, [this] { return stopping || !readyQueue.empty(); });
+            if (stopping && readyQueue.empty()) return;
+
+            s = readyQueue.front();
+            readyQueue.pop_front();
+            job = std::move(s->jobs.front());
+            s->jobs.pop_front();
+        }
+
+        // Strand-ul e marcat "scheduled", deci niciun alt worker nu atinge acest detector
+        int res = 0;
+        try {
+            MotionThreadScope busy;
+            res = runJob(s->detector, job);
+        } catch (const std::exception& e) {
+            std::cerr << "[BatchPool] Frame failed: " << e.what() << std::endl;
+        }
+        job.batch->results[job.index] = res;
+        job.batch->remaining.fetch_sub(1, std::memory_order_release);
+
+        bool requeued = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!s->jobs.empty()) {
+                // Back of the queue, so one busy camera can't starve the others
+                readyQueue.push_back(s);
+                requeued = true;
+            } else {
+                s->scheduled = false;
+            }
+        }
+        if (requeued) cvWork.notify_one();
+        else cvIdle.notify_all();
+    }
+}
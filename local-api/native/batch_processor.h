@@ -0,0 +1,66 @@
+#pragma once
+#include "motion_detector.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Pool de workeri nativi pentru procesarea mai multor camere in paralel.
+// Fiecare detector are propria coada (strand): cadrele aceleiasi camere
+// se proceseaza strict in ordinea trimiterii, camere diferite in paralel.
+class FrameBatchProcessor {
+public:
+    static FrameBatchProcessor& instance();
+
+    // Returns batch id (> 0) or -1 on invalid input
+    int submit(MotionDetector** detectors, const char** imagePaths, int count);
+
+    // 1 = done (results copied, batch released), 0 = pending, -1 = unknown id
+    int poll(int batchId, int* results, int count);
+
+    // Blocks until all queued frames for this detector are processed
+    void drain(MotionDetector* detector);
+
+    int workerCount() const { return (int)workers.size(); }
+
+private:
+    struct Batch {
+        std::vector<int> results;
+        std::atomic<int> remaining{0};
+    };
+
+    struct Job {
+        std::shared_ptr<Batch> batch;
+        int index;
+        std::string imagePath;
+    };
+
+    struct Strand {
+        MotionDetector* detector = nullptr;
+        std::deque<Job> jobs;
+        bool scheduled = false; // in readyQueue or running on a worker
+    };
+
+    FrameBatchProcessor();
+    ~FrameBatchProcessor();
+    FrameBatchProcessor(const FrameBatchProcessor&) = delete;
+    FrameBatchProcessor& operator=(const FrameBatchProcessor&) = delete;
+
+    void workerLoop();
+    static int runJob(MotionDetector* detector, const Job& job);
+
+    std::mutex mtx;
+    std::condition_variable cvWork;
+    std::condition_variable cvIdle;
+    std::deque<Strand*> readyQueue;
+    std::unordered_map<MotionDetector*, std::unique_ptr<Strand>> strands;
+    std::unordered_map<int, std::shared_ptr<Batch>> batches;
+    int nextBatchId = 1;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
@@ -0,0 +1,479 @@
+// Micro-benchmark pe etape pentru libmotionfilter.
+//
+// Scene sintetice deterministe (zgomot static + N dreptunghiuri in miscare, seed fix)
+// la 360p, 1080p, 4MP si 8MP. Fiecare etapa e masurata izolat, pe aceleasi cadre:
+//   detect_motion   MaskBackend CPU (kernel fuzionat + block gate), ca MotionDetector::detectMotion
+//   excluded_zones  MotionDetector::applyExcludedZones
+//   extract_blobs   BlobLabeler::label (labelStriped peste --parallel-min-px, ca MotionDetector)
+//   tracker_update  MotionTracker::update
+//   crop_roi        cropROI pe fiecare track valid
+//   encode_jpeg     encodeJPEG pe fiecare ROI
+//   process_frame   MotionDetector::processFrame complet (cu reducerea la latimea de analiza)
+//
+// Iesire: o linie JSON per (scena, bloburi, etapa) cu ns/cadru, alocari/cadru,
+// octeti alocati/cadru si octeti atinsi/cadru (model analitic al etapei, nu contor hardware).
+// Cu --baseline, iesirea e comparata cu o rulare salvata; exit 1 la regresie.
+//
+//   motion_bench [--frames N] [--blobs 1,8,32] [--scenes 360p,1080p,4mp]
+//                [--analysis-width 640] [--threads 1] [--out file]
+//                [--baseline file] [--max-regress 10] [--parallel-min-px 0]
+//
+// --parallel-min-px activeaza benzile paralele (StripePool) de la acel numar de pixeli;
+// implicit 0 (totul pe un fir, cifre stabile). Ex: --scenes 4mp,8mp --parallel-min-px 4000000
+
+#include "../motion_detector.h"
+#include "../mask_backend.h"
+#include "../blob_labeler.h"
+#include "../stripe_pool.h"
+#include "../tracker.h"
+#include "../roi_crop.h"
+#include "../jpeg_encode.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// --- Contor de alocari -------------------------------------------------------------
+// Interpunere malloc peste glibc: prinde si alocarile din OpenCV / libjpeg-turbo,
+// nu doar operator new din codul nostru. Pe alte libc-uri contoarele raman 0.
+static std::atomic<uint64_t> gAllocCount{0};
+static std::atomic<uint64_t> gAllocBytes{0};
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void __libc_free(void*);
+
+void* malloc(size_t n) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    return __libc_malloc(n);
+}
+void* calloc(size_t n, size_t size) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(n * size, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+void* realloc(void* p, size_t n) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    return __libc_realloc(p, n);
+}
+int posix_memalign(void** out, size_t align, size_t n) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    void* p = __libc_memalign(align, n);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+void* aligned_alloc(size_t align, size_t n) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    return __libc_memalign(align, n);
+}
+void free(void* p) {
+    __libc_free(p);
+}
+}
+#endif
+
+// --- Masuratoare -------------------------------------------------------------------
+
+struct StageTotals {
+    uint64_t ns = 0;
+    uint64_t allocs = 0;
+    uint64_t allocBytes = 0;
+    uint64_t touched = 0;
+    uint64_t frames = 0;
+};
+
+class StageTimer {
+public:
+    explicit StageTimer(StageTotals& t)
+        : totals(t),
+          allocs0(gAllocCount.load(std::memory_order_relaxed)),
+          bytes0(gAllocBytes.load(std::memory_order_relaxed)),
+          t0(std::chrono::steady_clock::now()) {}
+
+    // touched: bytes read + written by the stage (model)
+    void stop(uint64_t touched) {
+        auto t1 = std::chrono::steady_clock::now();
+        totals.ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        totals.allocs += gAllocCount.load(std::memory_order_relaxed) - allocs0;
+        totals.allocBytes += gAllocBytes.load(std::memory_order_relaxed) - bytes0;
+        totals.touched += touched;
+        totals.frames++;
+    }
+
+private:
+    StageTotals& totals;
+    uint64_t allocs0, bytes0;
+    std::chrono::steady_clock::time_point t0;
+};
+
+// --- Scene sintetice ---------------------------------------------------------------
+
+struct SceneSpec {
+    const char* name;
+    cv::Size size;
+};
+
+static const SceneSpec kScenes[] = {
+    {"360p", cv::Size(640, 360)},
+    {"1080p", cv::Size(1920, 1080)},
+    {"4mp", cv::Size(2688, 1520)},
+    {"8mp", cv::Size(3840, 2160)},
+};
+
+struct MovingBlob {
+    cv::Rect rect;
+    int dx, dy;
+};
+
+// Fundal cu zgomot fix + bloburi care se misca liniar si ricoseaza de margini.
+// Totul deriva din seed, deci aceleasi cadre la fiecare rulare.
+class SyntheticScene {
+public:
+    SyntheticScene(cv::Size size, int blobCount, uint64_t seed = 0x5eed) : rng(seed) {
+        base.create(size, CV_8UC3);
+        cv::randu(base, cv::Scalar(90, 90, 90), cv::Scalar(140, 140, 140));
+
+        const int side = std::max(8, size.width / 24);
+        for (int i = 0; i < blobCount; ++i) {
+            MovingBlob b;
+            b.rect = cv::Rect(rng.uniform(0, size.width - side), rng.uniform(0, size.height - side), side, side);
+            b.dx = rng.uniform(2, std::max(3, side / 4));
+            b.dy = rng.uniform(-side / 8, side / 8 + 1);
+            blobs.push_back(b);
+        }
+    }
+
+    // Renders the next frame into `out` (outside of the timed regions)
+    void next(cv::Mat& out) {
+        base.copyTo(out);
+        for (MovingBlob& b : blobs) {
+            cv::rectangle(out, b.rect, cv::Scalar(230, 230, 230), -1);
+            b.rect.x += b.dx;
+            b.rect.y += b.dy;
+            if (b.rect.x < 0 || b.rect.x + b.rect.width > base.cols) {
+                b.dx = -b.dx;
+                b.rect.x = std::clamp(b.rect.x, 0, base.cols - b.rect.width);
+            }
+            if (b.rect.y < 0 || b.rect.y + b.rect.height > base.rows) {
+                b.dy = -b.dy;
+                b.rect.y = std::clamp(b.rect.y, 0, base.rows - b.rect.height);
+            }
+        }
+    }
+
+private:
+    cv::RNG rng;
+    cv::Mat base;
+    std::vector<MovingBlob> blobs;
+};
+
+// Config comun: arie minima mica (bloburile sintetice trebuie sa treaca filtrul la 4MP)
+// si doua zone excluse in colturi, ca applyExcludedZones sa aiba de lucru
+static CameraConfig benchConfig(cv::Size size, int parallelMinPixels) {
+    CameraConfig cfg;
+    cfg.parallelMinPixels = parallelMinPixels;
+    cfg.minAreaRatio = 0.0005;
+    cfg.minFrames = 3;
+    cfg.excludedZones.push_back({cv::Rect(0, 0, size.width / 8, size.height / 8)});
+    cfg.excludedZones.push_back({cv::Rect(size.width * 7 / 8, size.height * 7 / 8, size.width / 8, size.height / 8)});
+    return cfg;
+}
+
+static uint64_t zoneArea(const std::vector<ExcludedZone>& zones, cv::Size size) {
+    uint64_t a = 0;
+    for (const ExcludedZone& z : zones) a += (uint64_t)(z.zone & cv::Rect(0, 0, size.width, size.height)).area();
+    return a;
+}
+
+// Frame in, Q8 background read + write, mask written
+static uint64_t maskBytes(cv::Size size, size_t elemSize) {
+    const uint64_t px = (uint64_t)size.area();
+    return px * elemSize + px * 2 * sizeof(uint16_t) + px;
+}
+
+// --- Rulare ------------------------------------------------------------------------
+
+struct Options {
+    int frames = 200;
+    int warmup = 10;
+    std::vector<int> blobCounts{1, 8, 32};
+    std::vector<std::string> scenes{"360p", "1080p", "4mp"};
+    int analysisWidth = 640;
+    int threads = 1;
+    std::string out;
+    std::string baseline;
+    double maxRegressPct = 10.0;
+    int parallelMinPixels = 0;
+};
+
+struct Result {
+    std::string scene;
+    int blobs;
+    std::string stage;
+    double nsPerFrame, allocsPerFrame, allocBytesPerFrame, touchedPerFrame;
+
+    std::string key() const { return scene + "/" + std::to_string(blobs) + "/" + stage; }
+};
+
+static const char* kStageNames[] = {
+    "detect_motion", "excluded_zones", "extract_blobs", "tracker_update", "crop_roi", "encode_jpeg", "process_frame",
+};
+enum { ST_MASK, ST_ZONES, ST_BLOBS, ST_TRACK, ST_CROP, ST_ENCODE, ST_PROCESS, ST_COUNT };
+
+static void runScene(const SceneSpec& spec, int blobCount, const Options& opt, std::vector<Result>& results) {
+    StageTotals totals[ST_COUNT];
+    const CameraConfig cfg = benchConfig(spec.size, opt.parallelMinPixels);
+    const bool striped = cfg.parallelMinPixels > 0 && (int64_t)spec.size.area() >= cfg.parallelMinPixels;
+    cv::Mat frame;
+
+    // Etapele izolate, in ordinea din MotionDetector, la rezolutia scenei
+    {
+        SyntheticScene scene(spec.size, blobCount);
+        CpuMaskBackend mask;
+        BlobLabeler labeler;
+        MotionTracker tracker;
+        cv::Mat motionMask;
+        std::vector<MotionBlob> blobs;
+        std::vector<cv::Rect> smooth(kMaxTracks);
+        std::vector<cv::Mat> rois;
+        std::vector<uchar> jpeg;
+        StageTotals discard[ST_COUNT];
+        const int minArea = std::max(1, (int)std::ceil(cfg.minAreaRatio * spec.size.area()));
+
+        for (int i = 0; i < opt.warmup + opt.frames; ++i) {
+            StageTotals* t = i < opt.warmup ? discard : totals;
+            scene.next(frame);
+
+            StageTimer tm(t[ST_MASK]);
+            bool active = mask.computeMask(frame, cfg, motionMask);
+            tm.stop(maskBytes(frame.size(), frame.elemSize()));
+
+            StageTimer tz(t[ST_ZONES]);
+            if (active) MotionDetector::applyExcludedZones(motionMask, cfg.excludedZones);
+            tz.stop(active ? zoneArea(cfg.excludedZones, spec.size) : 0);
+
+            StageTimer tb(t[ST_BLOBS]);
+            blobs.clear();
+            if (active && striped) {
+                labeler.labelStriped(motionMask, minArea, blobs,
+                                     parallelStripeCount(motionMask.rows, (int64_t)motionMask.total()));
+            } else if (active) {
+                labeler.label(motionMask, minArea, blobs);
+            }
+            tb.stop(active ? motionMask.total() + blobs.size() * sizeof(MotionBlob) : 0);
+
+            StageTimer tt(t[ST_TRACK]);
+            const std::vector<int>& valid = tracker.update(blobs, spec.size, cfg);
+            tt.stop(blobs.size() * sizeof(MotionBlob) + (uint64_t)tracker.tracks().size() * sizeof(CentroidRing));
+
+            const TrackTable& tracks = tracker.tracks();
+            StageTimer tc(t[ST_CROP]);
+            rois.clear();
+            for (int slot : valid) {
+                rois.push_back(cropROI(frame, tracks.bbox[slot], cfg.roiPadding, smooth[slot]));
+            }
+            tc.stop(rois.size() * sizeof(cv::Rect) * 2); // view only, no pixels copied
+
+            uint64_t encoded = 0;
+            StageTimer te(t[ST_ENCODE]);
+            for (const cv::Mat& roi : rois) {
+                if (encodeJPEG(roi, jpeg)) encoded += roi.total() * roi.elemSize() + jpeg.size();
+            }
+            te.stop(encoded);
+        }
+    }
+
+    // Pipeline complet, ca in productie: reducere la latimea de analiza + toate etapele
+    {
+        SyntheticScene scene(spec.size, blobCount);
+        MotionDetector detector(cfg, spec.size, EngineKind::Cpu);
+        if (opt.analysisWidth > 0) {
+            detector.setAnalysisSize(cv::Size(opt.analysisWidth, opt.analysisWidth * spec.size.height / spec.size.width));
+        }
+        StageTotals discard;
+        for (int i = 0; i < opt.warmup + opt.frames; ++i) {
+            scene.next(frame);
+            StageTimer tp(i < opt.warmup ? discard : totals[ST_PROCESS]);
+            detector.processFrame(frame);
+            const double s = detector.sourceScale();
+            const cv::Size analysis((int)std::lround(frame.cols / s), (int)std::lround(frame.rows / s));
+            const uint64_t pyramid = s > 1.0 ? frame.total() * frame.elemSize() : 0;
+            tp.stop(pyramid + maskBytes(analysis, frame.elemSize()) + (uint64_t)analysis.area());
+        }
+    }
+
+    for (int s = 0; s < ST_COUNT; ++s) {
+        const StageTotals& t = totals[s];
+        const double n = (double)std::max<uint64_t>(1, t.frames);
+        results.push_back({spec.name, blobCount, kStageNames[s],
+                           t.ns / n, t.allocs / n, t.allocBytes / n, t.touched / n});
+    }
+}
+
+// --- Baseline ----------------------------------------------------------------------
+
+static std::string toJson(const Result& r) {
+    std::ostringstream o;
+    o.setf(std::ios::fixed);
+    o.precision(1);
+    o << "{\"scene\":\"" << r.scene << "\",\"blobs\":" << r.blobs << ",\"stage\":\"" << r.stage
+      << "\",\"ns_per_frame\":" << r.nsPerFrame << ",\"allocs_per_frame\":" << r.allocsPerFrame
+      << ",\"alloc_bytes_per_frame\":" << r.allocBytesPerFrame
+      << ",\"bytes_touched_per_frame\":" << r.touchedPerFrame << "}";
+    return o.str();
+}
+
+// Minimal reader for our own output format (flat objects, one per line)
+static std::string jsonField(const std::string& line, const char* name) {
+    const std::string key = std::string("\"") + name + "\":";
+    size_t p = line.find(key);
+    if (p == std::string::npos) return "";
+    p += key.size();
+    if (p < line.size() && line[p] == '"') {
+        size_t e = line.find('"', p + 1);
+        return e == std::string::npos ? "" : line.substr(p + 1, e - p - 1);
+    }
+    size_t e = line.find_first_of(",}", p);
+    return line.substr(p, e == std::string::npos ? std::string::npos : e - p);
+}
+
+static bool loadBaseline(const std::string& path, std::map<std::string, Result>& out) {
+    std::ifstream f(path);
+    if (!f) return false;
+    std::string line;
+    while (std::getline(f, line)) {
+        Result r;
+        r.scene = jsonField(line, "scene");
+        r.stage = jsonField(line, "stage");
+        std::string blobs = jsonField(line, "blobs");
+        if (r.scene.empty() || r.stage.empty() || blobs.empty()) continue;
+        r.blobs = std::atoi(blobs.c_str());
+        r.nsPerFrame = std::atof(jsonField(line, "ns_per_frame").c_str());
+        r.allocsPerFrame = std::atof(jsonField(line, "allocs_per_frame").c_str());
+        r.allocBytesPerFrame = std::atof(jsonField(line, "alloc_bytes_per_frame").c_str());
+        r.touchedPerFrame = std::atof(jsonField(line, "bytes_touched_per_frame").c_str());
+        out[r.key()] = r;
+    }
+    return true;
+}
+
+// Regresie: timp peste prag sau alocari noi in steady state (alocarile sunt deterministe)
+static int compareBaseline(const std::vector<Result>& results, const std::map<std::string, Result>& base,
+                           double maxRegressPct) {
+    int regressions = 0;
+    for (const Result& r : results) {
+        auto it = base.find(r.key());
+        if (it == base.end()) continue;
+        const Result& b = it->second;
+        const double deltaPct = b.nsPerFrame > 0.0 ? (r.nsPerFrame / b.nsPerFrame - 1.0) * 100.0 : 0.0;
+        const bool slower = deltaPct > maxRegressPct;
+        const bool moreAllocs = r.allocsPerFrame > b.allocsPerFrame + 0.5;
+        if (slower || moreAllocs) {
+            ++regressions;
+            std::cerr << "[Bench] REGRESSION " << r.key() << ": " << (long)b.nsPerFrame << " -> "
+                      << (long)r.nsPerFrame << " ns/frame (" << (deltaPct >= 0 ? "+" : "") << (int)deltaPct
+                      << "%), allocs " << b.allocsPerFrame << " -> " << r.allocsPerFrame << std::endl;
+        }
+    }
+    return regressions;
+}
+
+// --- main --------------------------------------------------------------------------
+
+static std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    std::istringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ',')) if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+static void usage() {
+    std::cerr << "usage: motion_bench [--frames N] [--blobs 1,8,32] [--scenes 360p,1080p,4mp]\n"
+                 "                    [--analysis-width 640] [--threads 1] [--out file]\n"
+                 "                    [--baseline file] [--max-regress 10] [--parallel-min-px 0]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) { usage(); return 2; }
+        if (a == "--frames") opt.frames = std::max(1, std::atoi(v));
+        else if (a == "--blobs") {
+            opt.blobCounts.clear();
+            for (const std::string& s : splitList(v)) opt.blobCounts.push_back(std::max(0, std::atoi(s.c_str())));
+        }
+        else if (a == "--scenes") opt.scenes = splitList(v);
+        else if (a == "--analysis-width") opt.analysisWidth = std::atoi(v);
+        else if (a == "--threads") opt.threads = std::atoi(v);
+        else if (a == "--out") opt.out = v;
+        else if (a == "--baseline") opt.baseline = v;
+        else if (a == "--max-regress") opt.maxRegressPct = std::atof(v);
+        else if (a == "--parallel-min-px") opt.parallelMinPixels = std::max(0, std::atoi(v));
+        else { usage(); return 2; }
+        ++i;
+    }
+
+    // Un singur fir implicit: cifre stabile, comparabile intre masini
+    cv::setNumThreads(opt.threads);
+
+    std::vector<Result> results;
+    for (const std::string& name : opt.scenes) {
+        const SceneSpec* spec = nullptr;
+        for (const SceneSpec& s : kScenes) if (name == s.name) spec = &s;
+        if (!spec) {
+            std::cerr << "[Bench] Unknown scene " << name << std::endl;
+            return 2;
+        }
+        for (int blobs : opt.blobCounts) {
+            std::cerr << "[Bench] " << spec->name << " " << spec->size.width << "x" << spec->size.height
+                      << ", " << blobs << " blobs, " << opt.frames << " frames" << std::endl;
+            runScene(*spec, blobs, opt, results);
+        }
+    }
+
+    std::ofstream file;
+    if (!opt.out.empty()) {
+        file.open(opt.out, std::ios::trunc);
+        if (!file) {
+            std::cerr << "[Bench] Cannot write " << opt.out << std::endl;
+            return 2;
+        }
+    }
+    std::ostream& out = opt.out.empty() ? std::cout : file;
+    for (const Result& r : results) out << toJson(r) << "\n";
+    out.flush();
+
+    if (!opt.baseline.empty()) {
+        std::map<std::string, Result> base;
+        if (!loadBaseline(opt.baseline, base)) {
+            std::cerr << "[Bench] Cannot read baseline " << opt.baseline << std::endl;
+            return 2;
+        }
+        int n = compareBaseline(results, base, opt.maxRegressPct);
+        std::cerr << "[Bench] " << n << " regression(s) vs " << opt.baseline
+                  << " (threshold " << opt.maxRegressPct << "%)" << std::endl;
+        return n > 0 ? 1 : 0;
+    }
+    return 0;
+}
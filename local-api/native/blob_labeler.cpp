@@ -0,0 +1,171 @@
+#include "blob_labeler.h"
+#include "stripe_pool.h"
+#include <algorithm>
+#include <cstring>
+
+int BlobLabeler::newLabel(int y, int x0, int x1) {
+    int l = (int)parent.size();
+    parent.push_back(l);
+
+    const int n = x1 - x0;
+    Stats s;
+    s.area = n;
+    s.sumX = (int64_t)(x0 + x1 - 1) * n / 2;
+    s.sumY = (int64_t)y * n;
+    s.minX = x0;
+    s.maxX = x1 - 1;
+    s.minY = s.maxY = y;
+    stats.push_back(s);
+    return l;
+}
+
+int BlobLabeler::find(int l) {
+    while (parent[l] != l) {
+        parent[l] = parent[parent[l]]; // path halving
+        l = parent[l];
+    }
+    return l;
+}
+
+void BlobLabeler::unite(int a, int b) {
+    int ra = find(a);
+    int rb = find(b);
+    if (ra == rb) return;
+    if (rb < ra) std::swap(ra, rb);
+    parent[rb] = ra;
+
+    Stats& d = stats[ra];
+    const Stats& s = stats[rb];
+    d.area += s.area;
+    d.sumX += s.sumX;
+    d.sumY += s.sumY;
+    d.minX = std::min(d.minX, s.minX);
+    d.maxX = std::max(d.maxX, s.maxX);
+    d.minY = std::min(d.minY, s.minY);
+    d.maxY = std::max(d.maxY, s.maxY);
+}
+
+static inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void BlobLabeler::reset() {
+    parent.clear();
+    stats.clear();
+    prevRuns.clear();
+    firstRuns.clear();
+    lastComponents = 0;
+}
+
+void BlobLabeler::scanRows(const cv::Mat& mask, int y0, int y1) {
+    const int W = mask.cols;
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* row = mask.ptr<uint8_t>(y);
+
+        // 1. Runs of non-zero pixels (sare peste 8 octeti deodata in zonele goale/pline)
+        curRuns.clear();
+        int x = 0;
+        while (x < W) {
+            while (x + 8 <= W && load64(row + x) == 0) x += 8;
+            while (x < W && !row[x]) ++x;
+            if (x >= W) break;
+            const int x0 = x;
+            while (x + 8 <= W && load64(row + x) == ~0ull) x += 8;
+            while (x < W && row[x]) ++x;
+            curRuns.push_back({x0, x, -1});
+        }
+
+        // 2. Connect with the previous row (8-connectivity: diagonal touch counts)
+        size_t j = 0;
+        for (Run& r : curRuns) {
+            while (j < prevRuns.size() && prevRuns[j].x1 < r.x0) ++j;
+            for (size_t k = j; k < prevRuns.size() && prevRuns[k].x0 <= r.x1; ++k) {
+                if (r.label < 0) {
+                    r.label = find(prevRuns[k].label);
+                    Stats& s = stats[r.label];
+                    const int n = r.x1 - r.x0;
+                    s.area += n;
+                    s.sumX += (int64_t)(r.x0 + r.x1 - 1) * n / 2;
+                    s.sumY += (int64_t)y * n;
+                    s.minX = std::min(s.minX, r.x0);
+                    s.maxX = std::max(s.maxX, r.x1 - 1);
+                    s.maxY = y;
+                } else {
+                    unite(r.label, prevRuns[k].label);
+                }
+            }
+            if (r.label < 0) r.label = newLabel(y, r.x0, r.x1);
+        }
+        if (y == y0) firstRuns = curRuns;
+        std::swap(prevRuns, curRuns);
+    }
+}
+
+void BlobLabeler::materialize(int minArea, std::vector<MotionBlob>& out, cv::Point offset) {
+    // Materialize only the roots that pass the area filter
+    for (int l = 0; l < (int)parent.size(); ++l) {
+        if (parent[l] != l) continue;
+        ++lastComponents;
+        const Stats& s = stats[l];
+        if (s.area < minArea) continue;
+
+        MotionBlob b;
+        b.bbox = cv::Rect(s.minX + offset.x, s.minY + offset.y, s.maxX - s.minX + 1, s.maxY - s.minY + 1);
+        b.area = (double)s.area;
+        b.centroid = cv::Point2f((float)((double)s.sumX / s.area) + offset.x,
+                                 (float)((double)s.sumY / s.area) + offset.y);
+        out.push_back(b);
+    }
+}
+
+void BlobLabeler::label(const cv::Mat& mask, int minArea, std::vector<MotionBlob>& out, cv::Point offset) {
+    reset();
+    if (mask.empty()) return;
+    scanRows(mask, 0, mask.rows);
+    materialize(minArea, out, offset);
+}
+
+void BlobLabeler::labelStriped(const cv::Mat& mask, int minArea, std::vector<MotionBlob>& out, int stripes,
+                               cv::Point offset) {
+    stripes = std::min(stripes, mask.rows);
+    if (stripes <= 1) {
+        label(mask, minArea, out, offset);
+        return;
+    }
+
+    if ((int)stripeParts.size() < stripes) stripeParts.resize(stripes);
+    StripePool::instance().run(stripes, [&](int i) {
+        BlobLabeler& part = stripeParts[i];
+        part.reset();
+        part.scanRows(mask, mask.rows * i / stripes, mask.rows * (i + 1) / stripes);
+    });
+
+    // Padurile de etichete se concateneaza (etichetele benzii i decalate cu base),
+    // apoi componentele taiate de granite se unesc ca in pasul 2 al scanarii
+    reset();
+    int prevBase = 0;
+    for (int i = 0; i < stripes; ++i) {
+        BlobLabeler& part = stripeParts[i];
+        const int base = (int)parent.size();
+        for (int l = 0; l < (int)part.parent.size(); ++l) {
+            parent.push_back(part.find(l) + base);
+        }
+        stats.insert(stats.end(), part.stats.begin(), part.stats.end());
+
+        if (i > 0) {
+            const std::vector<Run>& above = stripeParts[i - 1].prevRuns;
+            size_t j = 0;
+            for (const Run& r : part.firstRuns) {
+                while (j < above.size() && above[j].x1 < r.x0) ++j;
+                for (size_t k = j; k < above.size() && above[k].x0 <= r.x1; ++k) {
+                    unite(r.label + base, above[k].label + prevBase);
+                }
+            }
+        }
+        prevBase = base;
+    }
+
+    materialize(minArea, out, offset);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "motion_types.h"
+#include <cstdint>
+#include <vector>
+
+// Etichetare componente conexe (8-conectivitate) pe run-uri, intr-o singura trecere.
+// Inlocuieste findContours + boundingRect + contourArea: produce direct bbox,
+// aria in pixeli si centroidul real, fara vectori de puncte per blob.
+// Filtrul de arie minima se aplica inainte de materializare, deci fragmentele
+// mici (vant, ploaie) nu ajung niciodata in lista de bloburi.
+class BlobLabeler {
+public:
+    // Appends to `out` every component with at least `minArea` pixels.
+    // `offset` is added to the coordinates (mask may be a sub-view).
+    void label(const cv::Mat& mask, int minArea, std::vector<MotionBlob>& out,
+               cv::Point offset = cv::Point(0, 0));
+
+    // Same result as label(), the rows split into `stripes` horizontal stripes labeled in
+    // parallel on the StripePool; components cut by a stripe boundary are merged afterwards
+    // (8-connectivity between the last row of a stripe and the first row of the next one).
+    void labelStriped(const cv::Mat& mask, int minArea, std::vector<MotionBlob>& out, int stripes,
+                      cv::Point offset = cv::Point(0, 0));
+
+    // Components found by the last label() call, before the area filter
+    int lastComponentCount() const { return lastComponents; }
+
+private:
+    struct Run {
+        int x0, x1; // [x0, x1)
+        int label;
+    };
+
+    struct Stats {
+        int64_t sumX, sumY;
+        int area;
+        int minX, minY, maxX, maxY;
+    };
+
+    void reset();
+    // Labels rows [y0, y1) into parent/stats (absolute y). Leaves the runs of the first
+    // row in firstRuns and those of the last row in prevRuns.
+    void scanRows(const cv::Mat& mask, int y0, int y1);
+    // Appends the roots that pass the area filter
+    void materialize(int minArea, std::vector<MotionBlob>& out, cv::Point offset);
+
+    int newLabel(int y, int x0, int x1);
+    int find(int l);
+    void unite(int a, int b);
+
+    // Reused between frames, no allocation in steady state
+    std::vector<Run> prevRuns, curRuns, firstRuns;
+    std::vector<int> parent;
+    std::vector<Stats> stats;
+    int lastComponents = 0;
+    std::vector<BlobLabeler> stripeParts; // labelStriped(): one labeler per stripe
+};
@@ -0,0 +1,201 @@
+#include "block_gate.h"
+#include <algorithm>
+#include <cmath>
+
+void BlockActivityGate::reset() {
+    bw = bh = 0;
+    frameSize = cv::Size();
+    sig.clear();
+    ref.clear();
+    lag.clear();
+    catchUp.clear();
+    noise = 0.0;
+}
+
+double BlockActivityGate::margin() const {
+    return std::max(kMinMargin, kNoiseGain * noise);
+}
+
+void BlockActivityGate::computeSignature(const cv::Mat& frame) {
+    const int W = frame.cols;
+    const int H = frame.rows;
+    const int ch = frame.channels();
+    rowSums.resize(bw);
+
+    for (int by = 0; by < bh; ++by) {
+        const int y0 = by * kBlock;
+        const int y1 = std::min(H, y0 + kBlock);
+        std::fill(rowSums.begin(), rowSums.end(), 0u);
+
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* p = frame.ptr<uint8_t>(y);
+            for (int bx = 0; bx < bw; ++bx) {
+                const int x0 = bx * kBlock * ch;
+                const int x1 = std::min(W, (bx + 1) * kBlock) * ch;
+                uint32_t s = 0;
+                for (int i = x0; i < x1; ++i) s += p[i];
+                rowSums[bx] += s;
+            }
+        }
+
+        // BGR: media pe cele 3 canale, suficient ca semnatura de activitate
+        for (int bx = 0; bx < bw; ++bx) {
+            const int cw = std::min(W, (bx + 1) * kBlock) - bx * kBlock;
+            sig[by * bw + bx] = (float)rowSums[bx] / (float)(cw * (y1 - y0) * ch);
+        }
+    }
+}
+
+bool BlockActivityGate::analyse(const cv::Mat& frame, std::vector<GateRegion>& regions, double learningRate) {
+    regions.clear();
+    if (frame.empty()) return false;
+
+    // Aceeasi formula ca CpuMaskBackend::buildBlockAlpha, in virgula mobila
+    if (lagAlphaRate != learningRate || lagAlpha.empty()) {
+        const double a = std::clamp(learningRate, 0.0, 1.0);
+        lagAlpha.resize(kMaxLagFrames + 1);
+        for (int l = 0; l <= kMaxLagFrames; ++l) lagAlpha[l] = (float)(1.0 - std::pow(1.0 - a, l + 1));
+        lagAlphaRate = learningRate;
+    }
+
+    const cv::Rect full(0, 0, frame.cols, frame.rows);
+    if (ref.empty() || frame.size() != frameSize) {
+        // Seed: first frame (or new resolution) is processed in full. The reference starts
+        // from it: the background is re-initialised on this frame (or imported close to it)
+        frameSize = frame.size();
+        bw = (frame.cols + kBlock - 1) / kBlock;
+        bh = (frame.rows + kBlock - 1) / kBlock;
+        sig.assign((size_t)bw * bh, 0.f);
+        lag.assign((size_t)bw * bh, 0);
+        catchUp.assign((size_t)bw * bh, 0);
+        computeSignature(frame);
+        ref = sig;
+        noise = 0.0;
+        regions.push_back({full});
+        return true;
+    }
+
+    computeSignature(frame);
+
+    const int n = bw * bh;
+    const double m = margin();
+    dirty.assign(n, 0);
+    int dirtyCount = 0;
+    double quietSum = 0.0;
+    int quietCount = 0;
+    for (int i = 0; i < n; ++i) {
+        const double d = std::fabs((double)sig[i] - ref[i]);
+        if (d > m || lag[i] >= kMaxLagFrames) {
+            dirty[i] = d > m ? 1 : 2;
+            ++dirtyCount;
+        } else {
+            quietSum += d;
+            ++quietCount;
+        }
+    }
+    // Zgomotul (senzor, compresie) estimat doar din blocurile linistite
+    if (quietCount > 0) noise = 0.95 * noise + 0.05 * (quietSum / quietCount);
+
+    if (dirtyCount == 0) {
+        for (uint16_t& l : lag) l = (uint16_t)std::min<int>(l + 1, 0xFFFF);
+        return false;
+    }
+
+    if (dirtyCount > kFullFrameRatio * n) {
+        regions.push_back({full});
+    } else {
+        buildRegions(regions);
+    }
+
+    // Processed blocks: the reference follows the background update of the kernel
+    // (nominal rate with motion, catch-up when quiet); the rest fall one more frame behind
+    grown.assign(n, 0);
+    for (const GateRegion& r : regions) {
+        const int bx0 = r.rect.x / kBlock, by0 = r.rect.y / kBlock;
+        const int bx1 = (r.rect.x + r.rect.width + kBlock - 1) / kBlock;
+        const int by1 = (r.rect.y + r.rect.height + kBlock - 1) / kBlock;
+        for (int by = by0; by < by1; ++by) {
+            for (int bx = bx0; bx < bx1; ++bx) grown[by * bw + bx] = 1;
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        if (grown[i]) {
+            // Recuperarea doar pe blocurile linistite: pe cele cu miscare cadrul curent
+            // ar scrie obiectul in fundal cu rata de recuperare
+            catchUp[i] = dirty[i] == 1 ? 0 : lag[i];
+            ref[i] += lagAlpha[std::min<int>(catchUp[i], kMaxLagFrames)] * (sig[i] - ref[i]);
+            lag[i] = 0;
+        } else {
+            catchUp[i] = 0;
+            lag[i] = (uint16_t)std::min<int>(lag[i] + 1, 0xFFFF);
+        }
+    }
+    return true;
+}
+
+void BlockActivityGate::buildRegions(std::vector<GateRegion>& regions) {
+    const int n = bw * bh;
+
+    // 1. Dirty blocks + 1 block halo (blur radius 10 px, object edges)
+    grown.assign(n, 0);
+    for (int by = 0; by < bh; ++by) {
+        for (int bx = 0; bx < bw; ++bx) {
+            if (!dirty[by * bw + bx]) continue;
+            for (int y = std::max(0, by - 1); y <= std::min(bh - 1, by + 1); ++y) {
+                for (int x = std::max(0, bx - 1); x <= std::min(bw - 1, bx + 1); ++x) {
+                    grown[y * bw + x] = 1;
+                }
+            }
+        }
+    }
+
+    // 2. Bounding box (in blocks) of every 8-connected component
+    std::vector<cv::Rect>& boxes = blockBoxes;
+    boxes.clear();
+    for (int start = 0; start < n; ++start) {
+        if (grown[start] != 1) continue;
+        int x0 = bw, y0 = bh, x1 = -1, y1 = -1;
+        stack.clear();
+        stack.push_back(start);
+        grown[start] = 2;
+        while (!stack.empty()) {
+            const int i = stack.back();
+            stack.pop_back();
+            const int bx = i % bw, by = i / bw;
+            x0 = std::min(x0, bx); x1 = std::max(x1, bx);
+            y0 = std::min(y0, by); y1 = std::max(y1, by);
+            for (int y = std::max(0, by - 1); y <= std::min(bh - 1, by + 1); ++y) {
+                for (int x = std::max(0, bx - 1); x <= std::min(bw - 1, bx + 1); ++x) {
+                    const int j = y * bw + x;
+                    if (grown[j] == 1) {
+                        grown[j] = 2;
+                        stack.push_back(j);
+                    }
+                }
+            }
+        }
+        boxes.push_back(cv::Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1));
+    }
+
+    // 3. Boxes of different components can still overlap: merge until disjoint,
+    //    so no pixel of the background is updated twice in the same frame
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t a = 0; a < boxes.size() && !merged; ++a) {
+            for (size_t b = a + 1; b < boxes.size(); ++b) {
+                if ((boxes[a] & boxes[b]).area() > 0) {
+                    boxes[a] |= boxes[b];
+                    boxes.erase(boxes.begin() + b);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    const cv::Rect full(0, 0, frameSize.width, frameSize.height);
+    for (const cv::Rect& b : boxes) {
+        cv::Rect px(b.x * kBlock, b.y * kBlock, b.width * kBlock, b.height * kBlock);
+        regions.push_back({px & full});
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+// Pre-filtru ieftin pe blocuri 16x16, rulat inaintea kernelului de miscare.
+// Pastreaza media fiecarui bloc a fundalului (aceeasi medie mobila ca modelul pe pixeli,
+// cu aceleasi rate per bloc) si compara cadrul curent cu ea, nu cu cadrul anterior:
+// un obiect oprit ramane diferit de fundal, blocurile lui raman procesate si track-ul
+// nu se pierde (ca fara gate), pana cand fundalul il invata.
+//  - niciun bloc peste marja (adaptata la zgomot) -> cadrul e sarit complet
+//  - cateva blocuri -> pipeline-ul detaliat ruleaza doar pe regiunile murdare (+1 bloc halo)
+// Fundalul blocurilor sarite ramane in urma. Lag-ul se tine per bloc: un bloc reprocesat
+// care e linistit in cadrul curent (halo, refresh fortat) recupereaza update-ul intr-un
+// singur pas cu alpha efectiv 1 - (1 - a)^(lag + 1); un bloc cu miscare primeste rata
+// nominala (cadrul curent contine obiectul, nu scena de recuperat). Blocurile sarite de
+// prea mult timp sunt reprocesate fortat, deci eroarea fundalului ramane limitata.
+
+struct GateRegion {
+    cv::Rect rect;      // frame coordinates, block aligned
+};
+
+class BlockActivityGate {
+public:
+    static constexpr int kBlock = 16;
+    static constexpr int kMaxLagFrames = 50;     // forced refresh after this many skipped frames
+    static constexpr double kMinMargin = 2.0;    // gray levels of block mean
+    static constexpr double kNoiseGain = 4.0;    // margin = max(kMinMargin, kNoiseGain * noise)
+    static constexpr double kFullFrameRatio = 0.5; // above this dirty fraction run the whole frame
+
+    // Returns false when the frame can be skipped entirely. Otherwise `regions`
+    // holds non-overlapping areas to process. The first call (or a size change)
+    // returns one full-frame region: the caller seeds its background then.
+    // learningRate: the caller's background rate, mirrored on the block means.
+    bool analyse(const cv::Mat& frame, std::vector<GateRegion>& regions, double learningRate);
+
+    void reset();
+
+    // Valid after analyse() returned true, one entry per block (row-major, blockCols() per row):
+    // background frames to catch up in this frame. Non-zero only for processed blocks that are
+    // quiet in this frame; blocks with motion and skipped blocks get 0.
+    const std::vector<uint16_t>& catchUpFrames() const { return catchUp; }
+    int blockCols() const { return bw; }
+
+    double noiseLevel() const { return noise; }
+    double margin() const;
+
+private:
+    void computeSignature(const cv::Mat& frame);
+    void buildRegions(std::vector<GateRegion>& regions);
+
+    int bw = 0, bh = 0;             // grid size in blocks
+    cv::Size frameSize;
+    std::vector<float> sig;         // current block means
+    std::vector<float> ref;         // block means of the background model
+    std::vector<float> lagAlpha;    // 1 - (1 - a)^(lag + 1) per catch-up length
+    double lagAlphaRate = -1.0;
+    std::vector<uint16_t> lag;      // frames since the block was last processed
+    std::vector<uint16_t> catchUp;
+    std::vector<uint8_t> dirty;     // 1 = changed beyond the margin, 2 = forced refresh
+    std::vector<uint8_t> grown;     // dirty + 1 block halo
+    std::vector<int> stack;         // flood fill scratch
+    std::vector<cv::Rect> blockBoxes;
+    std::vector<uint32_t> rowSums;
+    double noise = 0.0;
+};
@@ -4,18 +4,25 @@ echo "Building Enterprise Motion Filter..."
 # Detectam daca putem compila CUDA (prezenta nvcc sau headers)
 # Pentru simplificare, verificam doar daca userul vrea (implicit OFF pe acest server Intel)
 ENABLE_CUDA=0
+# Motor pe vectori de miscare + ingestie stream (libavformat/libavcodec)
+ENABLE_LIBAV=0
 
-SRCS="motion_lib.cpp motion_detector.cpp opencl_engine.cpp cuda_engine.cpp"
+SRCS="motion_lib.cpp motion_detector.cpp batch_processor.cpp motion_kernel.cpp motion_kernel_simd.cpp blob_labeler.cpp block_gate.cpp global_change.cpp detector_state.cpp frame_ring.cpp stripe_pool.cpp tracker.cpp av_stream.cpp mv_engine.cpp stream_ingest.cpp engine_calibration.cpp mask_backend.cpp opencl_engine.cpp cuda_engine.cpp"
 
 # steaguri standard
-CXXFLAGS="-shared -fPIC -O3 -std=c++17"
+CXXFLAGS="-shared -fPIC -O3 -std=c++17 -pthread"
 INCLUDES="-I/usr/include/opencv4"
-LIBS="-lopencv_core -lopencv_imgproc -lopencv_highgui -lopencv_imgcodecs -lopencv_video" 
+LIBS="-lopencv_core -lopencv_imgproc -lopencv_highgui -lopencv_imgcodecs -lopencv_video -ljpeg -lturbojpeg -lrt" 
 # Adaugat opencv_video pentru MOG2 daca e cazul, sau unii algoritmi
 
 if [ "$ENABLE_CUDA" -eq "1" ]; then
     CXXFLAGS="$CXXFLAGS -DDSS_ENABLE_CUDA"
-    # LIBS need nvjpeg etc
+    LIBS="$LIBS -lopencv_cudaarithm -lopencv_cudafilters -lopencv_cudaimgproc"
+fi
+
+if [ "$ENABLE_LIBAV" -eq "1" ]; then
+    CXXFLAGS="$CXXFLAGS -DDSS_ENABLE_LIBAV"
+    LIBS="$LIBS -lavformat -lavcodec -lavutil"
 fi
 
 # Linkam si OpenCL (parte din opencv_core de obicei transparent, dar verificam)
@@ -32,5 +39,8 @@ else
     echo "BUILD FAILED"
 fi
 
+# Build complet + micro-benchmark: cmake -S . -B build && cmake --build build (vezi bench/motion_bench.cpp)
+# Teste: ctest --test-dir build (tests/)
+
 echo "Checking Koffi..."
 ls -d ../node_modules/koffi
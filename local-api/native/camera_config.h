@@ -3,7 +3,12 @@
 #include <vector>
 
 struct ExcludedZone {
-    cv::Rect zone; // pixeli
+    cv::Rect zone; // pixeli, in spatiul de analiza (vezi MotionDetector::getAnalysisSize)
+};
+
+enum class TrackerMode {
+    Greedy = 0,  // legacy: nearest centroid, track dropped on first miss
+    Global = 1   // prediction + gated global assignment + coasting
 };
 
 struct CameraConfig {
@@ -11,5 +16,17 @@ struct CameraConfig {
     int minFrames = 3;              // redus pt snapshot polling (3 frames @ 1s = 3s persistenta)
     double maxStaticVariance = 3.0; // Variance for static dynamic
     double roiPadding = 0.2;
+    int diffThreshold = 25;         // prag diferenta fata de fundal (nivele de gri)
+    double bgLearningRate = 0.01;   // ponderea cadrului curent in fundal
+    TrackerMode trackerMode = TrackerMode::Global;
+    int maxCoastFrames = 2;         // cadre fara blob in care un track e pastrat (ocluzie)
+    int maxBlobs = 64;              // cele mai mari N bloburi intra in asociere (cost limitat)
+    bool blockGate = true;          // pre-filtru pe blocuri 16x16 (sare cadrele/zonele statice)
+    bool globalChangeGate = true;   // lumina / vibratie pe tot cadrul -> fundal reinvatat, fara bloburi
+    // Benzi paralele (StripePool) de la N pixeli, 0 = niciodata. Testat pe cadrul sursa pentru
+    // reducerea la analiza (toAnalysis) si pe cadrul de analiza pentru masca + bloburi: la
+    // latimea de analiza implicita (640) doar reducerea unui cadru 4K/8MP ruleaza pe benzi,
+    // masca si bloburile doar la latimi de analiza peste ~2.7k (sau fara reducere).
+    int parallelMinPixels = 4000000;
     std::vector<ExcludedZone> excludedZones;
 };
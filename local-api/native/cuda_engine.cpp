@@ -1,48 +1,63 @@
 #include "cuda_engine.h"
 #include <iostream>
 
-void CudaMotionEngine::init(cv::Size frameSize) {
 #ifdef DSS_ENABLE_CUDA
-    // nvjpegCreateSimple(&nvjpeg);
-    blurFilter = cv::cuda::createGaussianFilter(CV_8UC1, CV_8UC1, cv::Size(21, 21), 0);
-#else
-    std::cerr << "[CUDA] Not compiled in binary." << std::endl;
-#endif
-}
 
-bool CudaMotionEngine::processFrame(const cv::Mat& frame, std::vector<EncodedROI>& out) {
-#ifdef DSS_ENABLE_CUDA
-    if (frame.empty()) return false;
+bool CudaMaskBackend::computeMask(const cv::Mat& frame, const CameraConfig& cfg, cv::Mat& mask) {
+    if (!blurFilter) {
+        // nvjpegCreateSimple(&nvjpeg);
+        blurFilter = cv::cuda::createGaussianFilter(CV_8UC1, CV_8UC1, cv::Size(21, 21), 0);
+        dilateFilter = cv::cuda::createMorphologyFilter(cv::MORPH_DILATE, CV_8UC1, cv::Mat(), cv::Point(-1, -1), 2);
+    }
 
     // Upload
     gpuFrame.upload(frame);
-    cv::cuda::cvtColor(gpuFrame, gpuGray, cv::COLOR_BGR2GRAY);
+    if (gpuFrame.channels() == 3) {
+        cv::cuda::cvtColor(gpuFrame, gpuGray, cv::COLOR_BGR2GRAY);
+    } else {
+        gpuGray = gpuFrame;
+    }
 
     // Filter
-    blurFilter->apply(gpuGray, gpuGray);
+    blurFilter->apply(gpuGray, gpuBlur);
+    gpuBlur.convertTo(gpuBlurF, CV_32F);
 
-    if (!backgroundInit) {
-        gpuGray.copyTo(gpuBackground);
+    if (!backgroundInit || gpuBackground.size() != frame.size()) {
+        gpuBlurF.copyTo(gpuBackground);
         backgroundInit = true;
+        mask.create(frame.size(), CV_8UC1);
+        mask.setTo(0);
         return true;
     }
 
     // Diff
-    cv::cuda::absdiff(gpuGray, gpuBackground, gpuDiff);
-    cv::cuda::threshold(gpuDiff, gpuThresh, 25, 255, cv::THRESH_BINARY);
-    
+    cv::cuda::absdiff(gpuBlurF, gpuBackground, gpuDiff);
+    cv::cuda::threshold(gpuDiff, gpuThresh, cfg.diffThreshold, 255, cv::THRESH_BINARY);
+    gpuThresh.convertTo(gpuMask, CV_8U);
+    dilateFilter->apply(gpuMask, gpuDilated);
+
     // Background Update
-    cv::cuda::addWeighted(gpuBackground, 0.90, gpuGray, 0.10, 0, gpuBackground);
+    const double a = cfg.bgLearningRate;
+    cv::cuda::addWeighted(gpuBackground, 1.0 - a, gpuBlurF, a, 0, gpuBackground);
 
-    // Download Mask for Contour (contour is CPU)
-    cv::Mat maskCpu;
-    gpuThresh.download(maskCpu);
+    // Download Mask (blobs / tracking are shared with the other backends)
+    gpuDilated.download(mask);
+    return true;
+}
 
-    // ... Contour extraction same as CPU/OpenCL ...
-    // ... NVJPEG encoding would go here ...
-    
+bool CudaMaskBackend::exportBackground(cv::Mat& q8) const {
+    if (!backgroundInit || gpuBackground.empty()) return false;
+    cv::Mat f;
+    gpuBackground.download(f);
+    f.convertTo(q8, CV_16U, 256.0);
     return true;
-#else
-    return false;
-#endif
 }
+
+void CudaMaskBackend::importBackground(const cv::Mat& q8) {
+    cv::Mat f;
+    q8.convertTo(f, CV_32F, 1.0 / 256.0);
+    gpuBackground.upload(f);
+    backgroundInit = true;
+}
+
+#endif
@@ -1,5 +1,6 @@
 #pragma once
-#include "motion_engine.h"
+#include "mask_backend.h"
+#include "detector_engine.h"
 
 #ifdef DSS_ENABLE_CUDA
 #include <opencv2/cudaimgproc.hpp>
@@ -7,18 +8,27 @@
 #include <opencv2/cudaarithm.hpp>
 #include <opencv2/cudafilters.hpp>
 // #include <nvjpeg.h> // Needs NVJPEG lib
-#endif
 
-class CudaMotionEngine : public MotionEngine {
+// Etapa de pixeli pe CUDA, aceeasi secventa si aceiasi parametri ca OpenClMaskBackend
+class CudaMaskBackend : public MaskBackend {
 public:
-    void init(cv::Size frameSize) override;
-    bool processFrame(const cv::Mat& frame, std::vector<EncodedROI>& out) override;
+    EngineKind kind() const override { return EngineKind::Cuda; }
+    bool computeMask(const cv::Mat& frame, const CameraConfig& cfg, cv::Mat& mask) override;
+    void reseed() override { backgroundInit = false; }
+    bool exportBackground(cv::Mat& q8) const override;
+    void importBackground(const cv::Mat& q8) override;
 
 private:
-#ifdef DSS_ENABLE_CUDA
-    cv::cuda::GpuMat gpuFrame, gpuGray, gpuBackground, gpuDiff, gpuThresh;
+    cv::cuda::GpuMat gpuFrame, gpuGray, gpuBlur, gpuBlurF, gpuBackground, gpuDiff, gpuThresh, gpuMask, gpuDilated;
     cv::Ptr<cv::cuda::Filter> blurFilter;
+    cv::Ptr<cv::cuda::Filter> dilateFilter;
     bool backgroundInit = false;
     // nvjpegHandle_t nvjpeg;
+};
 #endif
+
+// Without DSS_ENABLE_CUDA the detector falls back to the CPU mask stage (createMaskBackend)
+class CudaMotionEngine : public DetectorMotionEngine {
+public:
+    CudaMotionEngine() : DetectorMotionEngine(EngineKind::Cuda) {}
 };
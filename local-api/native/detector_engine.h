@@ -0,0 +1,56 @@
+#pragma once
+#include "motion_engine.h"
+#include "motion_detector.h"
+#include "roi_crop.h"
+#include "jpeg_encode.h"
+#include "jpeg_decode.h"
+
+// MotionEngine peste MotionDetector: backend-ul (CPU / OpenCL / CUDA) produce doar masca,
+// bloburile, tracker-ul, filtrele si ROI-urile sunt acelasi cod pentru toate.
+class DetectorMotionEngine : public MotionEngine {
+public:
+    explicit DetectorMotionEngine(EngineKind kind) : backendKind(kind) {}
+
+    void init(cv::Size frameSize) override {
+        CameraConfig cfg; // Default config
+        detector = std::make_unique<MotionDetector>(cfg, frameSize, backendKind);
+        this->size = frameSize;
+    }
+
+    bool processFrame(const cv::Mat& frame, std::vector<EncodedROI>& out) override {
+        if (frame.empty() || !detector) return false;
+
+        // 1. Detect Motion & Track
+        auto lock = detector->lockFrame();
+        const std::vector<int>& validSlots = detector->processFrameLocked(frame);
+        TrackTable& tracks = detector->tracks();
+
+        // 2. Crop & Encode ROI for Valid Tracks
+        for (int slot : validSlots) {
+            // Folosim ROI utils definite anterior; starea EMA persista in tabela de track-uri
+            uint64_t t0 = motionNowUs();
+            // BBox in analysis space -> frame pixels
+            cv::Rect box = scaleRect(tracks.bbox[slot], detector->sourceScale());
+            cv::Mat roi = cropROI(frame, box, 0.2, tracks.smoothRoi[slot]);
+            
+            if (roi.empty()) continue;
+
+            out.emplace_back();
+            EncodedROI& item = out.back();
+            item.bbox = box;
+            item.objectId = (int)tracks.id[slot];
+
+            // Encode logic
+            encodeJPEG(roi, item.jpeg, 85);
+            detector->stats().addStage(STAGE_ENCODE, motionNowUs() - t0);
+        }
+        return true;
+    }
+
+    MotionDetector* getDetector() { return detector.get(); }
+
+private:
+    EngineKind backendKind;
+    std::unique_ptr<MotionDetector> detector;
+    cv::Size size;
+};
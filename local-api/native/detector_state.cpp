@@ -0,0 +1,206 @@
+#include "detector_state.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static const char kMagic[8] = {'D', 'S', 'S', 'M', 'O', 'T', 'N', 0};
+
+static uint64_t align64(uint64_t v) { return (v + 63) & ~(uint64_t)63; }
+
+static std::vector<uint8_t> serializeConfig(const CameraConfig& cfg) {
+    StoredConfig sc;
+    std::memset(&sc, 0, sizeof(sc)); // padding bytes enter the hash
+    sc.minAreaRatio = cfg.minAreaRatio;
+    sc.maxStaticVariance = cfg.maxStaticVariance;
+    sc.roiPadding = cfg.roiPadding;
+    sc.bgLearningRate = cfg.bgLearningRate;
+    sc.minFrames = cfg.minFrames;
+    sc.diffThreshold = cfg.diffThreshold;
+    sc.trackerMode = (int32_t)cfg.trackerMode;
+    sc.maxCoastFrames = cfg.maxCoastFrames;
+    sc.maxBlobs = cfg.maxBlobs;
+    sc.blockGate = cfg.blockGate ? 1 : 0;
+    sc.globalChangeGate = cfg.globalChangeGate ? 1 : 0;
+    sc.zoneCount = (uint32_t)cfg.excludedZones.size();
+
+    std::vector<uint8_t> out(sizeof(sc) + sc.zoneCount * 4 * sizeof(int32_t));
+    std::memcpy(out.data(), &sc, sizeof(sc));
+    int32_t* z = reinterpret_cast<int32_t*>(out.data() + sizeof(sc));
+    for (const ExcludedZone& e : cfg.excludedZones) {
+        *z++ = e.zone.x;
+        *z++ = e.zone.y;
+        *z++ = e.zone.width;
+        *z++ = e.zone.height;
+    }
+    return out;
+}
+
+uint64_t detectorConfigHash(const CameraConfig& cfg) {
+    uint64_t h = 1469598103934665603ull;
+    for (uint8_t b : serializeConfig(cfg)) {
+        h ^= b;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool writeDetectorState(const std::string& path, const CameraConfig& cfg, cv::Size analysisSize,
+                        cv::Size frameSize, const cv::Mat& background, const TrackTable& tracks) {
+    const std::vector<uint8_t> config = serializeConfig(cfg);
+    const bool hasBackground = !background.empty() && background.type() == CV_16UC1 && background.size() == frameSize;
+    const uint64_t bgBytes = hasBackground ? (uint64_t)frameSize.area() * sizeof(uint16_t) : 0;
+
+    DetectorStateHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kDetectorStateVersion;
+    h.headerSize = sizeof(DetectorStateHeader);
+    h.configHash = detectorConfigHash(cfg);
+    h.savedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    h.analysisWidth = analysisSize.width;
+    h.analysisHeight = analysisSize.height;
+    h.frameWidth = frameSize.width;
+    h.frameHeight = frameSize.height;
+    h.configSize = (uint32_t)config.size();
+    h.trackRecordSize = sizeof(TrackRecord);
+    h.trackCount = (uint32_t)tracks.size();
+    h.nextTrackId = tracks.nextTrackId();
+    h.configOffset = align64(sizeof(h));
+    h.backgroundOffset = hasBackground ? align64(h.configOffset + config.size()) : 0;
+    h.tracksOffset = align64((hasBackground ? h.backgroundOffset + bgBytes : h.configOffset + config.size()));
+    h.fileSize = h.tracksOffset + (uint64_t)h.trackCount * sizeof(TrackRecord);
+
+    std::vector<TrackRecord> records(h.trackCount);
+    for (int s = 0; s < tracks.size(); ++s) {
+        TrackRecord& r = records[s];
+        r.id = tracks.id[s];
+        const cv::Rect& b = tracks.bbox[s];
+        r.bbox[0] = b.x; r.bbox[1] = b.y; r.bbox[2] = b.width; r.bbox[3] = b.height;
+        r.framesAlive = tracks.framesAlive[s];
+        r.missedFrames = tracks.missedFrames[s];
+        r.isStatic = tracks.isStatic[s];
+        r.valid = tracks.valid[s];
+        const cv::Rect& sr = tracks.smoothRoi[s];
+        r.smoothRoi[0] = sr.x; r.smoothRoi[1] = sr.y; r.smoothRoi[2] = sr.width; r.smoothRoi[3] = sr.height;
+        r.velocity[0] = tracks.velocity[s].x;
+        r.velocity[1] = tracks.velocity[s].y;
+        r.history = tracks.history[s];
+    }
+
+    // Scriere atomica: un crash in timpul salvarii lasa fisierul vechi intact
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        auto padTo = [&out](uint64_t off) {
+            static const char zeros[64] = {};
+            uint64_t pos = (uint64_t)out.tellp();
+            if (off > pos) out.write(zeros, (std::streamsize)(off - pos));
+        };
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        padTo(h.configOffset);
+        out.write(reinterpret_cast<const char*>(config.data()), (std::streamsize)config.size());
+        if (hasBackground) {
+            padTo(h.backgroundOffset);
+            for (int y = 0; y < background.rows; ++y) {
+                out.write(reinterpret_cast<const char*>(background.ptr<uint16_t>(y)),
+                          (std::streamsize)(background.cols * sizeof(uint16_t)));
+            }
+        }
+        padTo(h.tracksOffset);
+        if (!records.empty()) {
+            out.write(reinterpret_cast<const char*>(records.data()),
+                      (std::streamsize)(records.size() * sizeof(TrackRecord)));
+        }
+        if (!out) {
+            std::cerr << "[Native] Cannot write detector state " << tmp << std::endl;
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "[Native] Cannot write detector state " << path << std::endl;
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool DetectorStateFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DetectorStateHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    base = static_cast<const uint8_t*>(p);
+    size = (size_t)st.st_size;
+    hdr = reinterpret_cast<const DetectorStateHeader*>(base);
+
+    // Alt build (versiune / layout) sau fisier trunchiat: respins
+    const DetectorStateHeader& h = *hdr;
+    const uint64_t bgBytes = (uint64_t)std::max(0, h.frameWidth) * std::max(0, h.frameHeight) * sizeof(uint16_t);
+    const bool ok = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+                    h.version == kDetectorStateVersion &&
+                    h.headerSize == sizeof(DetectorStateHeader) &&
+                    h.trackRecordSize == sizeof(TrackRecord) &&
+                    h.trackCount <= (uint32_t)kMaxTracks &&
+                    h.fileSize == size &&
+                    h.configOffset + h.configSize <= size &&
+                    (h.backgroundOffset == 0 || h.backgroundOffset + bgBytes <= size) &&
+                    h.tracksOffset + (uint64_t)h.trackCount * sizeof(TrackRecord) <= size &&
+                    h.tracksOffset % alignof(TrackRecord) == 0;
+    if (!ok) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void DetectorStateFile::close() {
+    if (base) munmap(const_cast<uint8_t*>(base), size);
+    base = nullptr;
+    size = 0;
+    hdr = nullptr;
+}
+
+cv::Mat DetectorStateFile::background() const {
+    if (!hdr || hdr->backgroundOffset == 0 || hdr->frameWidth <= 0 || hdr->frameHeight <= 0) return cv::Mat();
+    return cv::Mat(hdr->frameHeight, hdr->frameWidth, CV_16UC1,
+                   const_cast<uint8_t*>(base + hdr->backgroundOffset));
+}
+
+const TrackRecord* DetectorStateFile::tracks() const {
+    return hdr ? reinterpret_cast<const TrackRecord*>(base + hdr->tracksOffset) : nullptr;
+}
+
+void restoreTracks(const DetectorStateFile& file, TrackTable& tracks) {
+    tracks.clear();
+    const TrackRecord* r = file.tracks();
+    for (uint32_t i = 0; r && i < file.header().trackCount; ++i, ++r) {
+        tracks.id.push_back(r->id);
+        tracks.bbox.push_back(cv::Rect(r->bbox[0], r->bbox[1], r->bbox[2], r->bbox[3]));
+        tracks.framesAlive.push_back(r->framesAlive);
+        tracks.missedFrames.push_back(r->missedFrames);
+        tracks.isStatic.push_back(r->isStatic);
+        tracks.valid.push_back(r->valid);
+        tracks.smoothRoi.push_back(cv::Rect(r->smoothRoi[0], r->smoothRoi[1], r->smoothRoi[2], r->smoothRoi[3]));
+        tracks.velocity.push_back(cv::Point2f(r->velocity[0], r->velocity[1]));
+        tracks.history.push_back(r->history);
+        tracks.keep.push_back(1);
+    }
+    tracks.setNextTrackId(file.header().nextTrackId);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "camera_config.h"
+#include "track_table.h"
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// Starea detectorului pe disc, pentru restart la cald: modelul de fundal, track-urile
+// si configuratia. Fara ea fiecare restart al local-api porneste cu fundalul gol,
+// iar rata de 1% are nevoie de minute ca sa se aseze (bloburi false pe toate camerele).
+//
+// Format binar versionat, layout-ul host-ului (fisierul nu pleaca de pe masina):
+//   DetectorStateHeader | StoredConfig + zone | fundal Q8 (rows * cols * 2) | TrackRecord[]
+// Sectiunile sunt aliniate la 64 de octeti, deci fisierul se citeste direct prin mmap.
+// Fisierul e respins daca versiunea, dimensiunile structurilor, rezolutia de analiza
+// sau hash-ul configuratiei difera.
+
+constexpr uint32_t kDetectorStateVersion = 1;
+
+struct DetectorStateHeader {
+    char magic[8];              // "DSSMOTN"
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t configHash;        // detectorConfigHash()
+    int64_t savedAtMs;          // wall clock
+    int32_t analysisWidth;      // MotionDetector::getAnalysisSize()
+    int32_t analysisHeight;
+    int32_t frameWidth;         // analysis-space frame = background size
+    int32_t frameHeight;
+    uint32_t configSize;
+    uint32_t trackRecordSize;
+    uint32_t trackCount;
+    uint32_t nextTrackId;
+    uint64_t configOffset;
+    uint64_t backgroundOffset;  // 0 = no background learned yet
+    uint64_t tracksOffset;
+    uint64_t fileSize;
+};
+
+// CameraConfig without the vector; followed by zoneCount x int32[4]
+struct StoredConfig {
+    double minAreaRatio;
+    double maxStaticVariance;
+    double roiPadding;
+    double bgLearningRate;
+    int32_t minFrames;
+    int32_t diffThreshold;
+    int32_t trackerMode;
+    int32_t maxCoastFrames;
+    int32_t maxBlobs;
+    uint8_t blockGate;
+    uint8_t globalChangeGate;
+    uint8_t reserved[2];
+    uint32_t zoneCount;
+};
+
+// One TrackTable slot (CentroidRing is trivially copyable)
+struct TrackRecord {
+    uint32_t id;
+    int32_t bbox[4];
+    int32_t framesAlive;
+    int32_t missedFrames;
+    uint8_t isStatic;
+    uint8_t valid;
+    uint8_t reserved[2];
+    int32_t smoothRoi[4];
+    float velocity[2];
+    CentroidRing history;
+};
+static_assert(std::is_trivially_copyable<TrackRecord>::value, "TrackRecord is read in place from the mapping");
+
+// FNV-1a over the serialized config (scalars + zones)
+uint64_t detectorConfigHash(const CameraConfig& cfg);
+
+// Atomic write (tmp + rename). background: CV_16UC1 Q8 or empty.
+bool writeDetectorState(const std::string& path, const CameraConfig& cfg, cv::Size analysisSize,
+                        cv::Size frameSize, const cv::Mat& background, const TrackTable& tracks);
+
+// Read-only mapping of a state file; the views stay valid while the object lives
+class DetectorStateFile {
+public:
+    DetectorStateFile() = default;
+    DetectorStateFile(const DetectorStateFile&) = delete;
+    DetectorStateFile& operator=(const DetectorStateFile&) = delete;
+    ~DetectorStateFile() { close(); }
+
+    // False when missing, truncated or from another version / build layout
+    bool open(const std::string& path);
+    void close();
+
+    const DetectorStateHeader& header() const { return *hdr; }
+    // CV_16UC1 view into the mapping, empty when the detector had not learned one
+    cv::Mat background() const;
+    const TrackRecord* tracks() const;
+
+private:
+    const uint8_t* base = nullptr;
+    size_t size = 0;
+    const DetectorStateHeader* hdr = nullptr;
+};
+
+// Restores the slots and the id counter of `tracks` from the file (replaces its content)
+void restoreTracks(const DetectorStateFile& file, TrackTable& tracks);
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// Metrici per detector, in locul logarii pe stdout la fiecare cadru.
+// Scrise de worker-ul care proceseaza cadrul (atomice relaxed, fara lock),
+// citite din Node prin get_detector_stats (snapshot, tot fara lock).
+
+enum MotionStage {
+    STAGE_DECODE = 0,
+    STAGE_MASK,     // global change gate + fused kernel + excluded zones
+    STAGE_BLOB,     // nonzero count + labeling
+    STAGE_TRACK,    // association + filters
+    STAGE_ENCODE,   // ROI crop + JPEG
+    STAGE_COUNT
+};
+
+// Latency histogram: bucket b counts samples in [2^(b-1), 2^b) microseconds,
+// bucket 0 = under 1us, last bucket = everything from 2^20 us (~1 s) up.
+// The range has to separate 4MP decode / mask times (16..500 ms) from each other.
+constexpr int kLatencyBuckets = 22;
+
+// Flat layout of the get_detector_stats output (uint64 values)
+enum DetectorStatsField {
+    STAT_FRAMES = 0,
+    STAT_BLOBS,          // blobs after the area filter, cumulative
+    STAT_TRACKS,         // live tracks after the last frame (gauge)
+    STAT_VALID_OBJECTS,  // valid tracks reported, cumulative
+    STAT_SKIPPED_FRAMES, // decode failures + frames with an empty mask
+    STAT_NONZERO,        // motion pixels in the last mask (gauge)
+    STAT_GATED_FRAMES,   // frames skipped entirely by the block gate (subset of skipped)
+    STAT_LIGHTING_EVENTS, // frame-wide gain/offset change, background re-seeded
+    STAT_SHAKE_EVENTS,   // frame-wide translation (camera shake), background re-seeded
+    STAT_STAGE_BASE      // then per stage: count, totalUs, maxUs, hist[kLatencyBuckets]
+};
+constexpr int kStatsPerStage = 3 + kLatencyBuckets;
+constexpr int kDetectorStatsSize = STAT_STAGE_BASE + STAGE_COUNT * kStatsPerStage;
+
+inline uint64_t motionNowUs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Logarea e opt-in: DSS_MOTION_LOG=1, cel mult o linie per detector
+// la DSS_MOTION_LOG_INTERVAL secunde (implicit 10)
+inline bool motionLogEnabled() {
+    static const bool enabled = [] {
+        const char* v = std::getenv("DSS_MOTION_LOG");
+        return v && *v && *v != '0';
+    }();
+    return enabled;
+}
+
+inline uint64_t motionLogIntervalUs() {
+    static const uint64_t interval = [] {
+        const char* v = std::getenv("DSS_MOTION_LOG_INTERVAL");
+        int s = v ? std::atoi(v) : 0;
+        return (uint64_t)(s > 0 ? s : 10) * 1000000ull;
+    }();
+    return interval;
+}
+
+class DetectorStats {
+public:
+    DetectorStats() {
+        for (auto& v : values) v.store(0, std::memory_order_relaxed);
+    }
+
+    void addStage(MotionStage stage, uint64_t us) {
+        const int base = STAT_STAGE_BASE + stage * kStatsPerStage;
+        add(base + 0, 1);
+        add(base + 1, us);
+        if (us > values[base + 2].load(std::memory_order_relaxed)) {
+            values[base + 2].store(us, std::memory_order_relaxed);
+        }
+        int b = 0;
+        while (b < kLatencyBuckets - 1 && us >= (1ull << b)) ++b;
+        add(base + 3 + b, 1);
+    }
+
+    void add(int field, uint64_t n) { values[field].fetch_add(n, std::memory_order_relaxed); }
+    void set(int field, uint64_t v) { values[field].store(v, std::memory_order_relaxed); }
+    uint64_t get(int field) const { return values[field].load(std::memory_order_relaxed); }
+
+    // Copies up to `count` fields; returns how many were written
+    int snapshot(uint64_t* out, int count) const {
+        int n = count < kDetectorStatsSize ? count : kDetectorStatsSize;
+        for (int i = 0; i < n; ++i) out[i] = values[i].load(std::memory_order_relaxed);
+        return n;
+    }
+
+    // Rate-limited summary line (only when DSS_MOTION_LOG is set)
+    void maybeLog(const void* owner) {
+        if (!motionLogEnabled()) return;
+        uint64_t now = motionNowUs();
+        uint64_t last = lastLogUs.load(std::memory_order_relaxed);
+        if (now - last < motionLogIntervalUs()) return;
+        if (!lastLogUs.compare_exchange_strong(last, now, std::memory_order_relaxed)) return;
+
+        std::cout << "[Native] " << owner
+                  << " frames=" << get(STAT_FRAMES)
+                  << " skipped=" << get(STAT_SKIPPED_FRAMES)
+                  << " gated=" << get(STAT_GATED_FRAMES)
+                  << " lighting=" << get(STAT_LIGHTING_EVENTS)
+                  << " shake=" << get(STAT_SHAKE_EVENTS)
+                  << " blobs=" << get(STAT_BLOBS)
+                  << " tracks=" << get(STAT_TRACKS)
+                  << " valid=" << get(STAT_VALID_OBJECTS)
+                  << " nonzero=" << get(STAT_NONZERO);
+        static const char* names[STAGE_COUNT] = { "decode", "mask", "blob", "track", "encode" };
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            const int base = STAT_STAGE_BASE + s * kStatsPerStage;
+            uint64_t n = get(base);
+            if (n == 0) continue;
+            std::cout << " " << names[s] << "=" << get(base + 1) / n << "us(max " << get(base + 2) << ")";
+        }
+        std::cout << "\n";
+    }
+
+private:
+    std::atomic<uint64_t> values[kDetectorStatsSize];
+    std::atomic<uint64_t> lastLogUs{0};
+};
@@ -0,0 +1,285 @@
+#include "engine_calibration.h"
+#include "hw_detect.h"
+#include "cpu_engine.h"
+#include "opencl_engine.h"
+#include "cuda_engine.h"
+#include "detector_stats.h"
+#include <opencv2/core/ocl.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+static const int kSyntheticFrames = 8;
+static const int kWarmupFrames = 5;   // background init, OpenCL program build
+static const int kTimedFrames = 30;
+
+static bool envIs(const char* name, const char* value) {
+    const char* v = std::getenv(name);
+    return v && std::string(v) == value;
+}
+
+static std::string cachePath() {
+    const char* env = std::getenv("DSS_ENGINE_CACHE");
+    return env && *env ? env : "/opt/dss-edge/config/engine_calibration.cache";
+}
+
+static std::string cacheKey(cv::Size size) {
+    std::ostringstream k;
+    k << hardwareInfo().fingerprint << "|" << size.width << "x" << size.height << "|cv" << CV_VERSION;
+#ifdef DSS_ENABLE_CUDA
+    k << "|cuda";
+#endif
+    std::string key = k.str();
+    std::replace(key.begin(), key.end(), '\t', ' ');
+    std::replace(key.begin(), key.end(), '\n', ' ');
+    return key;
+}
+
+// Format: key \t kind \t isa \t cpuUs \t openclUs \t cudaUs (one line per hardware + size)
+static bool loadCached(const std::string& key, EngineChoice& c) {
+    std::ifstream f(cachePath());
+    std::string line;
+    while (std::getline(f, line)) {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos || line.compare(0, tab, key) != 0 || tab != key.size()) continue;
+
+        std::istringstream fields(line.substr(tab + 1));
+        int kind = -1, isa = -1;
+        if (!(fields >> kind >> isa >> c.cpuUs >> c.openclUs >> c.cudaUs)) return false;
+        if (kind < 0 || kind > (int)EngineKind::Cuda || !motionKernelIsaSupported((KernelIsa)isa)) return false;
+        c.kind = (EngineKind)kind;
+        c.cpuIsa = (KernelIsa)isa;
+        c.fromCache = true;
+        return true;
+    }
+    return false;
+}
+
+static void saveCached(const std::string& key, const EngineChoice& c) {
+    const std::string path = cachePath();
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, key.size() + 1, key + "\t") != 0) lines.push_back(line);
+        }
+    }
+    std::ostringstream entry;
+    entry << key << "\t" << (int)c.kind << "\t" << (int)c.cpuIsa << "\t"
+          << c.cpuUs << "\t" << c.openclUs << "\t" << c.cudaUs;
+    lines.push_back(entry.str());
+
+    // Scriere atomica: alt proces poate citi cache-ul in acelasi timp
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        for (const std::string& l : lines) out << l << "\n";
+        if (!out) {
+            std::cerr << "[Engine] Cannot write calibration cache " << path << std::endl;
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "[Engine] Cannot write calibration cache " << path << std::endl;
+        std::remove(tmp.c_str());
+    }
+}
+
+// Static noise + a square moving across the frame: the blur, diff, background update,
+// tracker and ROI encode all get exercised like on a real scene with one object
+static std::vector<cv::Mat> syntheticFrames(cv::Size size) {
+    cv::Mat base(size, CV_8UC3);
+    cv::randu(base, cv::Scalar(90, 90, 90), cv::Scalar(140, 140, 140));
+
+    std::vector<cv::Mat> frames;
+    const int side = std::max(8, size.width / 10);
+    for (int i = 0; i < kSyntheticFrames; ++i) {
+        cv::Mat f = base.clone();
+        int x = (i * size.width / kSyntheticFrames) % std::max(1, size.width - side);
+        cv::rectangle(f, cv::Rect(x, size.height / 3, side, std::min(side, size.height)), cv::Scalar(230, 230, 230), -1);
+        frames.push_back(f);
+    }
+    return frames;
+}
+
+// Median processing time per frame, 0 if the engine fails
+static double measureEngine(MotionEngine& engine, cv::Size size, const std::vector<cv::Mat>& frames) {
+    engine.init(size);
+    std::vector<EncodedROI> out;
+    std::vector<double> samples;
+    samples.reserve(kTimedFrames);
+
+    for (int i = 0; i < kWarmupFrames + kTimedFrames; ++i) {
+        out.clear();
+        uint64_t t0 = motionNowUs();
+        if (!engine.processFrame(frames[i % frames.size()], out)) return 0.0;
+        if (i >= kWarmupFrames) samples.push_back((double)(motionNowUs() - t0));
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return std::max(1.0, samples[samples.size() / 2]);
+}
+
+static EngineChoice heuristicChoice() {
+    EngineChoice c;
+    c.cpuIsa = motionKernelOps().isa;
+    switch (detectGpu()) {
+#ifdef DSS_ENABLE_CUDA
+        case GpuType::NVIDIA: c.kind = EngineKind::Cuda; break;
+#endif
+        case GpuType::INTEL_IGPU:
+        case GpuType::AMD_IGPU: c.kind = EngineKind::OpenCL; break;
+        default: c.kind = EngineKind::Cpu; break;
+    }
+    return c;
+}
+
+static EngineChoice runCalibration(cv::Size size) {
+    EngineChoice c;
+    const std::vector<cv::Mat> frames = syntheticFrames(size);
+    std::ostringstream report;
+
+    // Kernel-ul CPU: toate ISA-urile sunt bit-exacte, comutarea globala e sigura
+    // chiar daca alti detectori ruleaza in paralel (doar masuratoarea e mai zgomotoasa)
+    const bool forced = motionKernelIsaForced();
+    const KernelIsa initial = motionKernelOps().isa;
+    c.cpuIsa = initial;
+    for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::SSE4, KernelIsa::AVX2, KernelIsa::NEON}) {
+        if (!motionKernelIsaSupported(isa) || (forced && isa != initial)) continue;
+        selectMotionKernelIsa(isa);
+        CpuMotionEngine cpu;
+        double us = measureEngine(cpu, size, frames);
+        report << " cpu/" << motionKernelOps(isa).name << "=" << (long)us << "us";
+        if (us > 0.0 && (c.cpuUs == 0.0 || us < c.cpuUs)) {
+            c.cpuUs = us;
+            c.cpuIsa = isa;
+        }
+    }
+    if (!forced) selectMotionKernelIsa(c.cpuIsa);
+
+    // OpenCL pe device-ul implicit (OPENCV_OPENCL_DEVICE il alege); poate fi si un runtime CPU
+    if (cv::ocl::haveOpenCL()) {
+        const bool prevUse = cv::ocl::useOpenCL();
+        OpenClMotionEngine ocl;
+        c.openclUs = measureEngine(ocl, size, frames);
+        const cv::ocl::Device& dev = cv::ocl::Device::getDefault();
+        report << " opencl(" << dev.name() << (dev.type() == cv::ocl::Device::TYPE_CPU ? ", cpu" : "")
+               << ")=" << (long)c.openclUs << "us";
+        cv::ocl::setUseOpenCL(prevUse);
+    }
+
+#ifdef DSS_ENABLE_CUDA
+    if (detectGpu() == GpuType::NVIDIA) {
+        CudaMotionEngine cuda;
+        c.cudaUs = measureEngine(cuda, size, frames);
+        report << " cuda=" << (long)c.cudaUs << "us";
+    }
+#endif
+
+    // La egalitate ramane CPU (fara transferuri, fara dependente de driver)
+    double best = c.cpuUs > 0.0 ? c.cpuUs : 1e30;
+    if (c.openclUs > 0.0 && c.openclUs < best) { best = c.openclUs; c.kind = EngineKind::OpenCL; }
+    if (c.cudaUs > 0.0 && c.cudaUs < best) { best = c.cudaUs; c.kind = EngineKind::Cuda; }
+
+    std::cout << "[Engine] Calibration " << size.width << "x" << size.height << ":" << report.str()
+              << " -> " << engineKindName(c.kind) << std::endl;
+    return c;
+}
+
+// Starea e alocata o singura data si nu se distruge: firul de calibrare detasat poate
+// inca rula cand procesul iese (Node nu asteapta dupa biblioteca)
+struct CalibrationState {
+    std::mutex mtx;
+    std::condition_variable done;
+    std::map<std::pair<int, int>, EngineChoice> choices;
+    std::set<std::pair<int, int>> running;   // sizes measured right now on a worker thread
+    std::mutex measureMtx;                   // one measurement at a time (global ISA switch, cache file)
+};
+
+static CalibrationState& calibrationState() {
+    static CalibrationState* s = new CalibrationState();
+    return *s;
+}
+
+// Choice available without measuring: heuristic (calibration off) or the disk cache
+static bool quickChoice(cv::Size size, EngineChoice& c) {
+    if (envIs("DSS_ENGINE_CALIBRATION", "0") || size.width <= 0 || size.height <= 0) {
+        c = heuristicChoice();
+        return true;
+    }
+    if (envIs("DSS_ENGINE_RECALIBRATE", "1") || !loadCached(cacheKey(size), c)) return false;
+    std::cout << "[Engine] Cached choice " << size.width << "x" << size.height << ": "
+              << engineKindName(c.kind) << ", cpu/" << motionKernelOps(c.cpuIsa).name << std::endl;
+    if (!motionKernelIsaForced()) selectMotionKernelIsa(c.cpuIsa);
+    return true;
+}
+
+static EngineChoice measureAndStore(cv::Size size) {
+    CalibrationState& st = calibrationState();
+    std::lock_guard<std::mutex> measure(st.measureMtx);
+    EngineChoice c = runCalibration(size);
+    saveCached(cacheKey(size), c);
+    return c;
+}
+
+const EngineChoice& calibratedEngine(cv::Size analysisSize) {
+    CalibrationState& st = calibrationState();
+    const auto k = std::make_pair(analysisSize.width, analysisSize.height);
+
+    std::unique_lock<std::mutex> lock(st.mtx);
+    // Aceeasi rezolutie deja in masurare pe fir: asteptam rezultatul, nu masuram de doua ori
+    st.done.wait(lock, [&] { return !st.running.count(k); });
+    auto it = st.choices.find(k);
+    if (it != st.choices.end()) return it->second;
+
+    EngineChoice c;
+    if (!quickChoice(analysisSize, c)) {
+        // Fara lock in timpul masurarii: engineChoiceNow (alte rezolutii, alte fire) nu asteapta
+        st.running.insert(k);
+        lock.unlock();
+        c = measureAndStore(analysisSize);
+        lock.lock();
+        st.running.erase(k);
+        st.done.notify_all();
+    }
+    return st.choices.emplace(k, c).first->second;
+}
+
+EngineChoice engineChoiceNow(cv::Size analysisSize) {
+    CalibrationState& st = calibrationState();
+    const auto k = std::make_pair(analysisSize.width, analysisSize.height);
+
+    std::lock_guard<std::mutex> lock(st.mtx);
+    auto it = st.choices.find(k);
+    if (it != st.choices.end()) return it->second;
+
+    EngineChoice c;
+    if (quickChoice(analysisSize, c)) return st.choices.emplace(k, c).first->second;
+
+    // Prima pornire pe hardware nou: masurarea dureaza secunde, apelantul (event loop-ul
+    // Node) primeste euristica acum, rezultatul ajunge in cache pentru detectorii urmatori
+    if (st.running.insert(k).second) {
+        std::cout << "[Engine] Calibrating " << analysisSize.width << "x" << analysisSize.height
+                  << " in the background, heuristic choice meanwhile" << std::endl;
+        std::thread([analysisSize, k] {
+            const EngineChoice measured = measureAndStore(analysisSize);
+            CalibrationState& st = calibrationState();
+            {
+                std::lock_guard<std::mutex> lock(st.mtx);
+                st.choices.emplace(k, measured);
+                st.running.erase(k);
+            }
+            st.done.notify_all();
+        }).detach();
+    }
+    return heuristicChoice();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "motion_kernel.h"
+#include "mask_backend.h"
+#include <opencv2/opencv.hpp>
+#include <string>
+
+// Alegerea engine-ului dupa masuratoare, nu dupa vendor: la prima pornire pe un
+// hardware nou fiecare engine disponibil (kernel CPU pe fiecare ISA, OpenCL pe
+// device-ul implicit - inclusiv runtime-uri OpenCL pe CPU -, CUDA daca e compilat)
+// ruleaza pe cadre sintetice la rezolutia de analiza; cel mai rapid castiga.
+// Rezultatul se pastreaza pe disc, cheie = amprenta hardware + rezolutie + build.
+//
+// DSS_ENGINE_CACHE        fisierul cache (implicit /opt/dss-edge/config/engine_calibration.cache)
+// DSS_ENGINE_RECALIBRATE=1 ignora cache-ul
+// DSS_ENGINE_CALIBRATION=0 fara calibrare (euristica veche dupa vendor / cpuid)
+
+struct EngineChoice {
+    EngineKind kind = EngineKind::Cpu;    // backend of the mask stage (mask_backend.h)
+    KernelIsa cpuIsa = KernelIsa::Scalar;  // fastest ISA of the CPU kernel (used by every MotionDetector)
+    double cpuUs = 0.0;                    // median per frame, 0 = not measured / unavailable
+    double openclUs = 0.0;
+    double cudaUs = 0.0;
+    bool fromCache = false;
+
+    // cpuIsa comes from a measurement (this run or the disk cache). The heuristic only
+    // reports the kernel's current ISA, which may be one a background calibration is
+    // measuring right now: selecting it would pin that ISA after the calibration ends.
+    bool measuredIsa() const { return fromCache || cpuUs > 0.0; }
+};
+
+// Once per process and analysis size; measured only when the disk cache has no entry.
+// Thread-safe, blocks for the whole measurement (seconds). Also applies cpuIsa to the
+// kernel (unless DSS_MOTION_ISA forces one). For tools and engine_factory.h.
+const EngineChoice& calibratedEngine(cv::Size analysisSize);
+
+// Never measures on the calling thread (the FFI create_detector* calls, Node event loop):
+// the known choice (memory / disk cache) when there is one, otherwise the heuristic while
+// the measurement runs once on a background thread. When it finishes, the measured ISA is
+// applied to the kernel and later calls get the measured engine; detectors created in the
+// meantime keep their mask backend.
+EngineChoice engineChoiceNow(cv::Size analysisSize);
@@ -1,34 +1,45 @@
 #pragma once
-#include "hw_detect.h"
+#include "engine_calibration.h"
 #include "cuda_engine.h"
 #include "opencl_engine.h"
 #include "cpu_engine.h"
+#include "mv_engine.h"
 #include <memory>
 #include <iostream>
 
-inline std::unique_ptr<MotionEngine> createEngine() {
-    GpuType gpu = detectGpu();
+// Engine-ul se alege dupa calibrare (engine_calibration.h), nu dupa vendorul GPU
+inline std::unique_ptr<MotionEngine> createEngine(cv::Size analysisSize = cv::Size(640, 360)) {
+    const EngineChoice& choice = calibratedEngine(analysisSize);
 
-    switch (gpu) {
-        case GpuType::NVIDIA:
+    switch (choice.kind) {
+        case EngineKind::Cuda:
 #ifdef DSS_ENABLE_CUDA
-            std::cout << "[Engine] Detected NVIDIA GPU. Loading CUDA Engine..." << std::endl;
+            std::cout << "[Engine] Loading CUDA Engine (" << (long)choice.cudaUs << " us/frame)..." << std::endl;
             return std::make_unique<CudaMotionEngine>();
 #else
-            std::cout << "[Engine] Detected NVIDIA GPU but CUDA not compiled. Fallback to CPU." << std::endl;
+            std::cout << "[Engine] CUDA selected but not compiled. Fallback to CPU." << std::endl;
             return std::make_unique<CpuMotionEngine>();
 #endif
 
-        case GpuType::INTEL_IGPU:
-            std::cout << "[Engine] Detected Intel iGPU. Loading OpenCL Engine..." << std::endl;
-            return std::make_unique<OpenClMotionEngine>();
-
-        case GpuType::AMD_IGPU:
-            std::cout << "[Engine] Detected AMD GPU. Loading OpenCL Engine..." << std::endl;
+        case EngineKind::OpenCL:
+            std::cout << "[Engine] Loading OpenCL Engine (" << (long)choice.openclUs << " us/frame)..." << std::endl;
             return std::make_unique<OpenClMotionEngine>();
 
         default:
-            std::cout << "[Engine] No specific GPU detected. Loading Optimized CPU Engine..." << std::endl;
+            std::cout << "[Engine] Loading Optimized CPU Engine (" << motionKernelOps().name << ", "
+                      << (long)choice.cpuUs << " us/frame)..." << std::endl;
             return std::make_unique<CpuMotionEngine>();
     }
 }
+
+// Motorul pe vectori de miscare nu depinde de GPU: il cere explicit apelantul
+// care citeste direct stream-ul (RTSP / segmente .mp4)
+inline std::unique_ptr<MvMotionEngine> createMotionVectorEngine() {
+#ifdef DSS_ENABLE_LIBAV
+    std::cout << "[Engine] Loading Motion Vector Engine (compressed domain)..." << std::endl;
+    return std::make_unique<MvMotionEngine>();
+#else
+    std::cout << "[Engine] Motion Vector Engine requested but libav not compiled." << std::endl;
+    return nullptr;
+#endif
+}
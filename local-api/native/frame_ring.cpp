@@ -0,0 +1,238 @@
+#include "frame_ring.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kRingMagic[8] = {'D', 'S', 'S', 'R', 'I', 'N', 'G', 0};
+
+static uint64_t alignUp(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+static const FrameRingSlot* slotsOf(const uint8_t* base) {
+    return reinterpret_cast<const FrameRingSlot*>(base + alignUp(sizeof(FrameRingHeader), 64));
+}
+
+uint64_t rawFrameBytes(int width, int height, int stride, int pixfmt) {
+    if (width <= 0 || height <= 0) return 0;
+    const uint64_t h = (uint64_t)height, ch = (uint64_t)(height + 1) / 2;
+    switch (pixfmt) {
+        case PIXFMT_BGR24: return (uint64_t)std::max(stride, width * 3) * h;
+        case PIXFMT_GRAY8: return (uint64_t)std::max(stride, width) * h;
+        case PIXFMT_NV12: {
+            const uint64_t s = (uint64_t)std::max(stride, width);
+            return s * h + s * ch;
+        }
+        case PIXFMT_I420: {
+            const uint64_t s = (uint64_t)std::max(stride, width);
+            return s * h + 2 * ((s + 1) / 2) * ch; // latime impara: (w + 1) / 2 octeti de croma
+        }
+        default: return 0;
+    }
+}
+
+int64_t frameRingNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// --- Producer ----------------------------------------------------------------------
+
+bool FrameRingWriter::create(const std::string& name, int width, int height, int stride, int pixfmt, int slots) {
+    close();
+    const int minStride = pixfmt == PIXFMT_BGR24 ? width * 3 : width;
+    if (stride <= 0) stride = minStride;
+    const uint64_t frameBytes = rawFrameBytes(width, height, stride, pixfmt);
+    if (frameBytes == 0 || stride < minStride || name.empty() || name[0] != '/') return false;
+    slots = std::max(kFrameRingMinSlots, std::min(kFrameRingMaxSlots, slots));
+
+    const uint64_t slotBytes = alignUp(frameBytes, 4096);
+    const uint64_t dataOffset = alignUp(alignUp(sizeof(FrameRingHeader), 64) + slots * sizeof(FrameRingSlot), 4096);
+    const uint64_t total = dataOffset + slotBytes * slots;
+
+    // Inel nou, nu redimensionat: consumatorii vechi raman pe obiectul vechi (fara cadre noi)
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        std::cerr << "[Ring] Cannot create " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, (off_t)total) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* p = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    base = static_cast<uint8_t*>(p);
+    mapBytes = total;
+    shmName = name;
+    hdr = reinterpret_cast<FrameRingHeader*>(base);
+    // ftruncate zeroes the object: every atomic starts at 0
+    hdr->version = kFrameRingVersion;
+    hdr->headerSize = sizeof(FrameRingHeader);
+    hdr->width = width;
+    hdr->height = height;
+    hdr->stride = stride;
+    hdr->pixfmt = pixfmt;
+    hdr->slotCount = (uint32_t)slots;
+    hdr->slotBytes = slotBytes;
+    hdr->frameBytes = frameBytes;
+    hdr->dataOffset = dataOffset;
+    hdr->producerPid = (int64_t)getpid();
+    hdr->createdAtMs = frameRingNowMs();
+    nextFrame = 1;
+    // Magic ultimul: un consumator care il vede gaseste restul header-ului complet
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(hdr->magic, kRingMagic, sizeof(kRingMagic));
+    std::cout << "[Ring] " << name << " created: " << width << "x" << height << " fmt " << pixfmt
+              << ", " << slots << " slots" << std::endl;
+    return true;
+}
+
+void FrameRingWriter::close(bool unlink) {
+    if (base) munmap(base, mapBytes);
+    if (unlink && !shmName.empty()) shm_unlink(shmName.c_str());
+    base = nullptr;
+    mapBytes = 0;
+    hdr = nullptr;
+    writing = nullptr;
+    shmName.clear();
+}
+
+uint8_t* FrameRingWriter::beginWrite() {
+    if (!hdr) return nullptr;
+    const uint32_t idx = (uint32_t)((nextFrame - 1) % hdr->slotCount);
+    writing = const_cast<FrameRingSlot*>(slotsOf(base)) + idx;
+    // Seq impar inainte de orice scriere in pixeli (fence release: ordinea store-urilor)
+    writing->seq.store(writing->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return base + hdr->dataOffset + (uint64_t)idx * hdr->slotBytes;
+}
+
+void FrameRingWriter::commit(int64_t timestampMs) {
+    if (!hdr || !writing) return;
+    writing->frameNumber = nextFrame;
+    writing->timestampMs = timestampMs;
+    writing->seq.store(writing->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    hdr->published.store(nextFrame, std::memory_order_release);
+    writing = nullptr;
+    ++nextFrame;
+}
+
+bool FrameRingWriter::publish(const uint8_t* src, int srcStride, int64_t timestampMs) {
+    if (!hdr || !src) return false;
+    const int stride = hdr->stride;
+    if (srcStride <= 0) srcStride = stride;
+    uint8_t* dst = beginWrite();
+
+    if (srcStride == stride) {
+        std::memcpy(dst, src, hdr->frameBytes);
+    } else {
+        // Rand cu rand; croma urmeaza Y in ambele layout-uri, cu stride-ul derivat
+        const int rowBytes = hdr->pixfmt == PIXFMT_BGR24 ? hdr->width * 3 : hdr->width;
+        int rows = hdr->height;
+        const uint8_t* s = src;
+        uint8_t* d = dst;
+        for (int y = 0; y < rows; ++y, s += srcStride, d += stride) std::memcpy(d, s, rowBytes);
+        const int ch = (hdr->height + 1) / 2;
+        if (hdr->pixfmt == PIXFMT_NV12) {
+            for (int y = 0; y < ch; ++y, s += srcStride, d += stride) std::memcpy(d, s, rowBytes);
+        } else if (hdr->pixfmt == PIXFMT_I420) {
+            const int cw = (hdr->width + 1) / 2;
+            const int srcUV = (srcStride + 1) / 2, dstUV = (stride + 1) / 2;
+            for (int y = 0; y < 2 * ch; ++y, s += srcUV, d += dstUV) std::memcpy(d, s, cw);
+        }
+    }
+    commit(timestampMs);
+    return true;
+}
+
+// --- Consumer ----------------------------------------------------------------------
+
+bool FrameRingReader::open(const std::string& name) {
+    close();
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FrameRingHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    base = static_cast<const uint8_t*>(p);
+    mapBytes = (size_t)st.st_size;
+    hdr = reinterpret_cast<const FrameRingHeader*>(base);
+
+    const FrameRingHeader& h = *hdr;
+    const bool ok = std::memcmp(h.magic, kRingMagic, sizeof(kRingMagic)) == 0 &&
+                    h.version == kFrameRingVersion &&
+                    h.headerSize == sizeof(FrameRingHeader) &&
+                    h.slotCount >= (uint32_t)kFrameRingMinSlots && h.slotCount <= (uint32_t)kFrameRingMaxSlots &&
+                    h.frameBytes == rawFrameBytes(h.width, h.height, h.stride, h.pixfmt) &&
+                    h.frameBytes <= h.slotBytes &&
+                    h.dataOffset + h.slotBytes * h.slotCount <= mapBytes;
+    if (!ok) {
+        close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    lastConsumed = 0;
+    return true;
+}
+
+void FrameRingReader::close() {
+    if (base) munmap(const_cast<uint8_t*>(base), mapBytes);
+    base = nullptr;
+    mapBytes = 0;
+    hdr = nullptr;
+}
+
+bool FrameRingReader::latest(RingFrameView& view, int64_t maxAgeMs) {
+    if (!hdr) return false;
+    const uint64_t n = hdr->published.load(std::memory_order_acquire);
+    if (n == 0 || n == lastConsumed) return false;
+
+    const uint32_t idx = (uint32_t)((n - 1) % hdr->slotCount);
+    const FrameRingSlot* slot = slotsOf(base) + idx;
+    const uint64_t seq = slot->seq.load(std::memory_order_acquire);
+    if (seq & 1) return false; // already being rewritten: the producer lapped us
+    const uint64_t frameNumber = slot->frameNumber;
+    const int64_t ts = slot->timestampMs;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->seq.load(std::memory_order_relaxed) != seq || frameNumber != n) return false;
+
+    lastConsumed = n;
+    if (maxAgeMs > 0 && frameRingNowMs() - ts > maxAgeMs) return false;
+
+    view.data = base + hdr->dataOffset + (uint64_t)idx * hdr->slotBytes;
+    view.frameNumber = n;
+    view.timestampMs = ts;
+    view.slot = slot;
+    view.seq = seq;
+    return true;
+}
+
+bool FrameRingReader::stillValid(const RingFrameView& view) const {
+    if (!view.slot) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return view.slot->seq.load(std::memory_order_relaxed) == view.seq;
+}
+
+const uint8_t* FrameRingReader::copyFrame(const RingFrameView& view) {
+    if (!hdr || !view.data) return nullptr;
+    frameCopy.resize(hdr->frameBytes);
+    std::memcpy(frameCopy.data(), view.data, hdr->frameBytes);
+    return stillValid(view) ? frameCopy.data() : nullptr;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include "raw_frame.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Inel de cadre brute in memorie partajata POSIX (shm_open), unul per camera, intre un
+// producator (decoder nativ, recorder, generator de test - orice proces) si detector.
+// Inlocuieste drumul prin JPEG-uri pe ramdisk + verificari de mtime: consumatorul
+// ia direct cel mai nou cadru (o singura copie in memorie, fara fisiere si fara JPEG).
+//
+// Layout: FrameRingHeader | FrameRingSlot[slotCount] | date (slotCount x slotBytes, aliniate la 4 KiB)
+// Geometria (w, h, stride, format) e fixa pe durata inelului; alta geometrie = alt inel.
+//
+// Sincronizare fara lock, seqlock per slot:
+//   producator: seq impar -> scrie pixelii + metadate -> seq par -> published = frameNumber
+//   consumator: citeste published, seq (par) -> copiaza slotul -> reciteste seq;
+//   daca s-a schimbat intre timp, copia e amestecata (torn) si e aruncata inainte sa
+//   ajunga in detector (fundalul si track-urile nu vad niciodata un cadru rupt).
+// Cu slotCount >= 3 producatorul trebuie sa mai publice slotCount - 1 cadre ca sa
+// ajunga la slotul citit, deci la ratele camerelor un torn e practic exclus.
+
+constexpr uint32_t kFrameRingVersion = 1;
+constexpr int kFrameRingMinSlots = 3;
+constexpr int kFrameRingMaxSlots = 16;
+
+struct FrameRingSlot {
+    std::atomic<uint64_t> seq;          // odd = being written
+    uint64_t frameNumber;               // 1-based, 0 = never written
+    int64_t timestampMs;                // producer wall clock (CLOCK_REALTIME)
+    uint64_t reserved[5];               // one cache line per slot
+};
+
+struct FrameRingHeader {
+    char magic[8];                      // "DSSRING"
+    uint32_t version;
+    uint32_t headerSize;
+    int32_t width, height, stride, pixfmt;  // RawPixelFormat
+    uint32_t slotCount;
+    uint32_t reserved0;
+    uint64_t slotBytes;                 // stride of the data area (frame bytes rounded up)
+    uint64_t frameBytes;
+    uint64_t dataOffset;
+    int64_t producerPid;
+    std::atomic<uint64_t> published;    // newest complete frame number, 0 = none
+    int64_t createdAtMs;
+};
+
+// Atomicele stau in memorie partajata intre procese: trebuie sa fie fara lock
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+
+// Result of process_frame_ring (FFI layout, mirrored in aiRequest.js)
+struct RingFrameInfo {
+    int64_t frameSeq;       // producer frame number
+    int64_t timestampMs;    // producer wall clock
+    int32_t width, height;
+    int32_t fullOffset;     // RING_FULL_FRAME: JPEG of the whole frame, -1 = none / did not fit
+    int32_t fullLen;
+};
+
+enum FrameRingStatus {
+    RING_NO_FRAME = -2,     // nothing newer than the last call, or older than maxAgeMs
+    RING_TORN     = -3      // overwritten by the producer while being copied, frame dropped unanalysed
+};
+
+enum FrameRingFlags {
+    RING_FULL_FRAME = 1     // with valid tracks, also encode the whole frame (AI hub job)
+};
+
+// Bytes of one frame in the ring layout (chroma follows Y, see wrapRawYuv)
+uint64_t rawFrameBytes(int width, int height, int stride, int pixfmt);
+int64_t frameRingNowMs();
+
+// Producer side. create() replaces any previous ring of the same name: consumers
+// still attached to the old one see it go stale (no new frames) and re-open.
+class FrameRingWriter {
+public:
+    FrameRingWriter() = default;
+    FrameRingWriter(const FrameRingWriter&) = delete;
+    FrameRingWriter& operator=(const FrameRingWriter&) = delete;
+    ~FrameRingWriter() { close(); }
+
+    bool create(const std::string& name, int width, int height, int stride, int pixfmt, int slots);
+    // unlink: remove the name too (producer shutting down for good)
+    void close(bool unlink = false);
+    bool isOpen() const { return hdr != nullptr; }
+
+    // In-place write: fill the returned buffer (frameBytes(), header geometry), then commit.
+    uint8_t* beginWrite();
+    void commit(int64_t timestampMs);
+    // Copy of one frame in the ring layout; srcStride <= 0 = header stride
+    bool publish(const uint8_t* src, int srcStride, int64_t timestampMs);
+
+    const FrameRingHeader& header() const { return *hdr; }
+
+private:
+    std::string shmName;
+    uint8_t* base = nullptr;
+    size_t mapBytes = 0;
+    FrameRingHeader* hdr = nullptr;
+    FrameRingSlot* writing = nullptr;
+    uint64_t nextFrame = 1;
+};
+
+// Newest frame as seen by a consumer: pixels are a view into the shared mapping
+struct RingFrameView {
+    const uint8_t* data = nullptr;
+    uint64_t frameNumber = 0;
+    int64_t timestampMs = 0;
+    const FrameRingSlot* slot = nullptr;
+    uint64_t seq = 0;
+};
+
+// Consumer side, read-only mapping
+class FrameRingReader {
+public:
+    FrameRingReader() = default;
+    FrameRingReader(const FrameRingReader&) = delete;
+    FrameRingReader& operator=(const FrameRingReader&) = delete;
+    ~FrameRingReader() { close(); }
+
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return hdr != nullptr; }
+
+    // Newest published frame, if newer than the last one returned and not older than
+    // maxAgeMs (<= 0: any age). False: nothing new / stale / being written.
+    bool latest(RingFrameView& view, int64_t maxAgeMs);
+    // True while the slot of `view` has not been rewritten since latest()
+    bool stillValid(const RingFrameView& view) const;
+    // Copies the frame of `view` into a reader-owned buffer (valid until the next call)
+    // and validates the seqlock afterwards. nullptr: torn, the copy must not be used.
+    const uint8_t* copyFrame(const RingFrameView& view);
+
+    const FrameRingHeader& header() const { return *hdr; }
+    uint64_t lastFrame() const { return lastConsumed; }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t mapBytes = 0;
+    const FrameRingHeader* hdr = nullptr;
+    uint64_t lastConsumed = 0;
+    std::vector<uint8_t> frameCopy;
+};
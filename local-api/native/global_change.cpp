@@ -0,0 +1,114 @@
+#include "global_change.h"
+#include <cmath>
+
+void GlobalChangeGate::seed(const cv::Mat& q8Background) {
+    if (q8Background.empty()) return;
+    const int w = std::min(kThumbWidth, q8Background.cols);
+    const int h = std::max(1, (int)std::lround((double)q8Background.rows * w / q8Background.cols));
+    cv::resize(q8Background, thumb, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+    thumb.convertTo(reference, CV_32F, 1.0 / 256.0);
+    reference.copyTo(prev);
+    cv::createHanningWindow(window, reference.size(), CV_32F);
+    init = true;
+}
+
+bool GlobalChangeGate::shiftExplains(cv::Point2d s, float thr) {
+    // prev mutat cu s trebuie sa dea cur: o persoana aproape de camera (>35% din miniatura)
+    // are si ea un varf de corelatie, dar fundalul ramas pe loc nu se potriveste dupa mutare
+    const cv::Mat m = (cv::Mat_<double>(2, 3) << 1, 0, s.x, 0, 1, s.y);
+    cv::warpAffine(prev, warped, m, prev.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+
+    // Marginea adusa din afara cadrului nu conteaza
+    const int mx = (int)std::ceil(std::fabs(s.x)) + 1;
+    const int my = (int)std::ceil(std::fabs(s.y)) + 1;
+    if (cur.cols <= 2 * mx || cur.rows <= 2 * my) return false;
+
+    int residual = 0;
+    for (int y = my; y < cur.rows - my; ++y) {
+        const float* c = cur.ptr<float>(y);
+        const float* p = warped.ptr<float>(y);
+        for (int x = mx; x < cur.cols - mx; ++x) {
+            if (std::fabs(c[x] - p[x]) > thr) ++residual;
+        }
+    }
+    return residual < kExplainedFraction * (cur.cols - 2 * mx) * (cur.rows - 2 * my);
+}
+
+GlobalChange GlobalChangeGate::analyse(const cv::Mat& frame, const CameraConfig& cfg) {
+    if (frame.empty()) return GlobalChange::None;
+
+    // Miniatura: medie pe arii (zgomotul dispare, ca blur-ul 21x21 al mastii), gri dupa resize
+    const int w = std::min(kThumbWidth, frame.cols);
+    const int h = std::max(1, (int)std::lround((double)frame.rows * w / frame.cols));
+    cv::resize(frame, thumb, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+    const cv::Mat* gray = &thumb;
+    if (thumb.channels() == 3) {
+        cv::cvtColor(thumb, thumbGray, cv::COLOR_BGR2GRAY);
+        gray = &thumbGray;
+    }
+    gray->convertTo(cur, CV_32F);
+
+    if (!init || reference.size() != cur.size()) {
+        cur.copyTo(reference);
+        cur.copyTo(prev);
+        cv::createHanningWindow(window, cur.size(), CV_32F);
+        init = true;
+        return GlobalChange::None;
+    }
+
+    // Fractia schimbata fata de fundal + sumele pentru regresia cur = g * ref + o
+    const float thr = (float)cfg.diffThreshold;
+    const int n = cur.rows * cur.cols;
+    int changed = 0;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int y = 0; y < cur.rows; ++y) {
+        const float* c = cur.ptr<float>(y);
+        const float* r = reference.ptr<float>(y);
+        for (int x = 0; x < cur.cols; ++x) {
+            if (std::fabs(c[x] - r[x]) > thr) ++changed;
+            sx += r[x];
+            sy += c[x];
+            sxx += (double)r[x] * r[x];
+            sxy += (double)r[x] * c[x];
+        }
+    }
+
+    GlobalChange result = GlobalChange::None;
+    if (changed > kWideFraction * n) {
+        const double mx = sx / n, my = sy / n;
+        const double var = sxx / n - mx * mx;
+        const double g = var > 1.0 ? (sxy / n - mx * my) / var : 1.0;
+        const double o = my - g * mx;
+
+        int residual = 0;
+        for (int y = 0; y < cur.rows; ++y) {
+            const float* c = cur.ptr<float>(y);
+            const float* r = reference.ptr<float>(y);
+            for (int x = 0; x < cur.cols; ++x) {
+                if (std::fabs(c[x] - (g * r[x] + o)) > thr) ++residual;
+            }
+        }
+
+        if (residual < kExplainedFraction * n) {
+            result = GlobalChange::Lighting;
+            lastGain = g;
+            lastOffset = o;
+        } else {
+            // Vibratia se vede intre cadre consecutive, nu fata de fundal
+            double response = 0.0;
+            cv::Point2d s = cv::phaseCorrelate(prev, cur, window, &response);
+            if (std::hypot(s.x, s.y) >= kMinShiftPx && response >= kMinResponse && shiftExplains(s, thr)) {
+                result = GlobalChange::Shake;
+                lastShift = s;
+            }
+        }
+    }
+
+    if (result != GlobalChange::None) {
+        cur.copyTo(reference); // the detector re-seeds its background on this frame too
+    } else {
+        cv::accumulateWeighted(cur, reference, cfg.bgLearningRate);
+    }
+    std::swap(prev, cur);
+    return result;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "camera_config.h"
+#include <opencv2/opencv.hpp>
+
+// Detector ieftin de schimbare la nivelul intregului cadru, rulat inaintea mastii.
+// IR pornit/oprit, soarele iesit din nori sau o camera care vibreaza fac absdiff-ul
+// fata de fundalul lent (1%) sa marcheze aproape tot cadrul: bloburi uriase, tracker
+// ocupat secunde intregi si o avalansa de ROI-uri spre AI hub.
+//
+// Lucreaza pe o miniatura (kThumbWidth px, medie pe arii) cu propriul fundal EMA,
+// care urmareste fundalul detectorului la rezolutie mica:
+//  - sub kWideFraction din miniatura schimbata -> nimic (cazul obisnuit, cost ~ un resize)
+//  - castig/offset global (regresie liniara miniatura vs fundal) explica schimbarea
+//    -> Lighting
+//  - altfel, translatie globala intre cadre consecutive (phase correlation) care explica
+//    schimbarea (cadrul anterior mutat cu ea lasa sub kExplainedFraction diferit) -> Shake
+// La eveniment apelantul reinvata fundalul (MaskBackend::reseed), deci cadrul nu produce bloburi.
+
+enum class GlobalChange {
+    None = 0,
+    Lighting,   // global gain / offset (IR switch, sun, auto-exposure)
+    Shake       // global translation (vibration, PTZ nudge)
+};
+
+class GlobalChangeGate {
+public:
+    static constexpr int kThumbWidth = 80;
+    static constexpr double kWideFraction = 0.35;     // changed thumbnail pixels to suspect a global event
+    static constexpr double kExplainedFraction = 0.1; // still changed after the gain/offset fit or the shift -> not global
+    static constexpr double kMinShiftPx = 0.5;        // thumbnail pixels
+    static constexpr double kMinResponse = 0.2;       // phase correlation peak
+
+    // frame: 8UC1 or 8UC3, analysis resolution
+    GlobalChange analyse(const cv::Mat& frame, const CameraConfig& cfg);
+    void reset() { init = false; }
+    // Reference taken from a restored background (CV_16UC1 Q8, see MaskBackend::exportBackground)
+    void seed(const cv::Mat& q8Background);
+
+    // Estimates of the last wide change (for logs / diagnostics)
+    double gain() const { return lastGain; }
+    double offset() const { return lastOffset; }
+    cv::Point2d shift() const { return lastShift; }
+
+private:
+    // prev translated by s matches cur outside the border (pixels beyond thr < kExplainedFraction)
+    bool shiftExplains(cv::Point2d s, float thr);
+
+    cv::Mat thumb, thumbGray;
+    cv::Mat cur, prev;      // CV_32F thumbnails of the current / previous frame
+    cv::Mat reference;      // CV_32F, EMA with the detector's learning rate
+    cv::Mat window;         // Hanning window for phaseCorrelate
+    cv::Mat warped;         // prev shifted by the phase correlation estimate
+    bool init = false;
+
+    double lastGain = 1.0;
+    double lastOffset = 0.0;
+    cv::Point2d lastShift;
+};
@@ -1,7 +1,12 @@
 #pragma once
 #include <string>
-#include <cstdlib>
-#include <iostream>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include <dirent.h>
+#include <unistd.h>
 
 enum class GpuType {
     NVIDIA,
@@ -10,30 +15,78 @@ enum class GpuType {
     UNKNOWN
 };
 
-inline GpuType detectGpu() {
-    // 1. NVIDIA CUDA Check
-    // Verificăm prezența nvidia-smi
-    if (std::system("which nvidia-smi > /dev/null 2>&1") == 0) {
-        // Opțional: verificăm dacă returnează succes la execuție
-        if (std::system("nvidia-smi > /dev/null 2>&1") == 0) {
-            return GpuType::NVIDIA;
+struct HwInfo {
+    GpuType gpu = GpuType::UNKNOWN;
+    std::vector<std::string> drmDevices; // "vendor:device" (PCI ids) of /sys/class/drm/card*
+    std::string cpuModel;
+    unsigned cpuThreads = 0;
+    std::string fingerprint;             // key of the calibration cache
+};
+
+inline std::string readSysfsLine(const std::string& path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+// Descoperire hardware din sysfs / procfs, fara procese externe (nvidia-smi, lspci).
+// O singura data per proces: toti detectorii si fabrica de engine-uri folosesc acelasi rezultat.
+inline HwInfo scanHardware() {
+    HwInfo hw;
+
+    if (DIR* dir = opendir("/sys/class/drm")) {
+        while (dirent* e = readdir(dir)) {
+            std::string name = e->d_name;
+            // card0, card1 ... (nu conectorii card0-HDMI-A-1 si nici renderD*)
+            if (name.rfind("card", 0) != 0 || name.find('-') != std::string::npos) continue;
+            std::string base = "/sys/class/drm/" + name + "/device/";
+            std::string vendor = readSysfsLine(base + "vendor");
+            if (vendor.empty()) continue;
+            hw.drmDevices.push_back(vendor + ":" + readSysfsLine(base + "device"));
         }
+        closedir(dir);
     }
+    std::sort(hw.drmDevices.begin(), hw.drmDevices.end());
 
-    // 2. Intel iGPU (VAAPI / Render Nodes)
-    // Verificăm device-urile DRI specifice Intel
-    if (std::system("ls /dev/dri/renderD* > /dev/null 2>&1") == 0) {
-        // Verificare rapidă vendor via lspci
-        if (std::system("lspci | grep -i 'VGA.*Intel' > /dev/null 2>&1") == 0 ||
-            std::system("lspci | grep -i 'Display.*Intel' > /dev/null 2>&1") == 0) {
-            return GpuType::INTEL_IGPU;
-        }
+    bool nvidia = false, intel = false, amd = false;
+    for (const std::string& d : hw.drmDevices) {
+        if (d.rfind("0x10de", 0) == 0) nvidia = true;
+        if (d.rfind("0x8086", 0) == 0) intel = true;
+        if (d.rfind("0x1002", 0) == 0) amd = true;
     }
+    // Driverul proprietar NVIDIA nu expune mereu card* in drm: nodul de control il confirma
+    if (access("/dev/nvidiactl", F_OK) == 0) nvidia = true;
 
-    // 3. AMD iGPU / GPU
-    if (std::system("lspci | grep -i 'VGA.*AMD' > /dev/null 2>&1") == 0) {
-        return GpuType::AMD_IGPU;
+    if (nvidia) hw.gpu = GpuType::NVIDIA;
+    else if (intel) hw.gpu = GpuType::INTEL_IGPU;
+    else if (amd) hw.gpu = GpuType::AMD_IGPU;
+
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        // x86: "model name", ARM: "Model" / "Hardware"
+        if (line.rfind("model name", 0) == 0 || line.rfind("Model", 0) == 0 || line.rfind("Hardware", 0) == 0) {
+            size_t colon = line.find(':');
+            size_t v = colon == std::string::npos ? colon : line.find_first_not_of(" \t", colon + 1);
+            if (v != std::string::npos) hw.cpuModel = line.substr(v);
+            break;
+        }
     }
+    hw.cpuThreads = std::thread::hardware_concurrency();
+
+    std::ostringstream fp;
+    fp << hw.cpuModel << "|" << hw.cpuThreads;
+    for (const std::string& d : hw.drmDevices) fp << "|" << d;
+    hw.fingerprint = fp.str();
+    return hw;
+}
 
-    return GpuType::UNKNOWN;
+inline const HwInfo& hardwareInfo() {
+    static const HwInfo hw = scanHardware();
+    return hw;
+}
+
+inline GpuType detectGpu() {
+    return hardwareInfo().gpu;
 }
@@ -0,0 +1,114 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <cstdio>
+#include <csetjmp>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include <jpeglib.h>
+
+// Decodare JPEG redusa pentru analiza de miscare:
+// libjpeg-turbo scaleaza in domeniul DCT (1/2, 1/4, 1/8) si decodeaza doar luma,
+// deci pentru cadrul tipic fara miscare nu plătim decodare full-res color.
+
+struct JpegErrorMgr {
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+};
+
+inline void jpegErrorExit(j_common_ptr cinfo) {
+    JpegErrorMgr* err = reinterpret_cast<JpegErrorMgr*>(cinfo->err);
+    longjmp(err->jump, 1);
+}
+
+// Largest denominator (1, 2, 4, 8) that still keeps the decoded image
+// at least as large as the analysis size.
+inline int pickJpegScale(cv::Size src, cv::Size target) {
+    if (target.width <= 0 || target.height <= 0) return 1;
+    for (int d = 8; d > 1; d /= 2) {
+        int w = (src.width + d - 1) / d;
+        int h = (src.height + d - 1) / d;
+        if (w >= target.width && h >= target.height) return d;
+    }
+    return 1;
+}
+
+// Decodes only the Y channel at a reduced DCT scale picked from `target`.
+// fullSize receives the original JPEG dimensions (for mapping bboxes back).
+// Returns false if the data is not a decodable JPEG.
+// `out` is caller-owned on purpose: no C++ locals live across setjmp here.
+inline bool decodeJpegGrayScaled(const uint8_t* data, size_t len, cv::Size target,
+                                 cv::Mat& out, cv::Size* fullSize = nullptr) {
+    if (!data || len < 4) return false;
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorMgr jerr;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpegErrorExit;
+
+    if (setjmp(jerr.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<unsigned char*>(data), (unsigned long)len);
+    if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    if (fullSize) *fullSize = cv::Size((int)cinfo.image_width, (int)cinfo.image_height);
+
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = pickJpegScale(cv::Size((int)cinfo.image_width, (int)cinfo.image_height), target);
+    cinfo.out_color_space = JCS_GRAYSCALE; // YCbCr -> doar Y, fara conversie de culoare
+    cinfo.dct_method = JDCT_IFAST;         // suficient pentru o imagine care oricum se blureaza
+
+    jpeg_start_decompress(&cinfo);
+    out.create((int)cinfo.output_height, (int)cinfo.output_width, CV_8UC1);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = out.ptr<uchar>((int)cinfo.output_scanline);
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+inline bool readFileBytes(const char* path, std::vector<uint8_t>& out) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    if (!f) return false;
+    std::streamsize n = f.tellg();
+    if (n <= 0) return false;
+    out.resize((size_t)n);
+    f.seekg(0);
+    return (bool)f.read(reinterpret_cast<char*>(out.data()), n);
+}
+
+// Analysis frame: reduced-scale luma for JPEG, generic grayscale decode otherwise (PNG, ...).
+// scaleToFull: multiply analysis-space coordinates by this to get source pixels.
+inline cv::Mat decodeAnalysisFrame(const uint8_t* data, size_t len, cv::Size target, double* scaleToFull = nullptr) {
+    cv::Size full;
+    cv::Mat gray;
+    if (!decodeJpegGrayScaled(data, len, target, gray, &full)) {
+        gray = cv::imdecode(cv::Mat(1, (int)len, CV_8UC1, const_cast<uint8_t*>(data)), cv::IMREAD_GRAYSCALE);
+        full = gray.size();
+    }
+    if (scaleToFull) {
+        *scaleToFull = gray.empty() ? 1.0 : (double)full.width / gray.cols;
+    }
+    return gray;
+}
+
+// Full-resolution color decode, only needed once a track is valid and we crop a ROI
+inline cv::Mat decodeFullColor(const uint8_t* data, size_t len) {
+    return cv::imdecode(cv::Mat(1, (int)len, CV_8UC1, const_cast<uint8_t*>(data)), cv::IMREAD_COLOR);
+}
+
+// Maps an analysis-space rect to source pixels
+inline cv::Rect scaleRect(const cv::Rect& r, double s) {
+    if (s == 1.0) return r;
+    return cv::Rect((int)(r.x * s), (int)(r.y * s), (int)std::ceil(r.width * s), (int)std::ceil(r.height * s));
+}
@@ -1,14 +1,138 @@
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <turbojpeg.h>
 #include <vector>
+#include <memory>
 #include <algorithm>
+#include "raw_frame.h"
 
-inline bool encodeJPEG(const cv::Mat& bgr,
+// Encoder TurboJPEG refolosit per thread: handle-ul de compresie si bufferul de
+// iesire (dimensionat cu tjBufSize, creste doar la nevoie) supravietuiesc intre ROI-uri.
+// Compresia citeste direct din sub-view-ul strided al cadrului, fara clone.
+class TjEncoder {
+public:
+    static TjEncoder& local() {
+        static thread_local TjEncoder enc;
+        return enc;
+    }
+
+    ~TjEncoder() {
+        if (handle) tjDestroy(handle);
+    }
+
+    tjhandle get() {
+        if (!handle) handle = tjInitCompress();
+        return handle;
+    }
+
+    // Worst-case output buffer for a w x h image
+    unsigned char* buffer(int w, int h, int subsamp, unsigned long& cap) {
+        cap = tjBufSize(w, h, subsamp);
+        if (cap > capacity) {
+            buf.reset(new unsigned char[cap]);
+            capacity = cap;
+        }
+        return buf.get();
+    }
+
+    // Chroma scratch for NV12 (TurboJPEG wants planar U/V)
+    std::vector<uint8_t> chromaU, chromaV;
+
+private:
+    tjhandle handle = nullptr;
+    std::unique_ptr<unsigned char[]> buf;
+    unsigned long capacity = 0;
+};
+
+// BGR (3 canale), BGRX (4) sau gri (1); orice stride, inclusiv sub-view-uri
+inline bool encodeJPEG(const cv::Mat& img,
                        std::vector<uchar>& out,
                        int quality = 85) {
-    if (bgr.empty()) return false;
-    std::vector<int> params = {
-        cv::IMWRITE_JPEG_QUALITY, std::clamp(quality, 50, 95)
-    };
-    return cv::imencode(".jpg", bgr, out, params);
+    out.clear();
+    if (img.empty() || img.depth() != CV_8U) return false;
+
+    int pixfmt, subsamp;
+    switch (img.channels()) {
+        case 1: pixfmt = TJPF_GRAY; subsamp = TJSAMP_GRAY; break;
+        case 3: pixfmt = TJPF_BGR;  subsamp = TJSAMP_420;  break;
+        case 4: pixfmt = TJPF_BGRX; subsamp = TJSAMP_420;  break;
+        default: return false;
+    }
+
+    TjEncoder& enc = TjEncoder::local();
+    tjhandle tj = enc.get();
+    if (!tj) return false;
+
+    unsigned long size = 0;
+    unsigned char* dst = enc.buffer(img.cols, img.rows, subsamp, size);
+    if (tjCompress2(tj, img.ptr<uchar>(0), img.cols, (int)img.step, img.rows, pixfmt,
+                    &dst, &size, subsamp, std::clamp(quality, 50, 95),
+                    TJFLAG_NOREALLOC | TJFLAG_FASTDCT) != 0) {
+        return false;
+    }
+    out.assign(dst, dst + size);
+    return true;
+}
+
+// Encodes `roi` straight from YUV 4:2:0 planes (no BGR conversion).
+// The origin is rounded down to even coordinates so chroma stays in phase:
+// `encoded` (optional) receives the rect actually in the JPEG, report that one.
+inline bool encodeJPEGYuv420(const RawYuvPlanes& yuv,
+                             cv::Rect roi,
+                             std::vector<uchar>& out,
+                             int quality = 85,
+                             cv::Rect* encoded = nullptr) {
+    out.clear();
+    roi &= cv::Rect(0, 0, yuv.width, yuv.height);
+    int x0 = roi.x & ~1;
+    int y0 = roi.y & ~1;
+    int x1 = std::min(yuv.width, roi.x + roi.width);
+    int y1 = std::min(yuv.height, roi.y + roi.height);
+    const int w = x1 - x0;
+    const int h = y1 - y0;
+    if (w <= 0 || h <= 0 || !yuv.y || !yuv.u) return false;
+
+    TjEncoder& enc = TjEncoder::local();
+    tjhandle tj = enc.get();
+    if (!tj) return false;
+
+    const int cw = (w + 1) / 2;
+    const int ch = (h + 1) / 2;
+    const unsigned char* planes[3];
+    int strides[3];
+    planes[0] = yuv.y + (size_t)y0 * yuv.strideY + x0;
+    strides[0] = yuv.strideY;
+
+    if (yuv.nv12) {
+        // Deinterleave only the ROI's chroma (w*h/2 bytes)
+        enc.chromaU.resize((size_t)cw * ch);
+        enc.chromaV.resize((size_t)cw * ch);
+        for (int r = 0; r < ch; ++r) {
+            const uint8_t* src = yuv.u + (size_t)(y0 / 2 + r) * yuv.strideUV + x0;
+            uint8_t* du = enc.chromaU.data() + (size_t)r * cw;
+            uint8_t* dv = enc.chromaV.data() + (size_t)r * cw;
+            for (int c = 0; c < cw; ++c) {
+                du[c] = src[2 * c];
+                dv[c] = src[2 * c + 1];
+            }
+        }
+        planes[1] = enc.chromaU.data();
+        planes[2] = enc.chromaV.data();
+        strides[1] = strides[2] = cw;
+    } else {
+        planes[1] = yuv.u + (size_t)(y0 / 2) * yuv.strideUV + x0 / 2;
+        planes[2] = yuv.v + (size_t)(y0 / 2) * yuv.strideUV + x0 / 2;
+        strides[1] = strides[2] = yuv.strideUV;
+    }
+
+    unsigned long size = 0;
+    unsigned char* dst = enc.buffer(w, h, TJSAMP_420, size);
+    if (tjCompressFromYUVPlanes(tj, planes, w, strides, h, TJSAMP_420,
+                                &dst, &size, std::clamp(quality, 50, 95),
+                                TJFLAG_NOREALLOC | TJFLAG_FASTDCT) != 0) {
+        return false;
+    }
+    out.assign(dst, dst + size);
+    if (encoded) *encoded = cv::Rect(x0, y0, w, h);
+    return true;
 }
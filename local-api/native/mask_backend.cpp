@@ -0,0 +1,156 @@
+#include "mask_backend.h"
+#include "opencl_engine.h"
+#include "cuda_engine.h"
+#include "stripe_pool.h"
+#include <opencv2/core/ocl.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+const char* engineKindName(EngineKind kind) {
+    switch (kind) {
+        case EngineKind::OpenCL: return "opencl";
+        case EngineKind::Cuda: return "cuda";
+        default: return "cpu";
+    }
+}
+
+void CpuMaskBackend::runRegion(const cv::Mat& frame, cv::Mat& mask, const MotionKernelParams& params,
+                               bool init, const cv::Rect& region, int stripes) {
+    stripes = std::min(stripes, region.height);
+    if (stripes <= 1) {
+        runMotionKernel(frame, background, mask, params, kernelScratch, init, region);
+        return;
+    }
+
+    // Bufferele comune se aloca inainte: kernelul nu trebuie sa le realoce din mai multe fire
+    if (background.size() != frame.size() || background.type() != CV_16UC1) {
+        background.create(frame.size(), CV_16UC1);
+        init = true;
+    }
+    if (mask.size() != frame.size() || mask.type() != CV_8UC1) {
+        mask.create(frame.size(), CV_8UC1);
+    }
+
+    if ((int)stripeScratch.size() < stripes) stripeScratch.resize(stripes);
+    stripeRects.resize(stripes);
+    stripeHalo.resize(stripes);
+    for (int i = 0; i < stripes; ++i) {
+        const int y0 = region.y + region.height * i / stripes;
+        const int y1 = region.y + region.height * (i + 1) / stripes;
+        stripeRects[i] = cv::Rect(region.x, y0, region.width, y1 - y0);
+        if (init) continue;
+
+        // Halo rows belong to the neighbouring stripes, which update them concurrently:
+        // snapshot them so every stripe diffs against the background of the previous frame
+        cv::Mat& halo = stripeHalo[i];
+        halo.create(2 * kDilateRadius, frame.cols, CV_16UC1);
+        for (int j = 0; j < kDilateRadius; ++j) {
+            const int above = y0 - kDilateRadius + j;
+            const int below = y1 + j;
+            const size_t rowBytes = (size_t)frame.cols * sizeof(uint16_t);
+            if (above >= 0) std::memcpy(halo.ptr(j), background.ptr(above), rowBytes);
+            if (below < frame.rows) std::memcpy(halo.ptr(kDilateRadius + j), background.ptr(below), rowBytes);
+        }
+    }
+
+    StripePool::instance().run(stripes, [&](int i) {
+        runMotionKernel(frame, background, mask, params, stripeScratch[i], init, stripeRects[i],
+                        nullptr, init ? nullptr : &stripeHalo[i]);
+    });
+}
+
+bool CpuMaskBackend::computeMask(const cv::Mat& frame, const CameraConfig& cfg, cv::Mat& mask) {
+    // Gate pornit/oprit: semnaturile si lag-ul fundalului nu mai sunt valide
+    if (cfg.blockGate != gateEnabled) {
+        gate.reset();
+        gateEnabled = cfg.blockGate;
+    }
+
+    // Un singur sweep: gray, blur 21x21, absdiff, prag, update fundal, dilatare
+    MotionKernelParams params;
+    params.threshold = cfg.diffThreshold;
+    params.learningRate = cfg.bgLearningRate;
+
+    // Cadre de analiza mari (latime peste ~2.7k): benzi orizontale in paralel, acelasi rezultat ca un singur sweep
+    const cv::Rect full(0, 0, frame.cols, frame.rows);
+    const bool striped = cfg.parallelMinPixels > 0 && (int64_t)frame.total() >= cfg.parallelMinPixels;
+    auto stripesFor = [striped](const cv::Rect& r) {
+        return striped ? parallelStripeCount(r.height, (int64_t)r.area()) : 1;
+    };
+
+    bool init = !backgroundInit || background.size() != frame.size();
+    if (init || !cfg.blockGate) {
+        runRegion(frame, mask, params, init, full, stripesFor(full));
+        backgroundInit = true;
+        if (init) gate.reset(); // next frame re-seeds the block signatures
+        return true;
+    }
+
+    // Pre-gate: cadru static -> nimic de facut (masca ar fi goala)
+    if (!gate.analyse(frame, gateRegions, cfg.bgLearningRate)) return false;
+
+    if (gateRegions.size() != 1 || gateRegions[0].rect != full) {
+        if (mask.size() != frame.size() || mask.type() != CV_8UC1) {
+            mask.create(frame.size(), CV_8UC1);
+        }
+        mask.setTo(0);
+    }
+    // Lazy background: rata per bloc, recuperarea doar unde gate-ul a raportat-o
+    buildBlockAlpha(cfg.bgLearningRate);
+    params.blockAlphaQ15 = blockAlpha.data();
+    params.blockSize = BlockActivityGate::kBlock;
+    params.blockCols = gate.blockCols();
+    for (const GateRegion& r : gateRegions) {
+        runRegion(frame, mask, params, false, r.rect, stripesFor(r.rect));
+    }
+    return true;
+}
+
+void CpuMaskBackend::buildBlockAlpha(double rate) {
+    // Q15 weight per catch-up length, 1 - (1 - a)^(lag + 1); rebuilt when the rate changes
+    if (lagAlphaRate != rate || lagAlpha.empty()) {
+        lagAlpha.resize(BlockActivityGate::kMaxLagFrames + 1);
+        for (int lag = 0; lag <= BlockActivityGate::kMaxLagFrames; ++lag) {
+            lagAlpha[lag] = (uint16_t)motionAlphaQ15(1.0 - std::pow(1.0 - rate, lag + 1));
+        }
+        lagAlphaRate = rate;
+    }
+    const std::vector<uint16_t>& catchUp = gate.catchUpFrames();
+    blockAlpha.resize(catchUp.size());
+    for (size_t i = 0; i < catchUp.size(); ++i) {
+        blockAlpha[i] = lagAlpha[std::min<int>(catchUp[i], BlockActivityGate::kMaxLagFrames)];
+    }
+}
+
+bool CpuMaskBackend::exportBackground(cv::Mat& q8) const {
+    if (!backgroundInit || background.empty()) return false;
+    background.copyTo(q8);
+    return true;
+}
+
+void CpuMaskBackend::importBackground(const cv::Mat& q8) {
+    q8.copyTo(background);
+    backgroundInit = true;
+    gate.reset(); // block signatures are re-seeded from the next frame
+}
+
+std::unique_ptr<MaskBackend> createMaskBackend(EngineKind kind) {
+    switch (kind) {
+        case EngineKind::OpenCL:
+            if (cv::ocl::haveOpenCL()) return std::make_unique<OpenClMaskBackend>();
+            std::cerr << "[Engine] OpenCL not available, mask stage on CPU" << std::endl;
+            break;
+        case EngineKind::Cuda:
+#ifdef DSS_ENABLE_CUDA
+            return std::make_unique<CudaMaskBackend>();
+#else
+            std::cerr << "[Engine] CUDA not compiled, mask stage on CPU" << std::endl;
+            break;
+#endif
+        default:
+            break;
+    }
+    return std::make_unique<CpuMaskBackend>();
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "camera_config.h"
+#include "motion_kernel.h"
+#include "block_gate.h"
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <vector>
+
+enum class EngineKind {
+    Cpu    = 0,  // fused Q8 kernel + block gate
+    OpenCL = 1,
+    Cuda   = 2
+};
+
+const char* engineKindName(EngineKind kind);
+
+// Etapa de pixeli a detectorului: cadru -> masca binara de miscare.
+// Tot ce urmeaza (zone excluse, bloburi, tracker, filtre) e comun in MotionDetector,
+// deci backend-urile difera doar aici si folosesc aceiasi parametri din CameraConfig
+// (diffThreshold, bgLearningRate, blur 21x21, dilatare 5x5).
+class MaskBackend {
+public:
+    virtual ~MaskBackend() = default;
+
+    virtual EngineKind kind() const = 0;
+    // frame: 8UC1 (gray / Y plane) or 8UC3 (BGR). mask: CV_8UC1, frame size, 255 = motion.
+    // The first frame (or a size change) seeds the background and yields an empty mask.
+    // False: the frame is known static and `mask` was not written.
+    virtual bool computeMask(const cv::Mat& frame, const CameraConfig& cfg, cv::Mat& mask) = 0;
+    // The next computeMask seeds the background from its frame (global scene change)
+    virtual void reseed() = 0;
+
+    // Background model in the format shared by every backend: CV_16UC1, blurred gray in Q8
+    // (value * 256). Export returns false while nothing has been learned; import replaces
+    // the model, the next computeMask diffs against it (warm restart, detector_state.h).
+    virtual bool exportBackground(cv::Mat& q8) const = 0;
+    virtual void importBackground(const cv::Mat& q8) = 0;
+};
+
+// Implementarea de referinta: kernelul fuzionat (motion_kernel.h) precedat de pre-gate-ul pe blocuri
+class CpuMaskBackend : public MaskBackend {
+public:
+    EngineKind kind() const override { return EngineKind::Cpu; }
+    bool computeMask(const cv::Mat& frame, const CameraConfig& cfg, cv::Mat& mask) override;
+    void reseed() override { backgroundInit = false; }
+    bool exportBackground(cv::Mat& q8) const override;
+    void importBackground(const cv::Mat& q8) override;
+
+private:
+    // One region through the kernel, split into `stripes` horizontal stripes on the StripePool
+    void runRegion(const cv::Mat& frame, cv::Mat& mask, const MotionKernelParams& params,
+                   bool init, const cv::Rect& region, int stripes);
+
+    // Per-block background weight of this frame from the gate's catch-up lengths
+    void buildBlockAlpha(double rate);
+
+    cv::Mat background;      // CV_16UC1, Q8 fixed point (see motion_kernel.h)
+    MotionKernelScratch kernelScratch;
+    // Intra-frame stripes (cfg.parallelMinPixels): scratch + halo background per stripe
+    std::vector<MotionKernelScratch> stripeScratch;
+    std::vector<cv::Rect> stripeRects;
+    std::vector<cv::Mat> stripeHalo;
+    BlockActivityGate gate;
+    std::vector<GateRegion> gateRegions;
+    std::vector<uint16_t> blockAlpha;  // Q15, one per gate block
+    std::vector<uint16_t> lagAlpha;    // Q15 by catch-up length
+    double lagAlphaRate = -1.0;
+    bool backgroundInit = false;
+    bool gateEnabled = true;
+};
+
+// Requested backend, or the CPU one when it is not compiled in / has no device
+std::unique_ptr<MaskBackend> createMaskBackend(EngineKind kind);
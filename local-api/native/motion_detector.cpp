@@ -1,58 +1,102 @@
 #include "motion_detector.h"
-#include <numeric>
-
-#include "motion_detector.h"
+#include "stripe_pool.h"
+#include <cmath>
 #include <numeric>
 #include "hw_detect.h"
-
-MotionDetector::MotionDetector(const CameraConfig& cfg, cv::Size size)
-    : config(cfg), frameSize(size) {
-    
-    GpuType gpu = detectGpu();
-    const char* gpuStr = "UNKNOWN";
-    switch(gpu) {
-        case GpuType::NVIDIA: gpuStr = "NVIDIA GPU (CUDA Avail)"; break;
-        case GpuType::INTEL_IGPU: gpuStr = "Intel iGPU (OpenCL Ready)"; break;
-        case GpuType::AMD_IGPU: gpuStr = "AMD GPU"; break;
-        default: gpuStr = "CPU Fallback"; break;
+#include "detector_state.h"
+#include <iostream>
+
+MotionDetector::MotionDetector(const CameraConfig& cfg, cv::Size size, EngineKind backend)
+    : config(cfg), frameSize(size), analysisSize(size), maskStage(createMaskBackend(backend)) {
+    // detectGpu() citeste sysfs o singura data per proces; mesajul doar cu logarea activa
+    if (motionLogEnabled()) {
+        GpuType gpu = detectGpu();
+        const char* gpuStr = "UNKNOWN";
+        switch(gpu) {
+            case GpuType::NVIDIA: gpuStr = "NVIDIA GPU (CUDA Avail)"; break;
+            case GpuType::INTEL_IGPU: gpuStr = "Intel iGPU (OpenCL Ready)"; break;
+            case GpuType::AMD_IGPU: gpuStr = "AMD GPU"; break;
+            default: gpuStr = "CPU Fallback"; break;
+        }
+        std::cout << "[MotionDetector] Initialized on HW: " << gpuStr << std::endl;
     }
-    std::cout << "[MotionDetector] Initialized on HW: " << gpuStr << std::endl;
 }
 
-void MotionDetector::updateConfig(const CameraConfig& newCfg) {
-    this->config = newCfg;
+void MotionDetector::setAnalysisSize(cv::Size size) {
+    // Alta rezolutie de analiza = alt spatiu de coordonate: fundalul se reinvata, track-urile se pierd.
+    // Sub lock: un worker poate fi chiar in tracker.update / toAnalysis pe acest detector
+    std::lock_guard<std::mutex> lock(frameMutex);
+    if (size == analysisSize) return;
+    analysisSize = size;
+    tracker.reset();
 }
 
-cv::Mat MotionDetector::detectMotion(const cv::Mat& frame) {
-    cv::Mat gray, diff, thresh;
-    if (frame.channels() == 3) {
-        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
-    } else {
-        gray = frame.clone();
+// Injumatatire 2x2 pe benzi: la x2 exact fiecare pixel e media blocului lui 2x2, deci
+// benzile cu granite pe randuri pare dau aceiasi octeti ca un singur resize
+static void halveArea(const cv::Mat& src, cv::Mat& dst, int stripes) {
+    const cv::Size half(src.cols / 2, src.rows / 2);
+    if (stripes <= 1 || (src.cols & 1) || (src.rows & 1)) {
+        cv::resize(src, dst, half, 0, 0, cv::INTER_AREA);
+        return;
     }
+    dst.create(half, src.type());
+    StripePool::instance().run(stripes, [&](int i) {
+        const int d0 = half.height * i / stripes;
+        const int d1 = half.height * (i + 1) / stripes;
+        cv::Mat out = dst.rowRange(d0, d1);
+        cv::resize(src.rowRange(2 * d0, 2 * d1), out, out.size(), 0, 0, cv::INTER_AREA);
+    });
+}
 
-    // Gaussian Blur to reduce noise
-    cv::GaussianBlur(gray, gray, cv::Size(21, 21), 0);
-
-    if (!backgroundInit) {
-        gray.copyTo(background);
-        backgroundInit = true;
-        return cv::Mat::zeros(gray.size(), CV_8U);
+// Piramida de mediere pe arii: injumatatiri 2x2 (INTER_AREA exact x2 = medie box, rapida)
+// cat timp sursa e de cel putin doua ori mai lata, apoi un singur pas INTER_AREA la latimea tinta.
+// Pragul parallelMinPixels se aplica aici cadrului sursa: la 4K/8MP injumatatirile (cea mai
+// mare parte din cost) ruleaza pe benzi; pasul final, pe o imagine de 2-4x mai mica, ramane serial.
+const cv::Mat& MotionDetector::toAnalysis(const cv::Mat& frame) {
+    const int target = analysisSize.width;
+    if (target <= 0 || frame.cols <= target) {
+        toSource = 1.0;
+        return frame;
     }
 
-    cv::absdiff(gray, background, diff);
-    cv::threshold(diff, thresh, 25, 255, cv::THRESH_BINARY);
+    const bool striped = config.parallelMinPixels > 0 && (int64_t)frame.total() >= config.parallelMinPixels;
+    const cv::Mat* cur = &frame;
+    cv::Mat* bufs[2] = {&pyramidScratch, &analysisFrame};
+    int next = 0;
+    while (cur->cols >= 2 * target) {
+        cv::Mat* dst = bufs[next];
+        halveArea(*cur, *dst, striped ? parallelStripeCount(cur->rows / 2, (int64_t)cur->total()) : 1);
+        cur = dst;
+        next ^= 1;
+    }
+    if (cur->cols != target) {
+        const int h = std::max(1, (int)std::lround((double)cur->rows * target / cur->cols));
+        cv::Mat* dst = bufs[next];
+        cv::resize(*cur, *dst, cv::Size(target, h), 0, 0, cv::INTER_AREA);
+        cur = dst;
+    }
+    toSource = (double)frame.cols / cur->cols;
+    return *cur;
+}
 
-    cv::dilate(thresh, thresh, cv::Mat(), cv::Point(-1,-1), 2);
+cv::Size MotionDetector::getAnalysisSize() const {
+    std::lock_guard<std::mutex> lock(frameMutex);
+    return analysisSize;
+}
 
-    // Background learning (MOG approach simplified)
-    cv::addWeighted(background, 0.99, gray, 0.01, 0, background);
+void MotionDetector::updateConfig(const CameraConfig& newCfg) {
+    // Workerii pool-ului itereaza config (zonele excluse) in processFrame: inlocuirea doar sub lock
+    std::lock_guard<std::mutex> lock(frameMutex);
+    this->config = newCfg;
+}
 
-    return thresh;
+bool MotionDetector::detectMotion(const cv::Mat& frame) {
+    // Doar etapa de pixeli difera intre backend-uri; restul pipeline-ului e comun
+    return maskStage->computeMask(frame, config, motionMask);
 }
 
-void MotionDetector::applyExcludedZones(cv::Mat& mask) {
-    for (const auto& z : config.excludedZones) {
+void MotionDetector::applyExcludedZones(cv::Mat& mask, const std::vector<ExcludedZone>& zones) {
+    for (const auto& z : zones) {
         // Ensure zone is within bounds
         cv::Rect safeZone = z.zone & cv::Rect(0, 0, mask.cols, mask.rows);
         if (safeZone.area() > 0) {
@@ -61,177 +105,124 @@ void MotionDetector::applyExcludedZones(cv::Mat& mask) {
     }
 }
 
-std::vector<MotionBlob> MotionDetector::extractBlobs(const cv::Mat& mask) {
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-    std::vector<MotionBlob> blobs;
-    for (const auto& c : contours) {
-        cv::Rect r = cv::boundingRect(c);
-        double area = cv::contourArea(c);
-        
-        if (r.area() == 0) continue;
-
-        cv::Point2f centroid(
-            r.x + r.width / 2.0f,
-            r.y + r.height / 2.0f
-        );
-        blobs.push_back({r, area, centroid});
+void MotionDetector::extractBlobs(const cv::Mat& mask, int minArea) {
+    // Componente conexe pe run-uri: bbox, arie in pixeli si centroid real dintr-o trecere;
+    // bloburile sub aria minima nu sunt materializate deloc
+    blobs.clear();
+    if (config.parallelMinPixels > 0 && (int64_t)mask.total() >= config.parallelMinPixels) {
+        labeler.labelStriped(mask, minArea, blobs, parallelStripeCount(mask.rows, (int64_t)mask.total()));
+    } else {
+        labeler.label(mask, minArea, blobs);
     }
-    return blobs;
 }
 
-bool MotionDetector::passesSizeFilter(const MotionBlob& blob) {
-    double frameArea = (double)frameSize.width * frameSize.height;
-    return (blob.area / frameArea) >= config.minAreaRatio;
+bool MotionDetector::saveState(const std::string& path) {
+    std::lock_guard<std::mutex> lock(frameMutex);
+    cv::Mat background;
+    maskStage->exportBackground(background);
+    return writeDetectorState(path, config, analysisSize, frameSize, background, tracker.tracks());
 }
 
-TrackedObject* MotionDetector::updateOrCreateTrack(const MotionBlob& blob) {
-    const float MAX_DIST = 50.0f; // Pixels
-
-    // Match existing
-    for (auto& t : tracks) {
-        // Predict next position could be here? For now just simple distance
-        if (!t.centroidHistory.empty()) {
-            double dist = cv::norm(t.centroidHistory.back() - blob.centroid);
-            if (dist < MAX_DIST) {
-                t.bbox = blob.bbox;
-                t.framesAlive++;
-                t.centroidHistory.push_back(blob.centroid);
-                if (t.centroidHistory.size() > 30)
-                    t.centroidHistory.pop_front();
-
-                // Reset logic for static if it moved suddenly? No, keep history.
-                return &t;
-            }
+int MotionDetector::loadState(const std::string& path) {
+    std::lock_guard<std::mutex> lock(frameMutex);
+    DetectorStateFile file;
+    if (!file.open(path)) return 0;
+
+    const DetectorStateHeader& h = file.header();
+    // Respingerile sunt normale (config / rezolutie schimbate): doar cu logarea activa
+    if (h.analysisWidth != analysisSize.width || h.analysisHeight != analysisSize.height) {
+        if (motionLogEnabled()) {
+            std::cout << "[Native] Detector state " << path << " rejected: analysis size changed" << std::endl;
+        }
+        return 0;
+    }
+    if (h.configHash != detectorConfigHash(config)) {
+        if (motionLogEnabled()) {
+            std::cout << "[Native] Detector state " << path << " rejected: config changed" << std::endl;
         }
+        return 0;
     }
 
-    // Create new
-    TrackedObject t;
-    t.trackingId = std::to_string(cv::getTickCount());
-    t.bbox = blob.bbox;
-    t.framesAlive = 1;
-    t.centroidHistory.push_back(blob.centroid);
-    tracks.push_back(t);
-    return &tracks.back();
+    // Fundalul se copiaza din maparea fisierului direct in backend
+    frameSize = cv::Size(h.frameWidth, h.frameHeight);
+    const cv::Mat background = file.background();
+    if (!background.empty()) {
+        maskStage->importBackground(background);
+        globalGate.seed(background);
+    }
+    tracker.reset();
+    restoreTracks(file, tracker.tracks());
+    if (motionLogEnabled()) {
+        std::cout << "[Native] Detector state restored from " << path << " (" << h.trackCount << " tracks, "
+                  << (background.empty() ? "no background" : "background") << ")" << std::endl;
+    }
+    return 1;
 }
 
-bool MotionDetector::passesPersistence(const TrackedObject& track) {
-    return track.framesAlive >= config.minFrames;
+const std::vector<int>& MotionDetector::processFrame(const cv::Mat& input) {
+    std::lock_guard<std::mutex> lock(frameMutex);
+    return processFrameLocked(input);
 }
 
-bool MotionDetector::isStaticDynamic(TrackedObject& track) {
-    if (track.centroidHistory.size() < 4) return false; // Need history
-
-    // Calculate Variance
-    double meanX = 0, meanY = 0;
-    for (auto& p : track.centroidHistory) {
-        meanX += p.x;
-        meanY += p.y;
-    }
-    meanX /= track.centroidHistory.size();
-    meanY /= track.centroidHistory.size();
+const std::vector<int>& MotionDetector::processFrameLocked(const cv::Mat& input) {
+    metrics.add(STAT_FRAMES, 1);
+    uint64_t t0 = motionNowUs();
 
-    double var = 0;
-    for (auto& p : track.centroidHistory) {
-        var += (p.x - meanX)*(p.x - meanX) + (p.y - meanY)*(p.y - meanY);
-    }
-    var /= track.centroidHistory.size(); // Mean Squared Error from Centroid
+    // Detectia, tracking-ul si filtrele ruleaza in spatiul de analiza
+    const cv::Mat& frame = toAnalysis(input);
 
-    // User Rule: If variance Low AND exists for long time -> Static Dynamic
-    if (var < config.maxStaticVariance && track.framesAlive > config.minFrames) {
-        track.isStaticDynamic = true;
-        return true;
-    }
-    return false;
-}
-
-std::vector<TrackedObject> MotionDetector::processFrame(const cv::Mat& frame) {
     // 1. Update internal frame size to match actual input resolution
+    // (the mask backend re-learns its background on a size change; the tracks belong to the old space)
     if (frame.size() != this->frameSize) {
         this->frameSize = frame.size();
-        // Reset background if size changed to avoid crash?
-        // OpenCV handles reallocation usually but let's be safe
-        if (!background.empty() && background.size() != frame.size()) {
-             backgroundInit = false; // Re-learn background
-        }
+        tracker.reset();
     }
 
-    std::vector<TrackedObject> valid;
-
-    cv::Mat mask = detectMotion(frame);
-    applyExcludedZones(mask);
-
-    int nonZero = cv::countNonZero(mask);
-    if (nonZero == 0) {
-        std::cout << "[Native] Mask Zero for ID " << tracks.size() << std::endl;
-        return valid;
+    // Lumina / vibratie pe tot cadrul: fundalul se reinvata pe acest cadru (masca goala),
+    // in loc sa produca bloburi uriase timp de secunde
+    if (config.globalChangeGate) {
+        const GlobalChange change = globalGate.analyse(frame, config);
+        if (change != GlobalChange::None) {
+            metrics.add(change == GlobalChange::Lighting ? STAT_LIGHTING_EVENTS : STAT_SHAKE_EVENTS, 1);
+            maskStage->reseed();
+        }
     }
 
-    auto blobs = extractBlobs(mask);
-    
-    std::cout << "[Native] Blobs: " << blobs.size() << " NonZero: " << nonZero << std::endl;
-
-    std::vector<TrackedObject> updatedTracks;
-
-    // Radius proportional to resolution (e.g. 50px at 640w => ~8%)
-    double maxMatchDist = (double)frame.cols * 0.08; 
-    if (maxMatchDist < 20.0) maxMatchDist = 20.0; // Minimum floor
-
-    // Try to match existing tracks to blobs
-    for (auto& track : tracks) {
-        int bestBlobIdx = -1;
-        double minDst = 100000.0;
-        
-        for (int i=0; i<blobs.size(); ++i) {
-            if (blobs[i].area == -1) continue; // Already matched to previous track
-
-             double dist = cv::norm(track.centroidHistory.back() - blobs[i].centroid);
-             if (dist < maxMatchDist && dist < minDst) {
-                 minDst = dist;
-                 bestBlobIdx = i;
-             }
-        }
+    const bool active = detectMotion(frame);
+    cv::Mat& mask = motionMask;
+    if (active) applyExcludedZones(mask, config.excludedZones);
+    uint64_t t1 = motionNowUs();
+    metrics.addStage(STAGE_MASK, t1 - t0);
 
-        if (bestBlobIdx != -1) {
-            // Update Track
-            MotionBlob& b = blobs[bestBlobIdx];
-            track.bbox = b.bbox;
-            track.framesAlive++;
-            track.centroidHistory.push_back(b.centroid);
-             if (track.centroidHistory.size() > 30) track.centroidHistory.pop_front();
-            
-            updatedTracks.push_back(track);
-            
-            // Mark blob as used
-             blobs[bestBlobIdx].area = -1; 
-            
-            // Check filters
-            if (passesSizeFilter(b) && passesPersistence(track) && !isStaticDynamic(track)) {
-                valid.push_back(track);
-            }
-        }
-        // Else track is lost? We drop it here (simple logic). 
-        // Ideally we should keep it for 1-2 frames (occlusion).
+    blobs.clear();
+    int nonZero = 0;
+    if (active) {
+        nonZero = cv::countNonZero(mask);
+    } else {
+        metrics.add(STAT_GATED_FRAMES, 1);
     }
-
-    // Create new tracks for unmatched blobs
-    for (const auto& b : blobs) {
-        if (b.area == -1) continue; // used
-        
-        // Initial Size Filter for creation?
-        if (!passesSizeFilter(b)) continue; 
-        
-        TrackedObject t;
-        t.trackingId = std::to_string(cv::getTickCount() + rand()); 
-        t.bbox = b.bbox;
-        t.framesAlive = 1;
-        t.centroidHistory.push_back(b.centroid);
-        
-        updatedTracks.push_back(t);
+    metrics.set(STAT_NONZERO, (uint64_t)nonZero);
+    if (nonZero == 0) {
+        metrics.add(STAT_SKIPPED_FRAMES, 1);
+        // Greedy (istoric): masca goala nu atinge track-urile; Global: track-urile imbatranesc
+        if (config.trackerMode == TrackerMode::Greedy) {
+            metrics.maybeLog(this);
+            return tracker.hold();
+        }
+    } else {
+        // Size filter applied during labeling (same ratio as the tracker's size filter)
+        int minArea = (int)std::ceil(config.minAreaRatio * frame.cols * frame.rows);
+        extractBlobs(mask, std::max(1, minArea));
+        metrics.add(STAT_BLOBS, blobs.size());
     }
-
-    this->tracks = updatedTracks;
+    uint64_t t2 = motionNowUs();
+    metrics.addStage(STAGE_BLOB, t2 - t1);
+
+    // Asociere + filtre (greedy istoric sau global cu predictie/coasting, vezi tracker.h)
+    const std::vector<int>& valid = tracker.update(blobs, frame.size(), config);
+    metrics.addStage(STAGE_TRACK, motionNowUs() - t2);
+    metrics.set(STAT_TRACKS, (uint64_t)tracks().size());
+    metrics.add(STAT_VALID_OBJECTS, valid.size());
+    metrics.maybeLog(this);
     return valid;
 }
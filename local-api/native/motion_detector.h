@@ -1,31 +1,82 @@
 #pragma once
 #include "motion_types.h"
 #include "camera_config.h"
+#include "mask_backend.h"
+#include "global_change.h"
+#include "blob_labeler.h"
+#include "tracker.h"
+#include "detector_stats.h"
+#include "roi_result.h"
+#include <mutex>
+#include <string>
 
 class MotionDetector {
 public:
-    MotionDetector(const CameraConfig& cfg, cv::Size frameSize);
+    // backend: pixel stage only (mask_backend.h); unavailable backends fall back to CPU
+    MotionDetector(const CameraConfig& cfg, cv::Size frameSize, EngineKind backend = EngineKind::Cpu);
 
-    // Returns Valid ROI (if any)
-    std::vector<TrackedObject> processFrame(const cv::Mat& frame);
+    // Returns the slots (in tracks()) of the tracks that passed all filters.
+    // View into the detector state: valid until the next processFrame call.
+    const std::vector<int>& processFrame(const cv::Mat& frame);
+    // processFrame releases the lock on return. Callers that go on to read the results or
+    // write the tracks (ROI crops update smoothRoi) hold lockFrame() across processFrameLocked
+    // and that work, so saveState / updateConfig / other threads never see it half done.
+    std::unique_lock<std::mutex> lockFrame() const { return std::unique_lock<std::mutex>(frameMutex); }
+    const std::vector<int>& processFrameLocked(const cv::Mat& frame);
+    // Serialized with processFrame: safe while a pool worker analyses a frame of this handle
     void updateConfig(const CameraConfig& newCfg);
     const CameraConfig& getConfig() const { return config; }
+    const TrackTable& tracks() const { return tracker.tracks(); }
+    TrackTable& tracks() { return tracker.tracks(); }
+    // Analysis resolution: frames wider than analysisSize.width are reduced to that width
+    // (aspect kept) before detection, so cost and the resolution-dependent thresholds
+    // (match distance, blur footprint) no longer depend on the camera sensor.
+    // Decoders also use it to pick a reduced decode scale.
+    // Both serialized with processFrame (setAnalysisSize resets the tracker).
+    cv::Size getAnalysisSize() const;
+    void setAnalysisSize(cv::Size size);
+    // Analysis -> coordinates of the last frame passed to processFrame (1 = no reduction).
+    // Track bboxes are in analysis space: multiply by this (and by any decode scale) for source pixels.
+    double sourceScale() const { return toSource; }
+    // Per-stage latency and counters (decode/encode are recorded by the callers)
+    DetectorStats& stats() { return metrics; }
+    // Output buffers of the FFI ROI calls (one set per handle -> reentrant across handles)
+    RoiOutputBuffer& roiOutput() { return roiOut; }
+    // Backend actually running the mask stage
+    EngineKind engineKind() const { return maskStage->kind(); }
+
+    // Warm restart (detector_state.h): background model, tracks and config.
+    // Safe to call while another thread runs processFrame (serialized with it).
+    // Do not call with lockFrame() held.
+    bool saveState(const std::string& path);
+    // 1 = restored, 0 = no usable file (missing, other build, analysis size or config changed)
+    int loadState(const std::string& path);
+
+    // Clears the excluded zones (analysis-space rects, clipped to the mask) in place
+    static void applyExcludedZones(cv::Mat& mask, const std::vector<ExcludedZone>& zones);
 
 private:
     CameraConfig config;
-    cv::Size frameSize;
-
-    cv::Mat background;
-    bool backgroundInit = false;
+    cv::Size frameSize;      // analysis-space size of the last frame
+    cv::Size analysisSize;
+    double toSource = 1.0;
+    cv::Mat analysisFrame;   // reduced frame (pyramid output), reused
+    cv::Mat pyramidScratch;
 
-    std::vector<TrackedObject> tracks;
+    std::unique_ptr<MaskBackend> maskStage;
+    GlobalChangeGate globalGate;
+    cv::Mat motionMask;      // reused between frames
+    BlobLabeler labeler;
 
-    cv::Mat detectMotion(const cv::Mat& frame);
-    void applyExcludedZones(cv::Mat& mask);
-    std::vector<MotionBlob> extractBlobs(const cv::Mat& mask);
+    MotionTracker tracker;
+    std::vector<MotionBlob> blobs;     // reused between frames
+    DetectorStats metrics;
+    RoiOutputBuffer roiOut;
+    // Every mutator: processFrame (+ the ROI work under lockFrame), updateConfig,
+    // get/setAnalysisSize, saveState / loadState
+    mutable std::mutex frameMutex;
 
-    bool passesSizeFilter(const MotionBlob& blob);
-    TrackedObject* updateOrCreateTrack(const MotionBlob& blob);
-    bool passesPersistence(const TrackedObject& track);
-    bool isStaticDynamic(TrackedObject& track);
+    const cv::Mat& toAnalysis(const cv::Mat& frame);
+    bool detectMotion(const cv::Mat& frame);
+    void extractBlobs(const cv::Mat& mask, int minArea);
 };
@@ -0,0 +1,304 @@
+#include "motion_kernel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+const int16_t kGaussTapsQ8[kBlurTaps] = {
+    0, 1, 2, 4, 7, 11, 15, 20, 25, 28, 30, 28, 25, 20, 15, 11, 7, 4, 2, 1, 0
+};
+
+// Tabele SIMD (motion_kernel_simd.cpp)
+#if defined(__x86_64__) || defined(__i386__)
+extern const MotionKernelOps kMotionOpsSse4;
+extern const MotionKernelOps kMotionOpsAvx2;
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+extern const MotionKernelOps kMotionOpsNeon;
+#endif
+
+// ---------------------------------------------------------------------------
+// Scalar reference. The SIMD paths must produce exactly the same bytes.
+// ---------------------------------------------------------------------------
+
+static void hblurScalar(const uint8_t* p, int16_t* out, int n) {
+    for (int i = 0; i < n; ++i) {
+        int acc = 0;
+        for (int k = 0; k < kBlurTaps; ++k) acc += kGaussTapsQ8[k] * p[i + k];
+        out[i] = (int16_t)((acc + 1) >> 1);
+    }
+}
+
+static void vblurScalar(const int16_t* const* rows, uint16_t* out, int n) {
+    for (int i = 0; i < n; ++i) {
+        int32_t acc = 0;
+        for (int k = 0; k < kBlurTaps; ++k) acc += kGaussTapsQ8[k] * rows[k][i];
+        out[i] = (uint16_t)((acc + 64) >> 7);
+    }
+}
+
+static void diffThresholdScalar(const uint16_t* blur, const uint16_t* bg, uint8_t* thr, int n, int thrQ8) {
+    for (int i = 0; i < n; ++i) {
+        int d = std::abs((int)blur[i] - (int)bg[i]);
+        thr[i] = d > thrQ8 ? 255 : 0;
+    }
+}
+
+// |d| <= 65280 (Q8 gray) and alphaQ15 <= 32768: the product stays inside int32 for any rate
+static void bgUpdateScalar(const uint16_t* blur, const uint16_t* bgIn, uint16_t* bgOut, int n, int alphaQ15) {
+    for (int i = 0; i < n; ++i) {
+        int32_t d = (int32_t)blur[i] - (int32_t)bgIn[i];
+        bgOut[i] = (uint16_t)(bgIn[i] + ((d * alphaQ15 + 16384) >> 15));
+    }
+}
+
+static void hmax5Scalar(const uint8_t* p, uint8_t* out, int n) {
+    for (int i = 0; i < n; ++i) {
+        uint8_t m = p[i];
+        for (int k = 1; k < 5; ++k) m = std::max(m, p[i + k]);
+        out[i] = m;
+    }
+}
+
+static void vmax5Scalar(const uint8_t* const* rows, uint8_t* out, int n) {
+    for (int i = 0; i < n; ++i) {
+        uint8_t m = rows[0][i];
+        for (int k = 1; k < 5; ++k) m = std::max(m, rows[k][i]);
+        out[i] = m;
+    }
+}
+
+extern const MotionKernelOps kMotionOpsScalar = {
+    KernelIsa::Scalar, "scalar",
+    hblurScalar, vblurScalar, diffThresholdScalar, bgUpdateScalar, hmax5Scalar, vmax5Scalar
+};
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+bool motionKernelIsaSupported(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Scalar:
+            return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case KernelIsa::SSE4:
+            return __builtin_cpu_supports("sse4.1");
+        case KernelIsa::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+        case KernelIsa::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const MotionKernelOps& motionKernelOps(KernelIsa isa) {
+    if (!motionKernelIsaSupported(isa)) return kMotionOpsScalar;
+    switch (isa) {
+#if defined(__x86_64__) || defined(__i386__)
+        case KernelIsa::SSE4: return kMotionOpsSse4;
+        case KernelIsa::AVX2: return kMotionOpsAvx2;
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+        case KernelIsa::NEON: return kMotionOpsNeon;
+#endif
+        default: return kMotionOpsScalar;
+    }
+}
+
+static const MotionKernelOps& selectBestOps() {
+    if (const char* env = std::getenv("DSS_MOTION_ISA")) {
+        std::string v(env);
+        if (v == "scalar") return motionKernelOps(KernelIsa::Scalar);
+        if (v == "sse4") return motionKernelOps(KernelIsa::SSE4);
+        if (v == "avx2") return motionKernelOps(KernelIsa::AVX2);
+        if (v == "neon") return motionKernelOps(KernelIsa::NEON);
+    }
+    for (KernelIsa isa : {KernelIsa::AVX2, KernelIsa::NEON, KernelIsa::SSE4}) {
+        if (motionKernelIsaSupported(isa)) return motionKernelOps(isa);
+    }
+    return kMotionOpsScalar;
+}
+
+// Selectia activa: euristica la primul apel, inlocuita de calibrare (engine_calibration.h)
+static std::atomic<const MotionKernelOps*> activeOps{nullptr};
+
+const MotionKernelOps& motionKernelOps() {
+    const MotionKernelOps* p = activeOps.load(std::memory_order_acquire);
+    if (p) return *p;
+    static const MotionKernelOps& best = selectBestOps();
+    const MotionKernelOps* expected = nullptr;
+    activeOps.compare_exchange_strong(expected, &best, std::memory_order_acq_rel);
+    return *activeOps.load(std::memory_order_acquire);
+}
+
+void selectMotionKernelIsa(KernelIsa isa) {
+    activeOps.store(&motionKernelOps(isa), std::memory_order_release);
+}
+
+bool motionKernelIsaForced() {
+    return std::getenv("DSS_MOTION_ISA") != nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Driver
+// ---------------------------------------------------------------------------
+
+int motionAlphaQ15(double learningRate) {
+    return std::clamp((int)std::lround(learningRate * 32768.0), 0, 32768);
+}
+
+// BORDER_REFLECT_101, the default border of cv::GaussianBlur
+static inline int reflect101(int p, int len) {
+    if (len == 1) return 0;
+    while (p < 0 || p >= len) {
+        p = p < 0 ? -p : 2 * len - p - 2;
+    }
+    return p;
+}
+
+// dst[i] = gray(src(y, reflect101(c0 + i))), i in [0, c1 - c0)
+static void loadGrayRow(const cv::Mat& src, int y, int c0, int c1, uint8_t* dst) {
+    const int W = src.cols;
+    const uint8_t* row = src.ptr<uint8_t>(y);
+    const int a = std::max(c0, 0);
+    const int b = std::min(c1, W);
+
+    if (src.channels() == 1) {
+        for (int c = c0; c < a; ++c) dst[c - c0] = row[reflect101(c, W)];
+        std::memcpy(dst + (a - c0), row + a, (size_t)(b - a));
+        for (int c = b; c < c1; ++c) dst[c - c0] = row[reflect101(c, W)];
+        return;
+    }
+
+    // BGR -> gray cu aceiasi coeficienti fixed-point ca cv::cvtColor
+    auto gray = [row](int c) -> uint8_t {
+        const uint8_t* px = row + 3 * c;
+        return (uint8_t)((px[0] * 1868 + px[1] * 9617 + px[2] * 4899 + 8192) >> 14);
+    };
+    for (int c = c0; c < a; ++c) dst[c - c0] = gray(reflect101(c, W));
+    for (int c = a; c < b; ++c) dst[c - c0] = gray(c);
+    for (int c = b; c < c1; ++c) dst[c - c0] = gray(reflect101(c, W));
+}
+
+void runMotionKernel(const cv::Mat& src, cv::Mat& bg, cv::Mat& mask,
+                     const MotionKernelParams& params, MotionKernelScratch& scratch,
+                     bool init, cv::Rect region, const MotionKernelOps* ops,
+                     const cv::Mat* haloBg) {
+    const MotionKernelOps& k = ops ? *ops : motionKernelOps();
+    const int W = src.cols;
+    const int H = src.rows;
+    if (W <= 0 || H <= 0) return;
+
+    const cv::Rect full(0, 0, W, H);
+    const cv::Rect roi = region.area() > 0 ? (region & full) : full;
+    if (roi.area() <= 0) return;
+
+    if (bg.size() != src.size() || bg.type() != CV_16UC1) {
+        bg.create(src.size(), CV_16UC1);
+        init = true;
+    }
+    if (mask.size() != src.size() || mask.type() != CV_8UC1) {
+        mask.create(src.size(), CV_8UC1);
+    }
+
+    // Threshold (and blur) columns/rows: region + dilation halo
+    const int cbStart = std::max(0, roi.x - kDilateRadius);
+    const int cbEnd = std::min(W, roi.x + roi.width + kDilateRadius);
+    const int nb = cbEnd - cbStart;
+    const int tStart = std::max(0, roi.y - kDilateRadius);
+    const int tEnd = std::min(H, roi.y + roi.height + kDilateRadius);
+    const int roiEnd = roi.y + roi.height;
+    const int nOut = roi.width;
+
+    scratch.grayRow.resize((size_t)nb + 2 * kBlurRadius);
+    scratch.hRing.resize((size_t)kBlurTaps * nb);
+    scratch.blurRow.resize((size_t)nb);
+    scratch.thrRow.resize((size_t)nb + 2 * kDilateRadius);
+    scratch.maxRing.resize((size_t)5 * nOut);
+    scratch.zeroRow.assign((size_t)nOut, 0);
+
+    uint8_t* grayRow = scratch.grayRow.data();
+    int16_t* hRing = scratch.hRing.data();
+    uint16_t* blurRow = scratch.blurRow.data();
+    uint8_t* thrRow = scratch.thrRow.data();
+    uint8_t* maxRing = scratch.maxRing.data();
+    // Zero padding of the threshold row = outside-of-frame for the dilation
+    thrRow[0] = thrRow[1] = 0;
+    thrRow[nb + 2] = thrRow[nb + 3] = 0;
+
+    const int thrQ8 = params.threshold * 256;
+    const int alphaQ15 = motionAlphaQ15(params.learningRate);
+
+    const int16_t* vrows[kBlurTaps];
+    const uint8_t* mrows[5];
+    int hNext = std::max(0, tStart - kBlurRadius);
+    int mNext = roi.y;
+
+    for (int r = tStart; r < tEnd; ++r) {
+        // 1. Horizontal blur, streamed into a ring of kBlurTaps rows
+        const int need = std::min(H - 1, r + kBlurRadius);
+        for (; hNext <= need; ++hNext) {
+            loadGrayRow(src, hNext, cbStart - kBlurRadius, cbEnd + kBlurRadius, grayRow);
+            k.hblur(grayRow, hRing + (size_t)(hNext % kBlurTaps) * nb, nb);
+        }
+
+        // 2. Vertical blur of row r
+        for (int j = 0; j < kBlurTaps; ++j) {
+            vrows[j] = hRing + (size_t)(reflect101(r - kBlurRadius + j, H) % kBlurTaps) * nb;
+        }
+        k.vblur(vrows, blurRow, nb);
+
+        uint16_t* bgRow = bg.ptr<uint16_t>(r);
+        const bool inRows = r >= roi.y && r < roiEnd;
+
+        if (init) {
+            if (inRows) std::memcpy(bgRow + roi.x, blurRow + (roi.x - cbStart), (size_t)nOut * sizeof(uint16_t));
+            continue;
+        }
+
+        // 3. Diff + threshold (halo included), then background update (region only)
+        const uint16_t* diffRow = bgRow;
+        if (haloBg && !inRows) {
+            diffRow = haloBg->ptr<uint16_t>(r < roi.y ? r - (roi.y - kDilateRadius) : kDilateRadius + (r - roiEnd));
+        }
+        k.diffThreshold(blurRow, diffRow + cbStart, thrRow + kDilateRadius, nb, thrQ8);
+        if (inRows && params.blockAlphaQ15) {
+            // Runs of blocks with the same weight (usually the whole row)
+            const int bs = params.blockSize;
+            const uint16_t* rowAlpha = params.blockAlphaQ15 + (size_t)(r / bs) * params.blockCols;
+            const int xEnd = roi.x + nOut;
+            for (int x = roi.x; x < xEnd;) {
+                const int a = rowAlpha[x / bs];
+                int runEnd = std::min(xEnd, (x / bs + 1) * bs);
+                while (runEnd < xEnd && rowAlpha[runEnd / bs] == a) runEnd = std::min(xEnd, runEnd + bs);
+                k.bgUpdate(blurRow + (x - cbStart), bgRow + x, bgRow + x, runEnd - x, a);
+                x = runEnd;
+            }
+        } else if (inRows) {
+            k.bgUpdate(blurRow + (roi.x - cbStart), bgRow + roi.x, bgRow + roi.x, nOut, alphaQ15);
+        }
+
+        // 4. Horizontal dilation into a ring of 5 rows
+        k.hmax5(thrRow + (roi.x - cbStart), maxRing + (size_t)(r % 5) * nOut, nOut);
+
+        // 5. Vertical dilation: emit every mask row whose 5-row window is complete
+        while (mNext < roiEnd && std::min(H - 1, mNext + kDilateRadius) <= r) {
+            for (int j = 0; j < 5; ++j) {
+                int rr = mNext - kDilateRadius + j;
+                mrows[j] = (rr < 0 || rr >= H) ? scratch.zeroRow.data() : maxRing + (size_t)(rr % 5) * nOut;
+            }
+            k.vmax5(mrows, mask.ptr<uint8_t>(mNext) + roi.x, nOut);
+            ++mNext;
+        }
+    }
+
+    if (init) mask(roi).setTo(0);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+// Kernel fuzionat pentru masca de miscare.
+// Un singur sweep pe randuri (ring buffers de latimea cadrului, raman in cache) face:
+// gray -> blur gaussian separabil 21 tap -> diff fata de fundal -> prag ->
+// update fundal (running average) -> dilatare 5x5 (= 2 iteratii 3x3).
+// Fundalul e in virgula fixa Q8 (CV_16UC1, gray * 256), astfel incat
+// update-ul 0.99/0.01 nu mai pierde precizie ca in 8 biti.
+
+enum class KernelIsa {
+    Scalar = 0,
+    SSE4   = 1,
+    AVX2   = 2,
+    NEON   = 3
+};
+
+constexpr int kBlurTaps   = 21;
+constexpr int kBlurRadius = kBlurTaps / 2;
+constexpr int kDilateRadius = 2;
+
+// Fixed-point taps of the 21x21 Gaussian OpenCV uses for ksize 21, sigma 0 (sigma = 3.5), sum = 256
+extern const int16_t kGaussTapsQ8[kBlurTaps];
+// The outermost taps quantize to 0 in Q8, the SIMD loops skip them
+constexpr int kTapBegin = 1;
+constexpr int kTapEnd   = kBlurTaps - 1;
+
+// Per-row primitives, one implementation per ISA. All of them are bit-exact with the scalar set.
+struct MotionKernelOps {
+    KernelIsa isa;
+    const char* name;
+    // padded: gray row starting kBlurRadius px left of the first output column.
+    // out: horizontally blurred row, Q7 (gray * 128)
+    void (*hblur)(const uint8_t* padded, int16_t* out, int n);
+    // rows: kBlurTaps pointers to Q7 rows. out: blurred gray, Q8
+    void (*vblur)(const int16_t* const* rows, uint16_t* out, int n);
+    // thr[i] = |blur[i] - bg[i]| > thrQ8 ? 255 : 0
+    void (*diffThreshold)(const uint16_t* blur, const uint16_t* bg, uint8_t* thr, int n, int thrQ8);
+    // bgOut[i] = bgIn[i] + round((blur[i] - bgIn[i]) * alphaQ15 / 32768), alphaQ15 in [0, 32768].
+    // Q15 (not Q16): |diff| * alpha stays in int32 up to alpha = 1 (lazy catch-up rates reach ~0.9)
+    void (*bgUpdate)(const uint16_t* blur, const uint16_t* bgIn, uint16_t* bgOut, int n, int alphaQ15);
+    // out[i] = max(padded[i .. i + 4])
+    void (*hmax5)(const uint8_t* padded, uint8_t* out, int n);
+    // out[i] = max over the 5 rows
+    void (*vmax5)(const uint8_t* const* rows, uint8_t* out, int n);
+};
+
+struct MotionKernelParams {
+    int threshold = 25;         // gray levels
+    double learningRate = 0.01; // background weight of the current frame
+    // Optional per-block weights (lazy background of the block gate): Q15 weight of block
+    // (x / blockSize, y / blockSize), blockCols per row. Null: learningRate everywhere.
+    const uint16_t* blockAlphaQ15 = nullptr;
+    int blockSize = 0;
+    int blockCols = 0;
+};
+
+// Scratch reused between frames (no allocation in steady state). One per thread of work.
+struct MotionKernelScratch {
+    std::vector<uint8_t> grayRow;   // padded gray row
+    std::vector<int16_t> hRing;     // kBlurTaps horizontally blurred rows
+    std::vector<uint16_t> blurRow;
+    std::vector<uint8_t> thrRow;    // padded threshold row
+    std::vector<uint8_t> maxRing;   // 5 horizontally dilated rows
+    std::vector<uint8_t> zeroRow;
+};
+
+// Learning rate -> fixed-point weight used by bgUpdate (clamped to [0, 1])
+int motionAlphaQ15(double learningRate);
+
+// Active implementation: best supported by this CPU (DSS_MOTION_ISA=scalar|sse4|avx2|neon overrides)
+// until selectMotionKernelIsa() replaces it with a measured choice
+const MotionKernelOps& motionKernelOps();
+void selectMotionKernelIsa(KernelIsa isa);
+// True when DSS_MOTION_ISA is set: calibration must not override it
+bool motionKernelIsaForced();
+// Specific implementation (falls back to scalar if not compiled in / not supported by the CPU)
+const MotionKernelOps& motionKernelOps(KernelIsa isa);
+bool motionKernelIsaSupported(KernelIsa isa);
+
+// Runs the fused pipeline over `region` (default: whole frame).
+// src: 8UC1 (gray / Y plane) or 8UC3 (BGR). bg: CV_16UC1 Q8, same size as src.
+// mask: CV_8UC1, same size; only `region` is written.
+// The blur and dilation read neighbours outside `region` (halo) but only `region`
+// of the background is updated. init = true seeds the background and clears the mask.
+// haloBg (optional): CV_16UC1, 2 * kDilateRadius rows x bg.cols, background of the
+// kDilateRadius rows above and below `region` taken before the call. Halo rows are diffed
+// against it instead of bg, so neighbouring regions can run concurrently (stripes of one
+// frame) with the same result as one pass over the whole frame.
+void runMotionKernel(const cv::Mat& src, cv::Mat& bg, cv::Mat& mask,
+                     const MotionKernelParams& params, MotionKernelScratch& scratch,
+                     bool init, cv::Rect region = cv::Rect(),
+                     const MotionKernelOps* ops = nullptr,
+                     const cv::Mat* haloBg = nullptr);
@@ -0,0 +1,347 @@
+#include "motion_kernel.h"
+
+// Implementari SIMD ale primitivelor din motion_kernel.h.
+// x86: compilate cu atribute de target per functie, deci biblioteca ramane
+// portabila (fara -mavx2 global) si alegerea se face la runtime (cpuid).
+// Cozile (n % latime vector) trec prin implementarea scalara de referinta.
+
+extern const MotionKernelOps kMotionOpsScalar;
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+#define DSS_TARGET(isa) __attribute__((target(isa)))
+
+// Perechi de tap-uri (w[k], w[k+1]) pentru _mm_madd_epi16
+static inline int32_t tapPair(int k) {
+    int lo = kGaussTapsQ8[k];
+    int hi = (k + 1 < kTapEnd) ? kGaussTapsQ8[k + 1] : 0;
+    return (int32_t)(((uint32_t)hi << 16) | (uint16_t)lo);
+}
+
+// ----------------------------- SSE4.1 --------------------------------------
+
+DSS_TARGET("sse4.1")
+static void hblurSse4(const uint8_t* p, int16_t* out, int n) {
+    const __m128i one = _mm_set1_epi16(1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i acc = _mm_setzero_si128();
+        for (int k = kTapBegin; k < kTapEnd; ++k) {
+            __m128i px = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(p + i + k)));
+            acc = _mm_add_epi16(acc, _mm_mullo_epi16(px, _mm_set1_epi16(kGaussTapsQ8[k])));
+        }
+        _mm_storeu_si128((__m128i*)(out + i), _mm_srli_epi16(_mm_add_epi16(acc, one), 1));
+    }
+    if (i < n) kMotionOpsScalar.hblur(p + i, out + i, n - i);
+}
+
+DSS_TARGET("sse4.1")
+static void vblurSse4(const int16_t* const* rows, uint16_t* out, int n) {
+    const __m128i round = _mm_set1_epi32(64);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_setzero_si128();
+        __m128i hi = _mm_setzero_si128();
+        for (int k = kTapBegin; k < kTapEnd; k += 2) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(rows[k] + i));
+            __m128i b = (k + 1 < kTapEnd) ? _mm_loadu_si128((const __m128i*)(rows[k + 1] + i)) : zero;
+            __m128i w = _mm_set1_epi32(tapPair(k));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+        }
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 7);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 7);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi32(lo, hi));
+    }
+    if (i < n) {
+        const int16_t* tail[kBlurTaps];
+        for (int k = 0; k < kBlurTaps; ++k) tail[k] = rows[k] + i;
+        kMotionOpsScalar.vblur(tail, out + i, n - i);
+    }
+}
+
+DSS_TARGET("sse4.1")
+static inline __m128i thresholdMask16(__m128i b, __m128i g, __m128i thr) {
+    __m128i d = _mm_or_si128(_mm_subs_epu16(b, g), _mm_subs_epu16(g, b));
+    __m128i le = _mm_cmpeq_epi16(_mm_subs_epu16(d, thr), _mm_setzero_si128());
+    return _mm_andnot_si128(le, _mm_set1_epi16(0xFF));
+}
+
+DSS_TARGET("sse4.1")
+static void diffThresholdSse4(const uint16_t* blur, const uint16_t* bg, uint8_t* thr, int n, int thrQ8) {
+    const __m128i t = _mm_set1_epi16((short)thrQ8);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i m0 = thresholdMask16(_mm_loadu_si128((const __m128i*)(blur + i)),
+                                     _mm_loadu_si128((const __m128i*)(bg + i)), t);
+        __m128i m1 = thresholdMask16(_mm_loadu_si128((const __m128i*)(blur + i + 8)),
+                                     _mm_loadu_si128((const __m128i*)(bg + i + 8)), t);
+        _mm_storeu_si128((__m128i*)(thr + i), _mm_packus_epi16(m0, m1));
+    }
+    if (i < n) kMotionOpsScalar.diffThreshold(blur + i, bg + i, thr + i, n - i, thrQ8);
+}
+
+DSS_TARGET("sse4.1")
+static void bgUpdateSse4(const uint16_t* blur, const uint16_t* bgIn, uint16_t* bgOut, int n, int alphaQ15) {
+    const __m128i a = _mm_set1_epi32(alphaQ15);
+    const __m128i round = _mm_set1_epi32(16384);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i b = _mm_loadu_si128((const __m128i*)(blur + i));
+        __m128i g = _mm_loadu_si128((const __m128i*)(bgIn + i));
+        __m128i b0 = _mm_cvtepu16_epi32(b), b1 = _mm_cvtepu16_epi32(_mm_srli_si128(b, 8));
+        __m128i g0 = _mm_cvtepu16_epi32(g), g1 = _mm_cvtepu16_epi32(_mm_srli_si128(g, 8));
+        __m128i n0 = _mm_add_epi32(g0, _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(b0, g0), a), round), 15));
+        __m128i n1 = _mm_add_epi32(g1, _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(b1, g1), a), round), 15));
+        _mm_storeu_si128((__m128i*)(bgOut + i), _mm_packus_epi32(n0, n1));
+    }
+    if (i < n) kMotionOpsScalar.bgUpdate(blur + i, bgIn + i, bgOut + i, n - i, alphaQ15);
+}
+
+DSS_TARGET("sse4.1")
+static void hmax5Sse4(const uint8_t* p, uint8_t* out, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i m = _mm_loadu_si128((const __m128i*)(p + i));
+        for (int k = 1; k < 5; ++k) m = _mm_max_epu8(m, _mm_loadu_si128((const __m128i*)(p + i + k)));
+        _mm_storeu_si128((__m128i*)(out + i), m);
+    }
+    if (i < n) kMotionOpsScalar.hmax5(p + i, out + i, n - i);
+}
+
+DSS_TARGET("sse4.1")
+static void vmax5Sse4(const uint8_t* const* rows, uint8_t* out, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i m = _mm_loadu_si128((const __m128i*)(rows[0] + i));
+        for (int k = 1; k < 5; ++k) m = _mm_max_epu8(m, _mm_loadu_si128((const __m128i*)(rows[k] + i)));
+        _mm_storeu_si128((__m128i*)(out + i), m);
+    }
+    if (i < n) {
+        const uint8_t* tail[5];
+        for (int k = 0; k < 5; ++k) tail[k] = rows[k] + i;
+        kMotionOpsScalar.vmax5(tail, out + i, n - i);
+    }
+}
+
+extern const MotionKernelOps kMotionOpsSse4 = {
+    KernelIsa::SSE4, "sse4",
+    hblurSse4, vblurSse4, diffThresholdSse4, bgUpdateSse4, hmax5Sse4, vmax5Sse4
+};
+
+// ------------------------------ AVX2 ---------------------------------------
+
+DSS_TARGET("avx2")
+static void hblurAvx2(const uint8_t* p, int16_t* out, int n) {
+    const __m256i one = _mm256_set1_epi16(1);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i acc = _mm256_setzero_si256();
+        for (int k = kTapBegin; k < kTapEnd; ++k) {
+            __m256i px = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(p + i + k)));
+            acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(px, _mm256_set1_epi16(kGaussTapsQ8[k])));
+        }
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_srli_epi16(_mm256_add_epi16(acc, one), 1));
+    }
+    if (i < n) kMotionOpsSse4.hblur(p + i, out + i, n - i);
+}
+
+DSS_TARGET("avx2")
+static void vblurAvx2(const int16_t* const* rows, uint16_t* out, int n) {
+    const __m256i round = _mm256_set1_epi32(64);
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i lo = _mm256_setzero_si256();
+        __m256i hi = _mm256_setzero_si256();
+        for (int k = kTapBegin; k < kTapEnd; k += 2) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(rows[k] + i));
+            __m256i b = (k + 1 < kTapEnd) ? _mm256_loadu_si256((const __m256i*)(rows[k + 1] + i)) : zero;
+            __m256i w = _mm256_set1_epi32(tapPair(k));
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+        }
+        lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), 7);
+        hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), 7);
+        // unpack/pack lucreaza pe lane-uri de 128 biti, ordinea iese corecta
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_packus_epi32(lo, hi));
+    }
+    if (i < n) {
+        const int16_t* tail[kBlurTaps];
+        for (int k = 0; k < kBlurTaps; ++k) tail[k] = rows[k] + i;
+        kMotionOpsSse4.vblur(tail, out + i, n - i);
+    }
+}
+
+DSS_TARGET("avx2")
+static inline __m256i thresholdMask16Avx2(__m256i b, __m256i g, __m256i thr) {
+    __m256i d = _mm256_or_si256(_mm256_subs_epu16(b, g), _mm256_subs_epu16(g, b));
+    __m256i le = _mm256_cmpeq_epi16(_mm256_subs_epu16(d, thr), _mm256_setzero_si256());
+    return _mm256_andnot_si256(le, _mm256_set1_epi16(0xFF));
+}
+
+DSS_TARGET("avx2")
+static void diffThresholdAvx2(const uint16_t* blur, const uint16_t* bg, uint8_t* thr, int n, int thrQ8) {
+    const __m256i t = _mm256_set1_epi16((short)thrQ8);
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i m0 = thresholdMask16Avx2(_mm256_loadu_si256((const __m256i*)(blur + i)),
+                                         _mm256_loadu_si256((const __m256i*)(bg + i)), t);
+        __m256i m1 = thresholdMask16Avx2(_mm256_loadu_si256((const __m256i*)(blur + i + 16)),
+                                         _mm256_loadu_si256((const __m256i*)(bg + i + 16)), t);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(m0, m1), 0xD8);
+        _mm256_storeu_si256((__m256i*)(thr + i), packed);
+    }
+    if (i < n) kMotionOpsSse4.diffThreshold(blur + i, bg + i, thr + i, n - i, thrQ8);
+}
+
+DSS_TARGET("avx2")
+static void bgUpdateAvx2(const uint16_t* blur, const uint16_t* bgIn, uint16_t* bgOut, int n, int alphaQ15) {
+    const __m256i a = _mm256_set1_epi32(alphaQ15);
+    const __m256i round = _mm256_set1_epi32(16384);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i b0 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(blur + i)));
+        __m256i b1 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(blur + i + 8)));
+        __m256i g0 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(bgIn + i)));
+        __m256i g1 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(bgIn + i + 8)));
+        __m256i n0 = _mm256_add_epi32(g0, _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(b0, g0), a), round), 15));
+        __m256i n1 = _mm256_add_epi32(g1, _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(b1, g1), a), round), 15));
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(n0, n1), 0xD8);
+        _mm256_storeu_si256((__m256i*)(bgOut + i), packed);
+    }
+    if (i < n) kMotionOpsSse4.bgUpdate(blur + i, bgIn + i, bgOut + i, n - i, alphaQ15);
+}
+
+DSS_TARGET("avx2")
+static void hmax5Avx2(const uint8_t* p, uint8_t* out, int n) {
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i m = _mm256_loadu_si256((const __m256i*)(p + i));
+        for (int k = 1; k < 5; ++k) m = _mm256_max_epu8(m, _mm256_loadu_si256((const __m256i*)(p + i + k)));
+        _mm256_storeu_si256((__m256i*)(out + i), m);
+    }
+    if (i < n) kMotionOpsSse4.hmax5(p + i, out + i, n - i);
+}
+
+DSS_TARGET("avx2")
+static void vmax5Avx2(const uint8_t* const* rows, uint8_t* out, int n) {
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i m = _mm256_loadu_si256((const __m256i*)(rows[0] + i));
+        for (int k = 1; k < 5; ++k) m = _mm256_max_epu8(m, _mm256_loadu_si256((const __m256i*)(rows[k] + i)));
+        _mm256_storeu_si256((__m256i*)(out + i), m);
+    }
+    if (i < n) {
+        const uint8_t* tail[5];
+        for (int k = 0; k < 5; ++k) tail[k] = rows[k] + i;
+        kMotionOpsSse4.vmax5(tail, out + i, n - i);
+    }
+}
+
+extern const MotionKernelOps kMotionOpsAvx2 = {
+    KernelIsa::AVX2, "avx2",
+    hblurAvx2, vblurAvx2, diffThresholdAvx2, bgUpdateAvx2, hmax5Avx2, vmax5Avx2
+};
+
+#endif // x86
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+
+// ------------------------------ NEON ---------------------------------------
+
+static void hblurNeon(const uint8_t* p, int16_t* out, int n) {
+    const uint16x8_t one = vdupq_n_u16(1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t acc = vdupq_n_u16(0);
+        for (int k = kTapBegin; k < kTapEnd; ++k) {
+            acc = vmlaq_n_u16(acc, vmovl_u8(vld1_u8(p + i + k)), (uint16_t)kGaussTapsQ8[k]);
+        }
+        vst1q_s16(out + i, vreinterpretq_s16_u16(vshrq_n_u16(vaddq_u16(acc, one), 1)));
+    }
+    if (i < n) kMotionOpsScalar.hblur(p + i, out + i, n - i);
+}
+
+static void vblurNeon(const int16_t* const* rows, uint16_t* out, int n) {
+    const int32x4_t round = vdupq_n_s32(64);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int32x4_t lo = vdupq_n_s32(0);
+        int32x4_t hi = vdupq_n_s32(0);
+        for (int k = kTapBegin; k < kTapEnd; ++k) {
+            int16x8_t r = vld1q_s16(rows[k] + i);
+            lo = vmlal_n_s16(lo, vget_low_s16(r), kGaussTapsQ8[k]);
+            hi = vmlal_n_s16(hi, vget_high_s16(r), kGaussTapsQ8[k]);
+        }
+        lo = vshrq_n_s32(vaddq_s32(lo, round), 7);
+        hi = vshrq_n_s32(vaddq_s32(hi, round), 7);
+        vst1q_u16(out + i, vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi)));
+    }
+    if (i < n) {
+        const int16_t* tail[kBlurTaps];
+        for (int k = 0; k < kBlurTaps; ++k) tail[k] = rows[k] + i;
+        kMotionOpsScalar.vblur(tail, out + i, n - i);
+    }
+}
+
+static void diffThresholdNeon(const uint16_t* blur, const uint16_t* bg, uint8_t* thr, int n, int thrQ8) {
+    const uint16x8_t t = vdupq_n_u16((uint16_t)thrQ8);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t d = vabdq_u16(vld1q_u16(blur + i), vld1q_u16(bg + i));
+        vst1_u8(thr + i, vmovn_u16(vcgtq_u16(d, t)));
+    }
+    if (i < n) kMotionOpsScalar.diffThreshold(blur + i, bg + i, thr + i, n - i, thrQ8);
+}
+
+static void bgUpdateNeon(const uint16_t* blur, const uint16_t* bgIn, uint16_t* bgOut, int n, int alphaQ15) {
+    const int32x4_t round = vdupq_n_s32(16384);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t b = vld1q_u16(blur + i);
+        uint16x8_t g = vld1q_u16(bgIn + i);
+        int32x4_t g0 = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(g)));
+        int32x4_t g1 = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(g)));
+        int32x4_t d0 = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(b))), g0);
+        int32x4_t d1 = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(b))), g1);
+        int32x4_t n0 = vaddq_s32(g0, vshrq_n_s32(vmlaq_n_s32(round, d0, alphaQ15), 15));
+        int32x4_t n1 = vaddq_s32(g1, vshrq_n_s32(vmlaq_n_s32(round, d1, alphaQ15), 15));
+        vst1q_u16(bgOut + i, vcombine_u16(vqmovun_s32(n0), vqmovun_s32(n1)));
+    }
+    if (i < n) kMotionOpsScalar.bgUpdate(blur + i, bgIn + i, bgOut + i, n - i, alphaQ15);
+}
+
+static void hmax5Neon(const uint8_t* p, uint8_t* out, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t m = vld1q_u8(p + i);
+        for (int k = 1; k < 5; ++k) m = vmaxq_u8(m, vld1q_u8(p + i + k));
+        vst1q_u8(out + i, m);
+    }
+    if (i < n) kMotionOpsScalar.hmax5(p + i, out + i, n - i);
+}
+
+static void vmax5Neon(const uint8_t* const* rows, uint8_t* out, int n) {
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t m = vld1q_u8(rows[0] + i);
+        for (int k = 1; k < 5; ++k) m = vmaxq_u8(m, vld1q_u8(rows[k] + i));
+        vst1q_u8(out + i, m);
+    }
+    if (i < n) {
+        const uint8_t* tail[5];
+        for (int k = 0; k < 5; ++k) tail[k] = rows[k] + i;
+        kMotionOpsScalar.vmax5(tail, out + i, n - i);
+    }
+}
+
+extern const MotionKernelOps kMotionOpsNeon = {
+    KernelIsa::NEON, "neon",
+    hblurNeon, vblurNeon, diffThresholdNeon, bgUpdateNeon, hmax5Neon, vmax5Neon
+};
+
+#endif // NEON
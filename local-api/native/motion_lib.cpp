@@ -1,7 +1,123 @@
 #include "motion_detector.h"
+#include "batch_processor.h"
+#include "stream_ingest.h"
+#include "engine_calibration.h"
+#include "frame_ring.h"
+#include "raw_frame.h"
+#include "jpeg_decode.h"
+#include "roi_crop.h"
+#include "jpeg_encode.h"
+#include "roi_result.h"
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
+// Frame state shared by the ROI entry points
+struct RoiFrame {
+    cv::Mat fullFrame;                      // full-resolution source (color, or Y plane for YUV)
+    double scaleToFull = 1.0;               // analysis -> source coordinates
+    const RawYuvPlanes* yuv = nullptr;      // set: encode straight from the YUV planes
+    const std::vector<int>* validSlots = nullptr;
+    uint64_t encodeStartUs = 0;
+};
+
+// Analysis decode + detection; the full-resolution color decode only runs
+// when at least one track passed the filters. False = nothing to encode.
+// lock: taken after the analysis decode, held by the caller until the ROIs are written.
+static bool analyseFileForRois(MotionDetector* detector, const char* imagePath, RoiFrame& rf,
+                               std::unique_lock<std::mutex>& lock) {
+    static thread_local std::vector<uint8_t> fileBuf;
+    uint64_t t0 = motionNowUs();
+    cv::Mat frame;
+    if (readFileBytes(imagePath, fileBuf)) {
+        frame = decodeAnalysisFrame(fileBuf.data(), fileBuf.size(), detector->getAnalysisSize(), &rf.scaleToFull);
+    }
+    detector->stats().addStage(STAGE_DECODE, motionNowUs() - t0);
+    if (frame.empty()) {
+        detector->stats().add(STAT_SKIPPED_FRAMES, 1);
+        return false;
+    }
+
+    lock = detector->lockFrame();
+    detector->roiOutput().bytes.clear();
+    rf.validSlots = &detector->processFrameLocked(frame);
+    if (rf.validSlots->empty()) return false;
+
+    // Lazy full-res color decode: only now that a track passed the filters
+    rf.encodeStartUs = motionNowUs();
+    rf.fullFrame = decodeFullColor(fileBuf.data(), fileBuf.size());
+    return !rf.fullFrame.empty();
+}
+
+// Crops (with the track's persistent EMA state) and encodes one track.
+// Called with the detector's lockFrame() held (smoothRoi is detector state).
+static bool encodeTrackRoi(MotionDetector* detector, const RoiFrame& rf, int slot,
+                           RoiResult& r, std::vector<uint8_t>& jpeg) {
+    TrackTable& tt = detector->tracks();
+
+    // BBox-ul e in spatiul de analiza (decodare redusa + piramida detectorului) -> rezolutia sursei
+    cv::Rect fullBox = scaleRect(tt.bbox[slot], rf.scaleToFull * detector->sourceScale());
+    cv::Rect crop;
+    cv::Mat roi = cropROI(rf.fullFrame, fullBox, detector->getConfig().roiPadding, tt.smoothRoi[slot], &crop);
+    if (roi.empty()) return false;
+
+    // Crop-ul e un view in cadrul sursa; TurboJPEG comprima direct din el.
+    // Din YUV originea e aliniata la par: crop devine dreptunghiul real din JPEG
+    bool ok = rf.yuv ? encodeJPEGYuv420(*rf.yuv, crop, jpeg, 85, &crop) : encodeJPEG(roi, jpeg, 85);
+    if (!ok) return false;
+
+    r.trackId = tt.id[slot];
+    r.x = fullBox.x;
+    r.y = fullBox.y;
+    r.w = fullBox.width;
+    r.h = fullBox.height;
+    r.cropX = crop.x;
+    r.cropY = crop.y;
+    r.cropW = crop.width;
+    r.cropH = crop.height;
+    r.offset = 0;
+    r.len = (int32_t)jpeg.size();
+    return true;
+}
+
+// Encodes every valid track of rf (largest first) into results + arena / handle buffer
+static int writeRois(MotionDetector* detector, const RoiFrame& rf, RoiResult* results, int maxResults,
+                     uint8_t* arena, int arenaSize) {
+    RoiOutputBuffer& ob = detector->roiOutput();
+    const TrackTable& tt = detector->tracks();
+    ob.order.assign(rf.validSlots->begin(), rf.validSlots->end());
+    std::sort(ob.order.begin(), ob.order.end(), [&tt](int a, int b) {
+        return tt.bbox[a].area() > tt.bbox[b].area();
+    });
+
+    int n = 0;
+    size_t used = 0;
+    for (int slot : ob.order) {
+        if (n == maxResults) break;
+        RoiResult& r = results[n];
+        if (!encodeTrackRoi(detector, rf, slot, r, ob.encodeScratch)) continue;
+
+        const size_t len = ob.encodeScratch.size();
+        r.len = (int32_t)len;
+        if (arena) {
+            if (arenaSize >= 0 && used + len <= (size_t)arenaSize) {
+                std::memcpy(arena + used, ob.encodeScratch.data(), len);
+                r.offset = (int32_t)used;
+                used += len;
+            } else {
+                r.offset = -1;
+            }
+        } else {
+            r.offset = (int32_t)ob.bytes.size();
+            ob.bytes.insert(ob.bytes.end(), ob.encodeScratch.begin(), ob.encodeScratch.end());
+        }
+        ++n;
+    }
+    detector->stats().addStage(STAGE_ENCODE, motionNowUs() - rf.encodeStartUs);
+    return n;
+}
+
 // C-Compatible Interface for Node.js (Koffi/FFI)
 
 extern "C" {
@@ -19,12 +135,62 @@ extern "C" {
         cfg.maxStaticVariance = maxStaticVariance;
         // Excluded zones would need complex passing, for now empty.
 
-        MotionDetector* detector = new MotionDetector(cfg, cv::Size(width, height));
+        // Detectorul e engine-ul CPU: din calibrare conteaza ISA-ul kernel-ului.
+        // Fara masurare pe firul apelantului (event loop-ul Node): cache sau euristica,
+        // calibrarea ruleaza in fundal la prima pornire pe hardware nou.
+        const EngineChoice choice = engineChoiceNow(cv::Size(width, height));
+        if (!motionKernelIsaForced() && choice.measuredIsa()) selectMotionKernelIsa(choice.cpuIsa);
+
+        MotionDetector* detector = new MotionDetector(cfg, cv::Size(width, height), EngineKind::Cpu);
         return (void*)detector;
     }
 
+    // Same detector with the mask stage on a chosen backend: 0 = CPU, 1 = OpenCL, 2 = CUDA,
+    // -1 = calibrated choice (engine_calibration.h; heuristic until a first-run background
+    // calibration finishes, never measured on this thread). Blobs, tracking, filters and every
+    // process_* / ROI / ingest call are shared, only the pixel work moves.
+    void* create_detector_engine(int width, int height, double minAreaRatio, int minFrames,
+                                 double maxStaticVariance, int engine) {
+        CameraConfig cfg;
+        cfg.minAreaRatio = minAreaRatio;
+        cfg.minFrames = minFrames;
+        cfg.maxStaticVariance = maxStaticVariance;
+
+        // Alegerea cunoscuta (cache) sau euristica pana termina calibrarea din fundal;
+        // ISA-ul kernel-ului CPU conteaza si cu backend explicit (blob-uri, fallback)
+        const EngineChoice choice = engineChoiceNow(cv::Size(width, height));
+        if (!motionKernelIsaForced() && choice.measuredIsa()) selectMotionKernelIsa(choice.cpuIsa);
+        EngineKind kind = engine >= 0 && engine <= (int)EngineKind::Cuda ? (EngineKind)engine : choice.kind;
+
+        MotionDetector* detector = new MotionDetector(cfg, cv::Size(width, height), kind);
+        return (void*)detector;
+    }
+
+    // Backend actually running the mask stage (after fallback), -1 for an invalid handle
+    int get_detector_engine(void* handle) {
+        if (!handle) return -1;
+        return (int)((MotionDetector*)handle)->engineKind();
+    }
+
+    // Warm restart: background model + tracks + config in a versioned binary file
+    // (detector_state.h). Save is atomic and may run while frames are being processed.
+    // Load belongs right after creation / configuration; it returns 1 when restored and
+    // 0 when the file is missing or was rejected (other build, analysis size or config).
+    int save_detector_state(void* handle, const char* path) {
+        if (!handle || !path) return 0;
+        return ((MotionDetector*)handle)->saveState(path) ? 1 : 0;
+    }
+
+    int load_detector_state(void* handle, const char* path) {
+        if (!handle || !path) return 0;
+        return ((MotionDetector*)handle)->loadState(path);
+    }
+
     void destroy_detector(void* handle) {
         if (handle) {
+            // Oprim ingestia care conduce detectorul si asteptam cadrele deja trimise in pool
+            StreamIngestor::instance().stopDetector((MotionDetector*)handle);
+            FrameBatchProcessor::instance().drain((MotionDetector*)handle);
             delete (MotionDetector*)handle;
         }
     }
@@ -36,18 +202,27 @@ extern "C" {
         if (!handle) return 0;
         MotionDetector* detector = (MotionDetector*)handle;
 
-        cv::Mat frame = cv::imread(imagePath);
+        // Luma-only, DCT-scaled decode: the detector only needs a blurred gray image
+        static thread_local std::vector<uint8_t> fileBuf;
+        uint64_t t0 = motionNowUs();
+        cv::Mat frame;
+        if (readFileBytes(imagePath, fileBuf)) {
+            frame = decodeAnalysisFrame(fileBuf.data(), fileBuf.size(), detector->getAnalysisSize());
+        }
+        detector->stats().addStage(STAGE_DECODE, motionNowUs() - t0);
         if (frame.empty()) {
-            std::cout << "[Native] Failed to load frame: " << imagePath << std::endl;
+            detector->stats().add(STAT_SKIPPED_FRAMES, 1);
+            if (motionLogEnabled()) std::cout << "[Native] Failed to load frame: " << imagePath << std::endl;
             return 0;
         }
 
-        std::vector<TrackedObject> validObjs = detector->processFrame(frame);
+        auto lock = detector->lockFrame();
+        const std::vector<int>& validSlots = detector->processFrameLocked(frame);
         
         // Debugging
-        // std::cout << "[Native] Valid Objects: " << validObjs.size() << std::endl;
+        // std::cout << "[Native] Valid Objects: " << validSlots.size() << std::endl;
         
-        return validObjs.empty() ? 0 : 1;
+        return validSlots.empty() ? 0 : 1;
     }
 
     // Process Frame from Buffer (More efficient)
@@ -55,153 +230,298 @@ extern "C" {
         if (!handle) return 0;
         MotionDetector* detector = (MotionDetector*)handle;
 
-        // Decode buffer
-        std::vector<uchar> data(buffer, buffer + len);
-        cv::Mat frame = cv::imdecode(data, cv::IMREAD_COLOR);
-        
+        // Decode straight from caller memory (no copy), reduced-scale luma only
+        if (!buffer || len <= 0) return 0;
+        uint64_t t0 = motionNowUs();
+        cv::Mat frame = decodeAnalysisFrame(buffer, (size_t)len, detector->getAnalysisSize());
+        detector->stats().addStage(STAGE_DECODE, motionNowUs() - t0);
+
+        if (frame.empty()) {
+            detector->stats().add(STAT_SKIPPED_FRAMES, 1);
+            return 0;
+        }
+
+        auto lock = detector->lockFrame();
+        const std::vector<int>& validSlots = detector->processFrameLocked(frame);
+        return validSlots.empty() ? 0 : 1;
+    }
+
+    // Process Raw Pixels (zero-copy)
+    // ptr: caller memory, valid for the duration of the call. stride: bytes per row
+    // (of the Y plane for NV12/I420; I420 chroma rows are (stride + 1) / 2).
+    // pixfmt: RawPixelFormat (BGR24, GRAY8, NV12, I420).
+    // YUV input is analysed directly on its Y plane, no decode and no color conversion.
+    int process_frame_raw(void* handle, const unsigned char* ptr, int width, int height, int stride, int pixfmt) {
+        if (!handle) return 0;
+        MotionDetector* detector = (MotionDetector*)handle;
+
+        cv::Mat frame = wrapRawFrame(ptr, width, height, stride, pixfmt);
         if (frame.empty()) return 0;
 
-        std::vector<TrackedObject> validObjs = detector->processFrame(frame);
-        return validObjs.empty() ? 0 : 1;
+        auto lock = detector->lockFrame();
+        const std::vector<int>& validSlots = detector->processFrameLocked(frame);
+        return validSlots.empty() ? 0 : 1;
     }
 
-    // NEW: Get Best ROI JPEG
-    // Returns byte array pointer and sets len. Caller must copy or use immediately. 
-    // This is stateful: it relies on the LAST processed frame? 
-    // No, MotionDetector doesn't store the last frame. 
-    // We should pass the image path again OR modify process_frame to return the JPEG buffer.
-    // For simplicity and to avoid re-reading: let's make a new function "process_and_get_roi"
-    
-    // Global buffer for simple FFI return (not thread safe per instance, but safe if single threaded JS loop)
-    // Better: Allow passing a callback or a buffer.
-    // Simplest for Koffi: Return a struct with pointer and length.
-    
+    // Batch API: N cameras at once on the native worker pool.
+    // Frames of the same handle run in submission order, different handles in parallel.
+    // Returns batch id (> 0), or -1 on invalid input. Never blocks the caller.
+    int submit_frame_batch(void** handles, const char** imagePaths, int count) {
+        return FrameBatchProcessor::instance().submit((MotionDetector**)handles, imagePaths, count);
+    }
+
+    // Non-blocking completion check.
+    // Returns 1 when done (results[i] = 1 if camera i has valid motion), 0 if pending, -1 unknown id.
+    int poll_frame_batch(int batchId, int* results, int count) {
+        return FrameBatchProcessor::instance().poll(batchId, results, count);
+    }
+
+    int get_worker_count() {
+        return FrameBatchProcessor::instance().workerCount();
+    }
+
+    // Metrics snapshot, no locks (see detector_stats.h for the layout).
+    // out: count uint64 values. Returns the number of values written.
+    int get_detector_stats(void* handle, uint64_t* out, int count) {
+        if (!handle || !out || count <= 0) return 0;
+        return ((MotionDetector*)handle)->stats().snapshot(out, count);
+    }
+
+    // Single best ROI (legacy API, kept for existing callers).
+    // data points into the handle's own buffer: valid until the next ROI call on the
+    // same handle or release_roi_buffer(). Prefer process_frame_file_rois.
     struct JpegResult {
         uint8_t* data;
         int len;
         int x, y, w, h; // BBox on original
     };
 
-    // Static buffer to hold the result of the last call (simplification for FFI)
-    std::vector<uchar> lastJpegBuffer;
-    JpegResult lastResult = { nullptr, 0, 0,0,0,0 };
+    JpegResult process_frame_file_roi(void* handle, const char* imagePath) {
+        JpegResult result = { nullptr, 0, 0,0,0,0 };
+        if (!handle) return result;
+        MotionDetector* detector = (MotionDetector*)handle;
 
-#include "roi_crop.h"
-#include "jpeg_encode.h"
+        RoiFrame rf;
+        std::unique_lock<std::mutex> lock;
+        if (!analyseFileForRois(detector, imagePath, rf, lock)) return result;
 
-    JpegResult process_frame_file_roi(void* handle, const char* imagePath) {
-        lastResult.data = nullptr;
-        lastResult.len = 0;
-        
-        if (!handle) return lastResult;
+        // Pick best object: largest area (view into the detector's track table, no copies)
+        const TrackTable& tt = detector->tracks();
+        int best = *std::max_element(rf.validSlots->begin(), rf.validSlots->end(),
+            [&tt](int a, int b) {
+                return tt.bbox[a].area() < tt.bbox[b].area();
+             });
+
+        RoiOutputBuffer& ob = detector->roiOutput();
+        RoiResult r;
+        if (!encodeTrackRoi(detector, rf, best, r, ob.bytes)) return result;
+        detector->stats().addStage(STAGE_ENCODE, motionNowUs() - rf.encodeStartUs);
+
+        result.data = ob.bytes.data();
+        result.len = (int)ob.bytes.size();
+        result.x = r.x;
+        result.y = r.y;
+        result.w = r.w;
+        result.h = r.h;
+        return result;
+    }
+
+    // All valid ROIs of one frame, largest first, reentrant per handle.
+    // results: caller array of maxResults entries.
+    // arena/arenaSize: caller memory for the JPEG bytes. A ROI that does not fit gets
+    // offset = -1 and len = bytes needed. With arena == NULL the bytes go to the
+    // handle's own buffer (get_roi_buffer / release_roi_buffer).
+    // Returns the number of results written, or -1 on invalid input.
+    int process_frame_file_rois(void* handle, const char* imagePath, RoiResult* results, int maxResults,
+                                uint8_t* arena, int arenaSize) {
+        if (!handle || !results || maxResults <= 0) return -1;
         MotionDetector* detector = (MotionDetector*)handle;
 
-        cv::Mat frame = cv::imread(imagePath);
-        if (frame.empty()) return lastResult;
+        RoiFrame rf;
+        std::unique_lock<std::mutex> lock;
+        if (!analyseFileForRois(detector, imagePath, rf, lock)) return 0;
 
-        std::vector<TrackedObject> validObjs = detector->processFrame(frame);
-        
-        if (validObjs.empty()) return lastResult;
+        return writeRois(detector, rf, results, maxResults, arena, arenaSize);
+    }
 
-        // Pick best object (largest? or oldest?)
-        // Let's pick largest area
-        auto best = std::max_element(validObjs.begin(), validObjs.end(), 
-            [](const TrackedObject& a, const TrackedObject& b) {
-                return a.bbox.area() < b.bbox.area();
-             });
-        
-        // TrackedObject& obj = *best; // Can't reference local, but validObjs is local. 
-        // We need to keep state? 
-        // MotionDetector keeps tracks state. validObjs is copy.
-        // We can use the copy.
-
-        // Crop & Encode
-        // We need to access smoothState from the internal track in detector?
-        // detector->processFrame() uses member tracks. 
-        // validObjs are COPIES of the internal tracks state at that moment. 
-        // So smoothRoiState is present but updated locallly in processFrame?
-        // Wait, processFrame in motion_detector.cpp returns copies. 
-        // And it updates internal state.
-        // So taking smoothRoiState from checking existing internal tracks is hard without exposing them.
-        // For now, let's use the smoothRoiState returned in validObj (which was updated in processFrame if we modify processFrame to update it).
-        // BUT processFrame currently just copies bbox. 
-        // We need to ensure smoothRoiState is preserved in MotionDetector tracks.
-        
-        // ISSUE: motion_detector.cpp processFrame updates internal tracks. 
-        // `valid.push_back(track)` makes a copy.
-        // The internal track has the persisted smoothRoiState.
-        // The copy has it too. 
-        // Next frame, we match blobs to internal tracks.
-        // So passing `best->smoothRoiState` into cropROI works perfectly for the Current frame.
-        // BUT `cropROI` updates `smoothState` reference.
-        // This update happens on the COPY in validObjs.
-        // It does NOT update the internal track state in MotionDetector for the NEXT frame.
-        // This defeats the purpose of EMA stabilization over time.
-        
-        // FIX: We need to perform the cropping logic INSIDE MotionDetector or expose a way to update state.
-        // OR: We just trust bbox stabilization from tracking? 
-        // No, `smoothRectEMA` is for ROI stabilization separate from Tracking BBox stabilization (though similar).
-        
-        // User said: "In pipeline after filters: cropROI(..., track.smoothRoiState)".
-        // This implies track.smoothRoiState PERSISTS.
-        // So I need to ensure `MotionDetector` tracks persist this field.
-        // I added it to Struct. 
-        // `processFrame` updates `this->tracks`.
-        // So `this->tracks` holds the state.
-        
-        // BUT `cropROI` is called HERE in `motion_lib.cpp`.
-        // It updates `smoothState`.
-        // If I call it on `*best` (which is a copy from `validObjs`), the update is lost.
-        
-        // SOLUTION: ROI Crop should arguably be part of the `MotionDetector` output generation or I should access the real track.
-        // Simplest "hack": Just rely on the BBox from tracking which is somewhat stable? 
-        // User specifically asked for `smoothRectEMA`.
-        
-        // I will implement a `getBestTrackROI` method in `MotionDetector`?
-        // No, I'll modify `process_frame_file_roi` to be independent for now or minimize jitter effects.
-        // Actually, if I can't persist the smooth state easily via this API, I might just skip EMA or use the BBox directly.
-        // But user provided code for EMA.
-        
-        // Let's modify `MotionDetector::processFrame` to optionally return `TrackedObject*` (pointers to internal) or update `motion_detector.cpp` to include ROI Logic?
-        // No, keep separation.
-        
-        // I'll accept that validObjs are copies. 
-        // If I want EMA stabilization of the Crop Window, I must store that state in `MotionDetector::tracks`.
-        // `processFrame` returns copies.
-        // If I calculate ROI here, I can't save the new EMA state back to `MotionDetector` easily.
-        
-        // OK, I will assume for this MVP that I just crop based on the BBox + Padding.
-        // The BBox itself comes from `updateOrCreateTrack` which matches blobs. Blobs are noisy.
-        // So jitter IS an issue.
-        
-        // I will implement a simpler version: Just Crop BBox + Padding. 
-        // The EMA part requires architecture change (MotionDetector returning pointers or handling crop).
-        // I will skip EMA state update for now and just use `expandRect`.
-        // User asked for "Implementeaza si asta si apoi incepem verificarile".
-        // I'll do my best.
-        
-        cv::Rect smoothState = best->bbox; // Init with current
-        // (We lose history, effectively alpha=1.0)
-        
-        cv::Mat roi = cropROI(frame, best->bbox, 0.2, smoothState); 
-        
-        if (roi.empty()) return lastResult;
+    // Same as process_frame_file_rois for raw caller memory (see process_frame_raw).
+    // BGR24 / GRAY8 ROIs are compressed from strided views of ptr; NV12 / I420 ROIs are
+    // compressed straight from the YUV planes (Y plane followed by chroma in the same buffer).
+    int process_frame_raw_rois(void* handle, const unsigned char* ptr, int width, int height, int stride, int pixfmt,
+                               RoiResult* results, int maxResults, uint8_t* arena, int arenaSize) {
+        if (!handle || !results || maxResults <= 0) return -1;
+        MotionDetector* detector = (MotionDetector*)handle;
 
-        lastJpegBuffer.clear();
-        encodeJPEG(roi, lastJpegBuffer, 85);
-        
-        lastResult.data = lastJpegBuffer.data();
-        lastResult.len = lastJpegBuffer.size();
-        lastResult.x = best->bbox.x;
-        lastResult.y = best->bbox.y;
-        lastResult.w = best->bbox.width;
-        lastResult.h = best->bbox.height;
-        
-        return lastResult;
+        cv::Mat frame = wrapRawFrame(ptr, width, height, stride, pixfmt);
+        if (frame.empty()) return -1;
+
+        RoiFrame rf;
+        RawYuvPlanes yuv;
+        if (wrapRawYuv(ptr, width, height, stride, pixfmt, yuv)) rf.yuv = &yuv;
+
+        auto lock = detector->lockFrame();
+        detector->roiOutput().bytes.clear();
+        rf.validSlots = &detector->processFrameLocked(frame);
+        if (rf.validSlots->empty()) return 0;
+
+        rf.fullFrame = frame;
+        rf.encodeStartUs = motionNowUs();
+        return writeRois(detector, rf, results, maxResults, arena, arenaSize);
+    }
+
+    // Shared-memory frame ring (frame_ring.h). Producer side, for any process that
+    // decodes frames: create once per camera, publish every frame (one copy into the ring).
+    void* create_frame_ring(const char* name, int width, int height, int stride, int pixfmt, int slots) {
+        if (!name) return nullptr;
+        FrameRingWriter* ring = new FrameRingWriter();
+        if (!ring->create(name, width, height, stride, pixfmt, slots)) {
+            delete ring;
+            return nullptr;
+        }
+        return ring;
+    }
+
+    int publish_frame_ring(void* ring, const unsigned char* ptr, int stride, int64_t timestampMs) {
+        if (!ring) return 0;
+        return ((FrameRingWriter*)ring)->publish(ptr, stride, timestampMs > 0 ? timestampMs : frameRingNowMs()) ? 1 : 0;
+    }
+
+    void destroy_frame_ring(void* ring, int unlinkName) {
+        if (!ring) return;
+        FrameRingWriter* w = (FrameRingWriter*)ring;
+        w->close(unlinkName != 0);
+        delete w;
+    }
+
+    // Consumer side: read-only attach, NULL while the producer has not created the ring
+    void* open_frame_ring(const char* name) {
+        if (!name) return nullptr;
+        FrameRingReader* ring = new FrameRingReader();
+        if (!ring->open(name)) {
+            delete ring;
+            return nullptr;
+        }
+        return ring;
+    }
+
+    void close_frame_ring(void* ring) {
+        delete (FrameRingReader*)ring;
+    }
+
+    // Analyses the newest ring frame and encodes its ROIs like process_frame_raw_rois.
+    // The slot is copied and its seqlock checked before the detector sees it: a torn
+    // frame (RING_TORN) never reaches the background model or the tracks. maxAgeMs <= 0 accepts any age. flags: FrameRingFlags.
+    // Returns the number of ROIs, RING_NO_FRAME, RING_TORN or -1 on invalid input.
+    int process_frame_ring(void* handle, void* ring, int maxAgeMs, int flags, RingFrameInfo* info,
+                           RoiResult* results, int maxResults, uint8_t* arena, int arenaSize) {
+        if (!handle || !ring || !results || maxResults <= 0) return -1;
+        MotionDetector* detector = (MotionDetector*)handle;
+        FrameRingReader* reader = (FrameRingReader*)ring;
+        if (info) {
+            std::memset(info, 0, sizeof(*info));
+            info->fullOffset = -1;
+        }
+
+        RingFrameView view;
+        if (!reader->latest(view, maxAgeMs)) return RING_NO_FRAME;
+        const FrameRingHeader& h = reader->header();
+        if (info) {
+            info->frameSeq = (int64_t)view.frameNumber;
+            info->timestampMs = view.timestampMs;
+            info->width = h.width;
+            info->height = h.height;
+        }
+
+        // O copie (un memcpy, ~3 MB la 1080p I420) in locul analizei in loc: dupa
+        // processFrame fundalul si track-urile ar fi inghitit deja un cadru rupt
+        const uint8_t* data = reader->copyFrame(view);
+        if (!data) return RING_TORN;
+        cv::Mat frame = wrapRawFrame(data, h.width, h.height, h.stride, h.pixfmt);
+        if (frame.empty()) return -1;
+
+        RoiFrame rf;
+        RawYuvPlanes yuv;
+        if (wrapRawYuv(data, h.width, h.height, h.stride, h.pixfmt, yuv)) rf.yuv = &yuv;
+
+        auto lock = detector->lockFrame();
+        RoiOutputBuffer& ob = detector->roiOutput();
+        ob.bytes.clear();
+        rf.validSlots = &detector->processFrameLocked(frame);
+        if (rf.validSlots->empty()) return 0;
+
+        rf.fullFrame = frame;
+        rf.encodeStartUs = motionNowUs();
+        int n = writeRois(detector, rf, results, maxResults, arena, arenaSize);
+
+        if ((flags & RING_FULL_FRAME) && info) {
+            const cv::Rect whole(0, 0, frame.cols, frame.rows);
+            bool ok = rf.yuv ? encodeJPEGYuv420(yuv, whole, ob.encodeScratch, 85) : encodeJPEG(frame, ob.encodeScratch, 85);
+            if (ok) {
+                const size_t len = ob.encodeScratch.size();
+                info->fullLen = (int32_t)len;
+                if (arena) {
+                    size_t used = 0;
+                    for (int i = 0; i < n; ++i) {
+                        if (results[i].offset >= 0) used = std::max(used, (size_t)results[i].offset + results[i].len);
+                    }
+                    if (arenaSize >= 0 && used + len <= (size_t)arenaSize) {
+                        std::memcpy(arena + used, ob.encodeScratch.data(), len);
+                        info->fullOffset = (int32_t)used;
+                    }
+                } else {
+                    info->fullOffset = (int32_t)ob.bytes.size();
+                    ob.bytes.insert(ob.bytes.end(), ob.encodeScratch.begin(), ob.encodeScratch.end());
+                }
+            }
+        }
+        return n;
+    }
+
+    // Handle-owned JPEG bytes of the last ROI call without an arena
+    const uint8_t* get_roi_buffer(void* handle, int* len) {
+        if (len) *len = 0;
+        if (!handle) return nullptr;
+        RoiOutputBuffer& ob = ((MotionDetector*)handle)->roiOutput();
+        if (len) *len = (int)ob.bytes.size();
+        return ob.bytes.empty() ? nullptr : ob.bytes.data();
+    }
+
+    // Frees the handle's ROI buffers (they are otherwise reused between calls)
+    void release_roi_buffer(void* handle) {
+        if (!handle) return;
+        ((MotionDetector*)handle)->roiOutput().release();
+    }
+
+    // Continuous in-process ingest (RTSP or file, needs DSS_ENABLE_LIBAV): the stream's
+    // thread drives the detector until stop_stream_ingest / destroy_detector.
+    // analysisFps <= 0 analyses every decoded frame. flags: IngestFlags.
+    // Returns stream id (> 0) or -1 (also always -1 in a build without DSS_ENABLE_LIBAV).
+    int start_stream_ingest(void* handle, const char* url, double analysisFps, int flags) {
+        if (!handle || !url) return -1;
+        return StreamIngestor::instance().start(url, (MotionDetector*)handle, analysisFps, flags);
+    }
+
+    void stop_stream_ingest(int streamId) {
+        StreamIngestor::instance().stop(streamId);
+    }
+
+    // IngestState: 0 stopped / unknown, 1 connecting, 2 running, 3 file ended
+    int get_stream_ingest_state(int streamId) {
+        return StreamIngestor::instance().state(streamId);
+    }
+
+    // Drains queued ingest events (all streams); JPEG bytes go to arena at event.roi.offset.
+    // Returns the number of events written, or -1 on invalid input.
+    int poll_ingest_events(IngestEvent* events, int maxEvents, uint8_t* arena, int arenaSize) {
+        return StreamIngestor::instance().poll(events, maxEvents, arena, arenaSize);
     }
 
     // NEW: Set Exclusion Zones (Masking)
-    // rects: flattened array [x,y,w,h, x,y,w,h, ...]
+    // rects: flattened array [x,y,w,h, x,y,w,h, ...] in analysis-space pixels (camera_config.h),
+    // not in the pixels of the frames passed to process_*. Frames wider than the analysis width
+    // (create_detector / set_analysis_size) are reduced to exactly that width, so the caller
+    // converts a source rect by analysisWidth / frameWidth (1 when the frame is not wider).
+    // Part of the detector config: set the zones before load_detector_state.
     void set_exclusion_zones(void* handle, int* rects, int count) {
         if (!handle || !rects) return;
         MotionDetector* detector = (MotionDetector*)handle;
@@ -222,4 +542,23 @@ extern "C" {
         // std::cout << "[Native] Set " << count << " exclusion zones." << std::endl;
     }
 
+    // Analysis resolution of the handle (width decides, aspect follows the frames).
+    // Changing it resets the tracks: their coordinates belong to the old space.
+    void set_analysis_size(void* handle, int width, int height) {
+        if (!handle || width <= 0 || height <= 0) return;
+        ((MotionDetector*)handle)->setAnalysisSize(cv::Size(width, height));
+    }
+
+    // mode: 0 = greedy (istoric), 1 = global (Hungarian + predictie + coasting)
+    // maxCoastFrames < 0 pastreaza valoarea curenta
+    void set_tracker_mode(void* handle, int mode, int maxCoastFrames) {
+        if (!handle) return;
+        MotionDetector* detector = (MotionDetector*)handle;
+
+        CameraConfig cfg = detector->getConfig();
+        cfg.trackerMode = mode == 0 ? TrackerMode::Greedy : TrackerMode::Global;
+        if (maxCoastFrames >= 0) cfg.maxCoastFrames = maxCoastFrames;
+        detector->updateConfig(cfg);
+    }
+
 }
@@ -0,0 +1,209 @@
+#include "mv_engine.h"
+#include "roi_crop.h"
+#include "jpeg_encode.h"
+#include "motion_detector.h"
+#include <cmath>
+#include <iostream>
+
+#ifdef DSS_ENABLE_LIBAV
+extern "C" {
+#include <libavutil/motion_vector.h>
+}
+#endif
+
+void MvMotionEngine::init(cv::Size frameSize) {
+    this->size = frameSize;
+    tracker.reset();
+}
+
+bool MvMotionEngine::processFrame(const cv::Mat&, std::vector<EncodedROI>&) {
+    if (!warnedPixelInput) {
+        std::cerr << "[MV] processFrame(cv::Mat) is not supported: motion vectors exist only in the "
+                     "compressed stream, use open() + processNext() or a pixel engine" << std::endl;
+        warnedPixelInput = true;
+    }
+    return false;
+}
+
+bool MvMotionEngine::open(const std::string& url, int decoderThreads) {
+    AvStreamOptions opt;
+    opt.exportMotionVectors = true;
+    opt.decoderThreads = decoderThreads;
+    if (!reader.open(url, opt)) return false;
+
+    // export_mvs e ignorat tacit de decoderele fara suport: fara verificarea asta motorul
+    // ar tine track-urile pe loc la nesfarsit, fara nicio detectie
+    if (!codecExportsMotionVectors(reader.codecId())) {
+        std::cerr << "[MV] Decoder '" << reader.codecName() << "' does not export motion vectors "
+                  << "(H.264 / MPEG-4 / MPEG-1/2 / H.263 only), cannot analyse " << url << std::endl;
+        reader.close();
+        return false;
+    }
+
+    // Segmentele consecutive ale aceleiasi camere continua track-urile
+    if (reader.size() != size) init(reader.size());
+    interWithoutMv = 0;
+    return true;
+}
+
+bool MvMotionEngine::processNext(std::vector<EncodedROI>& out) {
+    AVFrame* frame = nullptr;
+    if (reader.next(frame) != 0 || !frame) return false;
+    lastTimeSec = reader.frameTimeSec(frame);
+
+    // Cadrele I nu au vectori: track-urile raman neatinse (nu imbatranesc pe un keyframe)
+    if (!buildMask(frame)) {
+        tracker.hold();
+        framesHeld++;
+        return true;
+    }
+    framesWithMv++;
+
+    // Zonele excluse sunt in pixelii stream-ului (motorul nu are reducere la analiza):
+    // orice celula atinsa de zona e stearsa
+    cellZones.clear();
+    for (const ExcludedZone& z : config.excludedZones) {
+        const int x0 = std::max(0, z.zone.x) / kCell, y0 = std::max(0, z.zone.y) / kCell;
+        const int x1 = (z.zone.x + z.zone.width + kCell - 1) / kCell;
+        const int y1 = (z.zone.y + z.zone.height + kCell - 1) / kCell;
+        if (x1 > x0 && y1 > y0) cellZones.push_back({cv::Rect(x0, y0, x1 - x0, y1 - y0)});
+    }
+    MotionDetector::applyExcludedZones(mask, cellZones);
+
+    blobs.clear();
+    const double cellArea = (double)kCell * kCell;
+    int minCells = (int)std::ceil(config.minAreaRatio * gw * gh);
+    labeler.label(mask, std::max(1, minCells), blobs);
+
+    // Coordonate celula -> pixeli, tracker-ul si filtrele lucreaza in pixeli
+    const cv::Rect full(0, 0, size.width, size.height);
+    for (MotionBlob& b : blobs) {
+        b.bbox = cv::Rect(b.bbox.x * kCell, b.bbox.y * kCell, b.bbox.width * kCell, b.bbox.height * kCell) & full;
+        b.area *= cellArea;
+        b.centroid = cv::Point2f((b.centroid.x + 0.5f) * kCell, (b.centroid.y + 0.5f) * kCell);
+    }
+
+    const std::vector<int>& validSlots = tracker.update(blobs, size, config);
+    if (encodeEnabled && !validSlots.empty()) encodeRois(frame, validSlots, out);
+    return true;
+}
+
+#ifdef DSS_ENABLE_LIBAV
+
+bool MvMotionEngine::codecExportsMotionVectors(int codecId) {
+    switch (codecId) {
+        case AV_CODEC_ID_H264:
+        case AV_CODEC_ID_MPEG4:
+        case AV_CODEC_ID_MPEG1VIDEO:
+        case AV_CODEC_ID_MPEG2VIDEO:
+        case AV_CODEC_ID_H263:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool MvMotionEngine::buildMask(const AVFrame* frame) {
+    const AVFrameSideData* sd = av_frame_get_side_data(frame, AV_FRAME_DATA_MOTION_VECTORS);
+    if (!sd || sd->size < sizeof(AVMotionVector)) {
+        // Un cadru P/B complet intra nu are vectori; o serie lunga inseamna ca decoderul
+        // nu le exporta (build FFmpeg diferit, hwaccel) si motorul nu mai vede nimic
+        if (frame->pict_type != AV_PICTURE_TYPE_I && ++interWithoutMv == kNoMvWarnFrames && !warnedNoMv) {
+            std::cerr << "[MV] " << kNoMvWarnFrames << " inter frames in a row without motion vectors from '"
+                      << reader.codecName() << "', detection is stalled" << std::endl;
+            warnedNoMv = true;
+        }
+        return false;
+    }
+    interWithoutMv = 0;
+
+    gw = (size.width + kCell - 1) / kCell;
+    gh = (size.height + kCell - 1) / kCell;
+    moving.assign((size_t)gw * gh, 0);
+    covered.assign((size_t)gw * gh, 0);
+
+    const AVMotionVector* mvs = reinterpret_cast<const AVMotionVector*>(sd->data);
+    const size_t count = sd->size / sizeof(AVMotionVector);
+    const double minSq = kMinMotionPx * kMinMotionPx;
+
+    for (size_t i = 0; i < count; ++i) {
+        const AVMotionVector& mv = mvs[i];
+        const double scale = mv.motion_scale > 0 ? (double)mv.motion_scale : 1.0;
+        const double dx = mv.motion_x / scale;
+        const double dy = mv.motion_y / scale;
+        const bool isMoving = dx * dx + dy * dy >= minSq;
+
+        // dst_x/dst_y = centrul blocului in cadrul curent
+        const int x0 = std::max(0, (mv.dst_x - mv.w / 2) / kCell);
+        const int y0 = std::max(0, (mv.dst_y - mv.h / 2) / kCell);
+        const int x1 = std::min(gw - 1, (mv.dst_x + mv.w / 2 - 1) / kCell);
+        const int y1 = std::min(gh - 1, (mv.dst_y + mv.h / 2 - 1) / kCell);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                covered[y * gw + x] = 1;
+                if (isMoving) moving[y * gw + x] = 1;
+            }
+        }
+    }
+
+    // Blocuri intra intr-un cadru P/B (fara vector) = continut nou. Conteaza ca miscare
+    // doar langa o celula in miscare: intra izolat e de obicei zgomot / refresh al encoderului.
+    mask.create(gh, gw, CV_8UC1);
+    for (int y = 0; y < gh; ++y) {
+        uint8_t* row = mask.ptr<uint8_t>(y);
+        for (int x = 0; x < gw; ++x) {
+            const int i = y * gw + x;
+            bool on = moving[i] != 0;
+            if (!on && !covered[i]) {
+                for (int yy = std::max(0, y - 1); yy <= std::min(gh - 1, y + 1) && !on; ++yy) {
+                    for (int xx = std::max(0, x - 1); xx <= std::min(gw - 1, x + 1); ++xx) {
+                        if (moving[yy * gw + xx]) { on = true; break; }
+                    }
+                }
+            }
+            row[x] = on ? 255 : 0;
+        }
+    }
+    return true;
+}
+
+void MvMotionEngine::encodeRois(const AVFrame* frame, const std::vector<int>& validSlots,
+                                std::vector<EncodedROI>& out) {
+    cv::Mat luma;
+    RawYuvPlanes yuv;
+    if (!wrapAvFrame(frame, luma, yuv)) {
+        if (!warnedPixfmt) {
+            std::cerr << "[MV] Unsupported decoder pixel format " << frame->format << ", no ROI output" << std::endl;
+            warnedPixfmt = true;
+        }
+        return;
+    }
+
+    TrackTable& tt = tracker.tracks();
+    for (int slot : validSlots) {
+        // Crop-ul (cu starea EMA a track-ului) se calculeaza pe luma, encodarea citeste direct YUV
+        cv::Rect crop;
+        cv::Mat roi = cropROI(luma, tt.bbox[slot], config.roiPadding, tt.smoothRoi[slot], &crop);
+        if (roi.empty()) continue;
+
+        out.emplace_back();
+        EncodedROI& item = out.back();
+        item.bbox = tt.bbox[slot];
+        item.objectId = (int)tt.id[slot];
+        if (!encodeJPEGYuv420(yuv, crop, item.jpeg, 85)) out.pop_back();
+    }
+}
+
+#else
+
+bool MvMotionEngine::codecExportsMotionVectors(int) {
+    return false;
+}
+
+bool MvMotionEngine::buildMask(const AVFrame*) {
+    return false;
+}
+
+void MvMotionEngine::encodeRois(const AVFrame*, const std::vector<int>&, std::vector<EncodedROI>&) {}
+
+#endif
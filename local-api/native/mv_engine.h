@@ -0,0 +1,82 @@
+#pragma once
+#include "motion_engine.h"
+#include "camera_config.h"
+#include "av_stream.h"
+#include "blob_labeler.h"
+#include "tracker.h"
+#include <string>
+
+// Motor de miscare in domeniul comprimat (H.264 / MPEG-4 / MPEG-2):
+// masca se construieste din vectorii de miscare exportati de decoder (export_mvs)
+// si din blocurile intra ale cadrelor P/B, pe o grila de 8x8 px, fara niciun
+// pas de analiza pe pixeli (gray, blur, diff). Pixelii sunt atinsi doar pentru
+// cadrele cu track-uri valide, la crop + JPEG direct din planurile YUV.
+//
+// Nota: libavcodec reconstruieste oricum cadrul (referinta pentru urmatoarele),
+// castigul e ca analiza nu mai parcurge imaginea.
+// Doar decoderele FFmpeg h264, mpeg4, mpeg1/2video si h263 exporta vectori; HEVC, VP9
+// si AV1 nu (side data lipseste pe toate cadrele), asa ca open() le refuza si
+// apelantul ramane pe motorul pe pixeli (createEngine).
+class MvMotionEngine : public MotionEngine {
+public:
+    static constexpr int kCell = 8;             // mask cell, px (smallest common partition)
+    static constexpr double kMinMotionPx = 1.0; // |mv| below this is treated as noise
+    static constexpr int kNoMvWarnFrames = 50;  // inter frames without vectors before the warning
+
+    // True for the codecs whose FFmpeg decoder fills AV_FRAME_DATA_MOTION_VECTORS
+    static bool codecExportsMotionVectors(int codecId);
+
+    void init(cv::Size frameSize) override;
+    // Not supported, always false: a decoded cv::Mat no longer carries the encoder's
+    // motion vectors, and estimating them from pixels is what the pixel engines do.
+    // Frames come from the stream instead (open + processNext).
+    bool processFrame(const cv::Mat& frame, std::vector<EncodedROI>& out) override;
+
+    // Opens a stream or recorded segment (rtsp://..., /path/segment.mp4). False, with a
+    // [MV] message, when the codec does not export motion vectors. Tracks carry over
+    // to the next open() with the same frame size (consecutive recorder segments).
+    bool open(const std::string& url, int decoderThreads = 1);
+    // Decodes and analyses the next frame. False at end of stream or on error.
+    bool processNext(std::vector<EncodedROI>& out);
+
+    // excludedZones are in stream pixels (the engine has no analysis downscale)
+    void setConfig(const CameraConfig& cfg) { config = cfg; }
+    // Off = detection only, processNext leaves `out` empty
+    void setEncodeRois(bool on) { encodeEnabled = on; }
+    const TrackTable& tracks() const { return tracker.tracks(); }
+    const std::vector<int>& validTracks() const { return tracker.validTracks(); }
+    // Last built mask, one byte per kCell x kCell cell (255 = motion)
+    const cv::Mat& cellMask() const { return mask; }
+    // Stream time of the last processNext frame (s, -1 unknown) and nominal frame rate
+    double frameTimeSec() const { return lastTimeSec; }
+    double frameRate() const { return reader.frameRate(); }
+    // Frames analysed from vectors / frames held without vectors (I-frames included)
+    uint64_t mvFrames() const { return framesWithMv; }
+    uint64_t heldFrames() const { return framesHeld; }
+
+private:
+    // False when the frame carries no motion vectors (I-frame, unsupported codec)
+    bool buildMask(const AVFrame* frame);
+    void encodeRois(const AVFrame* frame, const std::vector<int>& validSlots, std::vector<EncodedROI>& out);
+
+    AvStreamReader reader;
+    CameraConfig config;
+    cv::Size size;
+    int gw = 0, gh = 0;
+
+    cv::Mat mask;                   // CV_8UC1, gh x gw
+    std::vector<uint8_t> moving;    // cell had a motion vector above kMinMotionPx
+    std::vector<uint8_t> covered;   // cell had any motion vector (inter coded)
+    std::vector<ExcludedZone> cellZones; // config.excludedZones in cells
+    BlobLabeler labeler;
+    std::vector<MotionBlob> blobs;
+    MotionTracker tracker;
+    bool encodeEnabled = true;
+    double lastTimeSec = -1.0;
+    uint64_t framesWithMv = 0;
+    uint64_t framesHeld = 0;
+    int interWithoutMv = 0;         // consecutive P/B frames without side data
+    bool warnedNoMv = false;
+    bool warnedPixfmt = false;
+    bool warnedPixelInput = false;
+};
@@ -1,75 +1,158 @@
 #include "opencl_engine.h"
-#include "jpeg_encode.h"
-#include "roi_utils.h"
+#include <iostream>
 
-void OpenClMotionEngine::init(cv::Size frameSize) {
-    this->size = frameSize;
+// Un work-item per tile: numara pixelii activi si bbox-ul lor in tile
+static const char* kTileSummarySrc = R"CLC(
+__kernel void mask_tile_summary(__global const uchar* src, int src_step, int src_offset, int rows, int cols,
+                                __global int* tiles, int tileSize, int tilesX, int tilesY)
+{
+    const int tx = get_global_id(0);
+    const int ty = get_global_id(1);
+    if (tx >= tilesX || ty >= tilesY) return;
+
+    const int x0 = tx * tileSize, y0 = ty * tileSize;
+    const int x1 = min(x0 + tileSize, cols), y1 = min(y0 + tileSize, rows);
+    int count = 0, minX = x1, minY = y1, maxX = -1, maxY = -1;
+    for (int y = y0; y < y1; ++y) {
+        __global const uchar* row = src + src_offset + y * src_step;
+        for (int x = x0; x < x1; ++x) {
+            if (row[x]) {
+                ++count;
+                minX = min(minX, x);
+                maxX = max(maxX, x);
+                minY = min(minY, y);
+                maxY = y;
+            }
+        }
+    }
+    __global int* o = tiles + (ty * tilesX + tx) * 5;
+    o[0] = count;
+    o[1] = minX;
+    o[2] = minY;
+    o[3] = maxX;
+    o[4] = maxY;
+}
+)CLC";
+
+OpenClMaskBackend::OpenClMaskBackend() {
     if (!cv::ocl::haveOpenCL()) {
         std::cerr << "[OpenCL] Warning: OpenCL not available, UMat will run on CPU." << std::endl;
     }
     cv::ocl::setUseOpenCL(true);
 }
 
-bool OpenClMotionEngine::processFrame(const cv::Mat& frame, std::vector<EncodedROI>& out) {
-    if (frame.empty()) return false;
-
-    // Upload to GPU (Transparent API handling)
-    frame.copyTo(uFrame);
+void OpenClMaskBackend::upload(const cv::Mat& frame) {
+    cv::UMat& in = uInput[inputIndex];
+    inputIndex ^= 1;
+    if (in.size() != frame.size() || in.type() != frame.type()) {
+        in.create(frame.size(), frame.type(), cv::USAGE_ALLOCATE_HOST_MEMORY);
+    }
+    // Scriere prin maparea bufferului pinned: pe iGPU (memorie unificata) e zero-copy,
+    // pe GPU dedicat DMA direct din el, fara copia de staging a lui Mat -> UMat
+    {
+        cv::Mat mapped = in.getMat(cv::ACCESS_WRITE);
+        frame.copyTo(mapped);
+    }
 
-    if (uFrame.channels() == 3) {
-        cv::cvtColor(uFrame, uGray, cv::COLOR_BGR2GRAY);
+    if (in.channels() == 3) {
+        cv::cvtColor(in, uGray, cv::COLOR_BGR2GRAY);
     } else {
-        uFrame.copyTo(uGray);
+        uGray = in;
     }
+}
+
+bool OpenClMaskBackend::downloadActiveTiles(cv::Mat& mask) {
+    if (!kernelReady) {
+        if (kernelFailed) return false;
+        std::string err;
+        kernelReady = tileKernel.create("mask_tile_summary", cv::ocl::ProgramSource(kTileSummarySrc), "", &err);
+        if (!kernelReady) {
+            kernelFailed = true;
+            std::cerr << "[OpenCL] Tile summary kernel unavailable, full mask download: " << err << std::endl;
+            return false;
+        }
+    }
+
+    const int tilesX = (uMask.cols + kTile - 1) / kTile;
+    const int tilesY = (uMask.rows + kTile - 1) / kTile;
+    uTiles.create(tilesX * tilesY, 5, CV_32SC1);
+    tileKernel.args(cv::ocl::KernelArg::ReadOnly(uMask), cv::ocl::KernelArg::PtrWriteOnly(uTiles),
+                    (int)kTile, tilesX, tilesY);
+    size_t global[2] = {(size_t)tilesX, (size_t)tilesY};
+    // Fara clFinish: citirea rezumatului (blocanta, coada in ordine) asteapta oricum kernelul
+    if (!tileKernel.run(2, global, nullptr, false)) return false;
+    uTiles.copyTo(tiles); // tilesX * tilesY * 20 bytes, vs cols * rows for the mask
+
+    int active = 0;
+    long activeArea = 0;
+    for (int i = 0; i < tiles.rows; ++i) {
+        const int* t = tiles.ptr<int>(i);
+        if (t[0] == 0) continue;
+        ++active;
+        activeArea += (long)(t[3] - t[1] + 1) * (t[4] - t[2] + 1);
+    }
+
+    if (active > kMaxTileReads || activeArea > kFullReadRatio * uMask.cols * uMask.rows) {
+        uMask.copyTo(mask);
+        return true;
+    }
+
+    mask.create(uMask.size(), CV_8UC1);
+    mask.setTo(0);
+    for (int i = 0; i < tiles.rows && active > 0; ++i) {
+        const int* t = tiles.ptr<int>(i);
+        if (t[0] == 0) continue;
+        // Doar bbox-ul pixelilor activi din tile (read rect), in afara lui masca e 0
+        const cv::Rect r(t[1], t[2], t[3] - t[1] + 1, t[4] - t[2] + 1);
+        cv::Mat dst = mask(r);
+        uMask(r).copyTo(dst);
+        --active;
+    }
+    return true;
+}
+
+// Fundalul pe device e float in nivele de gri; formatul comun e Q8 pe 16 biti
+bool OpenClMaskBackend::exportBackground(cv::Mat& q8) const {
+    if (!backgroundInit || uBackground.empty()) return false;
+    cv::Mat f;
+    uBackground.copyTo(f);
+    f.convertTo(q8, CV_16U, 256.0);
+    return true;
+}
+
+void OpenClMaskBackend::importBackground(const cv::Mat& q8) {
+    cv::Mat f;
+    q8.convertTo(f, CV_32F, 1.0 / 256.0);
+    f.copyTo(uBackground);
+    backgroundInit = true;
+}
+
+bool OpenClMaskBackend::computeMask(const cv::Mat& frame, const CameraConfig& cfg, cv::Mat& mask) {
+    upload(frame);
 
     // Gaussian Blur on GPU
-    cv::GaussianBlur(uGray, uGray, cv::Size(21, 21), 0);
+    cv::GaussianBlur(uGray, uBlur, cv::Size(21, 21), 0);
+    uBlur.convertTo(uBlurF, CV_32F);
 
-    if (!backgroundInit) {
-        uGray.copyTo(uBackground);
+    if (!backgroundInit || uBackground.size() != frame.size()) {
+        uBlurF.copyTo(uBackground);
         backgroundInit = true;
-        return true; 
+        mask.create(frame.size(), CV_8UC1);
+        mask.setTo(0);
+        return true;
     }
 
-    // Motion Diff on GPU
-    cv::absdiff(uGray, uBackground, uDiff);
-    cv::threshold(uDiff, uThresh, 25, 255, cv::THRESH_BINARY);
-    cv::dilate(uThresh, uThresh, cv::UMat(), cv::Point(-1,-1), 2);
-
-    // Background Update on GPU
-    cv::addWeighted(uBackground, 0.90, uGray, 0.10, 0, uBackground);
-
-    // Download contours to CPU (contours are vector logic, better on CPU)
-    // We need to fetch the mask to CPU to find contours
-    cv::Mat maskCpu;
-    uThresh.copyTo(maskCpu);
-
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(maskCpu, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-    // Filter & Encode
-    double frameArea = (double)size.width * size.height;
-    
-    for (const auto& c : contours) {
-        cv::Rect r = cv::boundingRect(c);
-        double area = cv::contourArea(c);
-        
-        if (area / frameArea < 0.005) continue; // Min size filter
-
-        // Crop ROI
-        // Prefer extracting small ROI from UMat? 
-        // Or using the CPU frame copy we have?
-        // Using CPU copy avoids small transfers overhead.
-        
-        cv::Rect safeRoi = clampRect(expandRect(r, 0.2, size), size);
-        cv::Mat roiCpu = frame(safeRoi); // Utilizăm cadrul original din RAM
-
-        if (roiCpu.empty()) continue;
-
-        out.emplace_back();
-        out.back().bbox = r;
-        encodeJPEG(roiCpu, out.back().jpeg, 85);
-    }
+    // Motion Diff on GPU: |blur - bg| > diffThreshold, then 5x5 dilation (2 x 3x3)
+    cv::absdiff(uBlurF, uBackground, uDiff);
+    cv::threshold(uDiff, uThresh, cfg.diffThreshold, 255, cv::THRESH_BINARY);
+    uThresh.convertTo(uMask, CV_8U);
+    cv::dilate(uMask, uMask, cv::UMat(), cv::Point(-1,-1), 2);
+
+    // Only the tile summary and the active areas come back: blobs / tracking run on CPU
+    if (!downloadActiveTiles(mask)) uMask.copyTo(mask);
 
+    // Background Update on GPU (running average, same rate as the CPU kernel).
+    // Pus in coada dupa citirea mastii: ruleaza pe device in paralel cu tracking-ul pe host
+    cv::accumulateWeighted(uBlurF, uBackground, cfg.bgLearningRate);
     return true;
 }
@@ -1,16 +1,52 @@
 #pragma once
-#include "motion_engine.h"
+#include "mask_backend.h"
+#include "detector_engine.h"
 #include <opencv2/core/ocl.hpp>
 
-class OpenClMotionEngine : public MotionEngine {
+// Etapa de pixeli pe OpenCL (T-API / UMat): gray, blur 21x21, diff fata de fundal,
+// prag, dilatare 5x5 si update fundal raman pe device.
+// Fundalul e float (acelasi rol ca Q8 pe CPU: fara pierdere de precizie la alpha mic).
+//
+// Masca nu se descarca integral: un kernel o reduce pe device la un rezumat pe tile-uri
+// (pixeli activi + bbox per tile), doar rezumatul (cativa KB) vine pe host, apoi doar
+// bbox-urile tile-urilor active. Cadrul urca prin doua buffere in memorie host pinned
+// (mapate, fara staging), alternate intre cadre.
+//
+// Limitare: computeMask e sincron (masca cadrului N iese din acelasi apel), deci upload-ul
+// cadrului N+1 nu se suprapune cu calculul cadrului N - citirea rezumatului asteapta coada.
+// Singura suprapunere: update-ul fundalului, pus in coada dupa citirea mastii, ruleaza in
+// timp ce host-ul face bloburile si tracking-ul; maparea bufferului urmator il asteapta
+// (coada in ordine). Suprapunerea completa ar cere masca intoarsa cu un cadru intarziere.
+class OpenClMaskBackend : public MaskBackend {
 public:
-    void init(cv::Size frameSize) override;
-    bool processFrame(const cv::Mat& frame, std::vector<EncodedROI>& out) override;
+    static constexpr int kTile = 32;            // px, summary granularity
+    static constexpr int kMaxTileReads = 32;    // more active tiles: one full-mask download
+    static constexpr double kFullReadRatio = 0.5; // active tile area above this: full download
+
+    OpenClMaskBackend();
+    EngineKind kind() const override { return EngineKind::OpenCL; }
+    bool computeMask(const cv::Mat& frame, const CameraConfig& cfg, cv::Mat& mask) override;
+    void reseed() override { backgroundInit = false; }
+    bool exportBackground(cv::Mat& q8) const override;
+    void importBackground(const cv::Mat& q8) override;
 
 private:
-    cv::UMat uFrame, uGray, uDiff, uBackground, uThresh;
+    void upload(const cv::Mat& frame);
+    // Summary kernel + selective download. False when the kernel is unavailable.
+    bool downloadActiveTiles(cv::Mat& mask);
+
+    cv::UMat uInput[2];     // pinned host memory, alternated per frame
+    int inputIndex = 0;
+    cv::UMat uGray, uBlur, uBlurF, uBackground, uDiff, uThresh, uMask;
+    cv::UMat uTiles;        // tilesX * tilesY rows of {count, minX, minY, maxX, maxY}
+    cv::Mat tiles;
+    cv::ocl::Kernel tileKernel;
+    bool kernelReady = false;
+    bool kernelFailed = false;
     bool backgroundInit = false;
-    cv::Size size;
-    // Simplificat: Reimplementăm logica de detecție folosind UMat direct
-    // pentru a evita transferul memoriei CPU <-> GPU
+};
+
+class OpenClMotionEngine : public DetectorMotionEngine {
+public:
+    OpenClMotionEngine() : DetectorMotionEngine(EngineKind::OpenCL) {}
 };
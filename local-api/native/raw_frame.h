@@ -0,0 +1,77 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+// Formate de pixeli acceptate de process_frame_raw (valori stabile, folosite din FFI)
+enum RawPixelFormat {
+    PIXFMT_BGR24 = 0,
+    PIXFMT_GRAY8 = 1,
+    PIXFMT_NV12  = 2,  // Y plane + interleaved UV plane
+    PIXFMT_I420  = 3   // planar YUV420: Y, U, V
+};
+
+// Wraps caller memory in a cv::Mat header, no copy.
+// For YUV input only the Y plane is wrapped: luma is the grayscale image the
+// detector needs, so chroma is never touched. Returns empty Mat on bad input.
+inline cv::Mat wrapRawFrame(const uint8_t* data, int width, int height, int stride, int pixfmt) {
+    if (!data || width <= 0 || height <= 0) return cv::Mat();
+
+    int type;
+    int minStride;
+    switch (pixfmt) {
+        case PIXFMT_BGR24:
+            type = CV_8UC3;
+            minStride = width * 3;
+            break;
+        case PIXFMT_GRAY8:
+        case PIXFMT_NV12:
+        case PIXFMT_I420:
+            type = CV_8UC1;
+            minStride = width;
+            break;
+        default:
+            return cv::Mat();
+    }
+    if (stride <= 0) stride = minStride;
+    if (stride < minStride) return cv::Mat();
+
+    // cv::Mat nu modifica datele aici, const_cast doar pentru constructorul de header
+    return cv::Mat(height, width, type, const_cast<uint8_t*>(data), (size_t)stride);
+}
+
+// Planurile unui buffer NV12/I420 contiguu (Y urmat de croma, stride-ul cromei
+// derivat din cel al lui Y: NV12 acelasi, I420 (stride + 1) / 2, ca o latime impara
+// sa incapa intreaga). Folosit doar pentru a encoda ROI-uri direct din YUV.
+struct RawYuvPlanes {
+    const uint8_t* y = nullptr;
+    const uint8_t* u = nullptr;   // NV12: interleaved UV plane
+    const uint8_t* v = nullptr;   // NV12: unused
+    int strideY = 0;
+    int strideUV = 0;
+    bool nv12 = false;
+    int width = 0, height = 0;
+};
+
+inline bool wrapRawYuv(const uint8_t* data, int width, int height, int stride, int pixfmt, RawYuvPlanes& out) {
+    if (!data || width <= 0 || height <= 0) return false;
+    if (pixfmt != PIXFMT_NV12 && pixfmt != PIXFMT_I420) return false;
+    if (stride <= 0) stride = width;
+    if (stride < width) return false;
+
+    out.y = data;
+    out.strideY = stride;
+    out.width = width;
+    out.height = height;
+    out.nv12 = pixfmt == PIXFMT_NV12;
+    const uint8_t* chroma = data + (size_t)stride * height;
+    if (out.nv12) {
+        out.u = chroma;
+        out.v = nullptr;
+        out.strideUV = stride;
+    } else {
+        out.strideUV = (stride + 1) / 2;
+        out.u = chroma;
+        out.v = chroma + (size_t)out.strideUV * ((height + 1) / 2);
+    }
+    return true;
+}
@@ -5,10 +5,13 @@
 inline cv::Mat cropROI(const cv::Mat& frame,
                        const cv::Rect& bbox,
                        double padding,
-                       cv::Rect& smoothState) {
+                       cv::Rect& smoothState,
+                       cv::Rect* cropOut = nullptr) {
     cv::Rect expanded = expandRect(bbox, padding, frame.size());
     cv::Rect stabilized = smoothRectEMA(expanded, smoothState);
     cv::Rect safe = clampRect(stabilized, frame.size());
+    if (cropOut) *cropOut = safe;
     if (safe.area() <= 0) return cv::Mat();
-    return frame(safe).clone(); // clone pentru siguranță thread
+    // View, fara copie: encoder-ul citeste direct din cadrul sursa (valid cat timp traieste frame)
+    return frame(safe);
 }
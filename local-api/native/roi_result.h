@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Un ROI returnat prin FFI (layout fix, oglindit de structura koffi din Node).
+// Octetii JPEG sunt la [offset, offset + len) in arena apelantului sau,
+// daca arena lipseste, in bufferul per-handle (get_roi_buffer).
+struct RoiResult {
+    uint32_t trackId;       // stable integer track id (TrackTable::id)
+    int32_t x, y, w, h;     // detection bbox, source resolution
+    int32_t cropX, cropY, cropW, cropH; // smoothed crop that was encoded
+    int32_t offset;         // -1 = did not fit in the arena (len = bytes needed)
+    int32_t len;
+};
+
+// Per-handle output storage: every handle owns its buffers, so two cameras
+// (or two threads on two handles) never share result memory.
+// Valid until the next ROI call on the same handle or release_roi_buffer().
+struct RoiOutputBuffer {
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> encodeScratch;
+    std::vector<int> order;   // valid slots, largest first
+
+    void release() {
+        std::vector<uint8_t>().swap(bytes);
+        std::vector<uint8_t>().swap(encodeScratch);
+        std::vector<int>().swap(order);
+    }
+};
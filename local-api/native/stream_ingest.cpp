@@ -0,0 +1,257 @@
+#include "stream_ingest.h"
+#include "motion_detector.h"
+#include "jpeg_decode.h"
+#include "roi_crop.h"
+#include "jpeg_encode.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static bool isLiveUrl(const std::string& url) {
+    for (const char* p : {"rtsp://", "rtsps://", "rtmp://", "http://", "https://", "udp://", "tcp://", "srt://"}) {
+        if (url.rfind(p, 0) == 0) return true;
+    }
+    return false;
+}
+
+StreamIngestor& StreamIngestor::instance() {
+    static StreamIngestor ingestor;
+    return ingestor;
+}
+
+StreamIngestor::~StreamIngestor() {
+    std::map<int, std::unique_ptr<Stream>> all;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        all.swap(streams);
+    }
+    for (auto& kv : all) join(std::move(kv.second));
+}
+
+int StreamIngestor::start(const std::string& url, MotionDetector* detector, double analysisFps, int flags) {
+    if (!detector || url.empty()) return -1;
+#ifndef DSS_ENABLE_LIBAV
+    // Fara libav open() esueaza mereu: firul ar reincerca la nesfarsit, iar apelantul ar
+    // crede ca stream-ul e analizat. -1 il lasa pe drumul cu snapshot-uri.
+    std::cerr << "[Ingest] Not compiled with DSS_ENABLE_LIBAV, cannot ingest " << url << std::endl;
+    return -1;
+#endif
+
+    auto s = std::make_unique<Stream>();
+    s->url = url;
+    s->detector = detector;
+    s->fps = analysisFps > 0.0 ? analysisFps : 0.0; // 0 = every decoded frame
+    s->flags = flags;
+
+    Stream* raw = s.get();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        s->id = nextId++;
+        if (nextId <= 0) nextId = 1; // wrap-around
+        streams[s->id] = std::move(s);
+    }
+    raw->worker = std::thread(&StreamIngestor::run, this, raw);
+    std::cout << "[Ingest] Stream " << raw->id << " started: " << url << " @ " << analysisFps << " fps" << std::endl;
+    return raw->id;
+}
+
+void StreamIngestor::join(std::unique_ptr<Stream> s) {
+    if (!s) return;
+    s->stopping.store(true, std::memory_order_relaxed);
+    if (s->worker.joinable()) s->worker.join();
+}
+
+void StreamIngestor::stop(int streamId) {
+    std::unique_ptr<Stream> s;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = streams.find(streamId);
+        if (it == streams.end()) return;
+        s = std::move(it->second);
+        streams.erase(it);
+    }
+    join(std::move(s));
+    {
+        // Evenimentele ramase in coada nu mai au consumator
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.erase(std::remove_if(queue.begin(), queue.end(),
+                                   [streamId](const Pending& p) { return p.ev.streamId == streamId; }),
+                    queue.end());
+    }
+    std::cout << "[Ingest] Stream " << streamId << " stopped" << std::endl;
+}
+
+void StreamIngestor::stopDetector(MotionDetector* detector) {
+    std::vector<int> ids;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& kv : streams) {
+            if (kv.second->detector == detector) ids.push_back(kv.first);
+        }
+    }
+    for (int id : ids) stop(id);
+}
+
+int StreamIngestor::state(int streamId) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = streams.find(streamId);
+    return it == streams.end() ? INGEST_STOPPED : it->second->st.load(std::memory_order_relaxed);
+}
+
+int StreamIngestor::poll(IngestEvent* events, int maxEvents, uint8_t* arena, int arenaSize) {
+    if (!events || maxEvents <= 0) return -1;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    int n = 0;
+    size_t used = 0;
+    while (n < maxEvents && !queue.empty()) {
+        Pending& p = queue.front();
+        const size_t len = p.bytes.size();
+        IngestEvent& ev = events[n];
+        ev = p.ev;
+        ev.roi.len = (int32_t)len;
+        if (arena && arenaSize >= 0 && used + len <= (size_t)arenaSize) {
+            std::memcpy(arena + used, p.bytes.data(), len);
+            ev.roi.offset = (int32_t)used;
+            used += len;
+        } else if (n == 0) {
+            // Nu incape nici singur: il raportam fara bytes, altfel ar bloca coada
+            ev.roi.offset = -1;
+        } else {
+            break;
+        }
+        queue.pop_front();
+        ++n;
+    }
+    return n;
+}
+
+void StreamIngestor::push(Stream* s, int kind, const RoiResult& roi, int64_t tsMs) {
+    Pending p;
+    p.ev.streamId = s->id;
+    p.ev.kind = kind;
+    p.ev.timestampMs = tsMs;
+    p.ev.frameSeq = s->frameSeq;
+    p.ev.roi = roi;
+    p.bytes = s->jpeg;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (queue.size() >= kMaxQueued) queue.pop_front(); // consumer is behind: keep the newest
+    queue.push_back(std::move(p));
+}
+
+void StreamIngestor::run(Stream* s) {
+    const bool live = isLiveUrl(s->url);
+    AvStreamReader reader;
+    AvStreamOptions opt;
+    int backoffMs = 1000;
+
+    while (!s->stopping.load(std::memory_order_relaxed)) {
+        s->st.store(INGEST_CONNECTING, std::memory_order_relaxed);
+        if (!reader.open(s->url, opt)) {
+            // Reconectare cu backoff exponential (1 s .. 30 s), intrerupta de stop()
+            for (int waited = 0; waited < backoffMs && !s->stopping.load(std::memory_order_relaxed); waited += 100) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            backoffMs = std::min(backoffMs * 2, 30000);
+            continue;
+        }
+        s->st.store(INGEST_RUNNING, std::memory_order_relaxed);
+        backoffMs = 1000;
+
+        // Rata de analiza dupa timpul stream-ului (pts); fallback pe ceas monoton
+        const double period = s->fps > 0.0 ? 1.0 / s->fps : 0.0;
+        const auto opened = std::chrono::steady_clock::now();
+        double nextDue = -1.0;
+        int r = 0;
+
+        while (!s->stopping.load(std::memory_order_relaxed)) {
+            AVFrame* frame = nullptr;
+            r = reader.next(frame);
+            if (r != 0 || !frame) break;
+
+            double t = reader.frameTimeSec(frame);
+            if (t < 0.0) t = std::chrono::duration<double>(std::chrono::steady_clock::now() - opened).count();
+            if (period > 0.0) {
+                if (nextDue >= 0.0 && t < nextDue && nextDue - t < 10.0 * period) continue;
+                // Salt de pts (reset la sursa) sau prea in urma: resincronizam pe cadrul curent
+                nextDue = (nextDue < 0.0 || t - nextDue > period || nextDue - t >= 10.0 * period)
+                              ? t + period : nextDue + period;
+            }
+            analyse(s, frame);
+        }
+        reader.close();
+
+        if (!live && r == 1) {
+            s->st.store(INGEST_ENDED, std::memory_order_relaxed);
+            std::cout << "[Ingest] Stream " << s->id << " reached end of " << s->url << std::endl;
+            return;
+        }
+        if (!s->stopping.load(std::memory_order_relaxed)) {
+            std::cerr << "[Ingest] Stream " << s->id << " interrupted (" << r << "), reconnecting" << std::endl;
+        }
+    }
+    s->st.store(INGEST_STOPPED, std::memory_order_relaxed);
+}
+
+void StreamIngestor::analyse(Stream* s, const AVFrame* frame) {
+    MotionDetector* detector = s->detector;
+    cv::Mat luma;
+    RawYuvPlanes yuv;
+    if (!wrapAvFrame(frame, luma, yuv)) {
+        detector->stats().add(STAT_SKIPPED_FRAMES, 1);
+        return;
+    }
+
+    // Detectorul reduce luma la rezolutia lui de analiza;
+    // ROI-urile se taie tot din planurile YUV la rezolutia sursei
+    // Lock tinut pana dupa crop-uri: smoothRoi si config sunt starea detectorului
+    auto lock = detector->lockFrame();
+    const std::vector<int>& validSlots = detector->processFrameLocked(luma);
+    if (validSlots.empty()) return;
+    const double scale = detector->sourceScale();
+
+    const uint64_t encodeStart = motionNowUs();
+    const int64_t tsMs = wallClockMs();
+    ++s->frameSeq;
+
+    TrackTable& tt = detector->tracks();
+    const double roiPadding = detector->getConfig().roiPadding;
+    for (int slot : validSlots) {
+        cv::Rect fullBox = scaleRect(tt.bbox[slot], scale);
+        cv::Rect crop;
+        cv::Mat roi = cropROI(luma, fullBox, roiPadding, tt.smoothRoi[slot], &crop);
+        if (roi.empty() || !encodeJPEGYuv420(yuv, crop, s->jpeg, 85, &crop)) continue;
+
+        RoiResult r{};
+        r.trackId = tt.id[slot];
+        r.x = fullBox.x;
+        r.y = fullBox.y;
+        r.w = fullBox.width;
+        r.h = fullBox.height;
+        r.cropX = crop.x;
+        r.cropY = crop.y;
+        r.cropW = crop.width;
+        r.cropH = crop.height;
+        push(s, INGEST_EVENT_ROI, r, tsMs);
+    }
+
+    if (s->flags & INGEST_FULL_FRAME) {
+        const cv::Rect whole(0, 0, luma.cols, luma.rows);
+        if (encodeJPEGYuv420(yuv, whole, s->jpeg, 85)) {
+            RoiResult r{};
+            r.x = r.cropX = 0;
+            r.y = r.cropY = 0;
+            r.w = r.cropW = luma.cols;
+            r.h = r.cropH = luma.rows;
+            push(s, INGEST_EVENT_FRAME, r, tsMs);
+        }
+    }
+    detector->stats().addStage(STAGE_ENCODE, motionNowUs() - encodeStart);
+}
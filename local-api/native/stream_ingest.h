@@ -0,0 +1,99 @@
+#pragma once
+#include "av_stream.h"
+#include "roi_result.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class MotionDetector;
+
+// Ingestie continua in proces: un cititor libavformat persistent per camera
+// (RTSP sau fisier/stream local pentru teste), decodare, rata de analiza
+// configurabila si cadrele date direct detectorului (luma, zero-copy).
+// Rezultatele (ROI-uri + optional cadrul complet) intra intr-o coada pe care
+// Node o goleste cu poll_ingest_events. Inlocuieste snapshot-urile HTTP la 1 fps
+// scrise pe ramdisk.
+
+enum IngestFlags {
+    INGEST_FULL_FRAME = 1   // also emit a full-frame JPEG for frames with valid tracks
+};
+
+enum IngestState {
+    INGEST_STOPPED    = 0,
+    INGEST_CONNECTING = 1,
+    INGEST_RUNNING    = 2,
+    INGEST_ENDED      = 3   // local file reached its end
+};
+
+enum IngestEventKind {
+    INGEST_EVENT_ROI   = 0,
+    INGEST_EVENT_FRAME = 1  // roi.x/y/w/h = whole frame, trackId = 0
+};
+
+// FFI layout (oglindit de structura koffi din Node)
+struct IngestEvent {
+    int32_t streamId;
+    int32_t kind;           // IngestEventKind
+    int64_t timestampMs;    // wall clock at analysis, ms since epoch
+    int64_t frameSeq;       // analysed frames with output, per stream
+    RoiResult roi;          // offset/len: JPEG bytes in the poll arena
+};
+static_assert(sizeof(IngestEvent) == 72, "IngestEvent layout is decoded by offset in aiRequest.js");
+
+class StreamIngestor {
+public:
+    static StreamIngestor& instance();
+    ~StreamIngestor();
+
+    // The detector is driven by the ingest thread until stop(): callers must not
+    // use the same handle elsewhere meanwhile. Returns stream id (> 0) or -1.
+    int start(const std::string& url, MotionDetector* detector, double analysisFps, int flags);
+    void stop(int streamId);
+    // Stops every stream driving `detector` (called before destroying it)
+    void stopDetector(MotionDetector* detector);
+    int state(int streamId);
+
+    // Moves queued events into `events` and their JPEG bytes into `arena`.
+    // Stops at the first event that does not fit (it stays queued), except when
+    // it alone exceeds the arena: then it is returned with offset = -1 and dropped.
+    int poll(IngestEvent* events, int maxEvents, uint8_t* arena, int arenaSize);
+
+    static constexpr size_t kMaxQueued = 256; // oldest events dropped beyond this
+
+private:
+    StreamIngestor() = default;
+
+    struct Stream {
+        int id = 0;
+        std::string url;
+        MotionDetector* detector = nullptr;
+        double fps = 1.0;
+        int flags = 0;
+        std::thread worker;
+        std::atomic<bool> stopping{false};
+        std::atomic<int> st{INGEST_CONNECTING};
+        int64_t frameSeq = 0;
+        std::vector<uint8_t> jpeg;
+    };
+
+    struct Pending {
+        IngestEvent ev;
+        std::vector<uint8_t> bytes;
+    };
+
+    void run(Stream* s);
+    void analyse(Stream* s, const AVFrame* frame);
+    void push(Stream* s, int kind, const RoiResult& roi, int64_t tsMs);
+    void join(std::unique_ptr<Stream> s);
+
+    std::mutex mtx;
+    std::map<int, std::unique_ptr<Stream>> streams;
+    std::deque<Pending> queue;
+    int nextId = 1;
+};
@@ -0,0 +1,156 @@
+#include "stripe_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// O banda sub ~256K pixeli sau 64 de randuri nu acopera costul halo-ului (12 randuri
+// recitite sus/jos pentru blur + dilatare) si al sincronizarii
+static constexpr int64_t kMinStripePixels = 256 * 1024;
+static constexpr int kMinStripeRows = 64;
+
+// Fire ocupate cu analiza: workeri BatchPool intr-un cadru + workeri de benzi intr-o banda
+static std::atomic<int> busyMotionThreads{0};
+static std::atomic<StripePool*> livePool{nullptr};
+
+int motionThreadBudget() {
+    static const int budget = [] {
+        int n = (int)std::thread::hardware_concurrency();
+        if (const char* env = std::getenv("DSS_MOTION_THREADS")) {
+            int v = std::atoi(env);
+            if (v > 0) n = v;
+        }
+        return std::max(1, n);
+    }();
+    return budget;
+}
+
+void StripePool::enterBusy() {
+    busyMotionThreads.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StripePool::leaveBusy() {
+    busyMotionThreads.fetch_sub(1, std::memory_order_relaxed);
+    // Un worker de benzi poate astepta dupa buget: il trezim daca are ce face
+    StripePool* pool = livePool.load(std::memory_order_acquire);
+    if (!pool) return;
+    std::lock_guard<std::mutex> lock(pool->mtx);
+    if (!pool->pending.empty()) pool->cvWork.notify_one();
+}
+
+StripePool& StripePool::instance() {
+    static StripePool pool;
+    return pool;
+}
+
+StripePool::StripePool() {
+    // Firul apelant e si el worker, deci un fir mai putin decat bugetul
+    budget = motionThreadBudget();
+    int n = budget - 1;
+    if (const char* env = std::getenv("DSS_MOTION_STRIPE_THREADS")) {
+        int v = std::atoi(env);
+        if (v >= 0) n = v;
+    }
+
+    workers.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        workers.emplace_back(&StripePool::workerLoop, this);
+    }
+    livePool.store(this, std::memory_order_release);
+    std::cout << "[StripePool] Started " << n << " stripe workers (budget " << budget << " motion threads)" << std::endl;
+}
+
+StripePool::~StripePool() {
+    livePool.store(nullptr, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cvWork.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+int StripePool::claim(Job& job) {
+    const int index = job.next++;
+    if (job.next == job.n) {
+        pending.erase(std::find(pending.begin(), pending.end(), &job));
+    }
+    return index;
+}
+
+void StripePool::execute(Job& job, int index) {
+    std::exception_ptr error;
+    try {
+        (*job.fn)(index);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (error && !job.error) job.error = error;
+    // The job lives on the caller's stack: nothing touches it after this
+    if (++job.done == job.n) cvDone.notify_all();
+}
+
+bool StripePool::helperMayRun() const {
+    return !pending.empty() && busyMotionThreads.load(std::memory_order_relaxed) < budget;
+}
+
+void StripePool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        cvWork.wait(lock, [this] { return stopping || helperMayRun(); });
+        if (stopping) return;
+
+        Job* job = pending.front();
+        const int index = claim(*job);
+        enterBusy();
+        lock.unlock();
+        execute(*job, index);
+        busyMotionThreads.fetch_sub(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+}
+
+void StripePool::run(int n, const std::function<void(int)>& fn) {
+    if (n <= 0) return;
+    if (n == 1 || workers.empty()) {
+        for (int i = 0; i < n; ++i) fn(i);
+        return;
+    }
+
+    Job job;
+    job.fn = &fn;
+    job.n = n;
+
+    std::unique_lock<std::mutex> lock(mtx);
+    pending.push_back(&job);
+    lock.unlock();
+    if (n - 1 >= (int)workers.size()) {
+        cvWork.notify_all();
+    } else {
+        for (int i = 0; i < n - 1; ++i) cvWork.notify_one();
+    }
+
+    // Apelantul isi ia si el benzile; daca pool-ul e ocupat cu alte cadre le face pe toate
+    lock.lock();
+    while (job.next < job.n) {
+        const int index = claim(job);
+        lock.unlock();
+        execute(job, index);
+        lock.lock();
+    }
+    cvDone.wait(lock, [&job] { return job.done == job.n; });
+    lock.unlock();
+
+    if (job.error) std::rethrow_exception(job.error);
+}
+
+int parallelStripeCount(int rows, int64_t pixels) {
+    const int64_t byPixels = pixels / kMinStripePixels;
+    const int byRows = rows / kMinStripeRows;
+    const int n = (int)std::min<int64_t>({byPixels, (int64_t)byRows,
+                                           (int64_t)StripePool::instance().concurrency()});
+    return std::max(1, n);
+}
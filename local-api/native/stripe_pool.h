@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool comun pentru paralelismul din interiorul unui cadru (benzi orizontale, camere 4K/8MP).
+// Firul apelant lucreaza si el pe benzile cadrului propriu, iar workerii liberi fura benzi
+// din orice cadru in asteptare. Cu multe camere pe FrameBatchProcessor un cadru mare nu
+// asteapta dupa pool: in cel mai rau caz benzile lui ruleaza toate pe firul apelant.
+//
+// Bugetul de fire e comun cu FrameBatchProcessor (motionThreadBudget): workerii de benzi
+// iau o banda doar cat timp sunt mai putin de `budget` fire ocupate cu analiza (workerii
+// BatchPool in cadru + workerii de benzi activi), deci cele doua pool-uri impreuna nu
+// suprasubscriu nucleele. Apelantul lui run() lucreaza oricum pe benzile proprii.
+class StripePool {
+public:
+    static StripePool& instance();
+
+    // Runs fn(0) .. fn(n - 1) and returns when all of them are done; the calling thread
+    // takes part. An exception thrown by fn is rethrown here once every stripe finished.
+    void run(int n, const std::function<void(int)>& fn);
+
+    // Threads that can work on one frame at the same time (workers + caller)
+    int concurrency() const { return (int)workers.size() + 1; }
+
+    // Busy accounting shared with FrameBatchProcessor (see MotionThreadScope)
+    static void enterBusy();
+    static void leaveBusy();
+
+private:
+    struct Job {
+        const std::function<void(int)>* fn = nullptr;
+        int n = 0;
+        int next = 0; // next unclaimed stripe
+        int done = 0;
+        std::exception_ptr error;
+    };
+
+    StripePool();
+    ~StripePool();
+    StripePool(const StripePool&) = delete;
+    StripePool& operator=(const StripePool&) = delete;
+
+    void workerLoop();
+    bool helperMayRun() const; // mtx held
+    int claim(Job& job); // mtx held
+    void execute(Job& job, int index);
+
+    std::mutex mtx;
+    std::condition_variable cvWork;
+    std::condition_variable cvDone;
+    std::deque<Job*> pending; // jobs with unclaimed stripes, oldest first
+    bool stopping = false;
+    int budget = 1;
+    std::vector<std::thread> workers;
+};
+
+// Motion threads for the whole process: DSS_MOTION_THREADS, else the core count.
+// FrameBatchProcessor starts that many workers; StripePool helpers fit in the same budget.
+int motionThreadBudget();
+
+// A FrameBatchProcessor worker busy on a frame, for the lifetime of the scope
+class MotionThreadScope {
+public:
+    MotionThreadScope() { StripePool::enterBusy(); }
+    ~MotionThreadScope() { StripePool::leaveBusy(); }
+    MotionThreadScope(const MotionThreadScope&) = delete;
+    MotionThreadScope& operator=(const MotionThreadScope&) = delete;
+};
+
+// Horizontal stripes for a region of `rows` x `pixels`: 1 (serial) when it is too small
+// for the split to pay off, at most StripePool::concurrency()
+int parallelStripeCount(int rows, int64_t pixels);
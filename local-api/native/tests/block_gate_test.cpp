@@ -0,0 +1,98 @@
+// Test pentru pre-filtrul pe blocuri (block_gate.h), rulat de ctest.
+//
+//  1. scena statica (cu zgomot mic de senzor) -> cadrele sunt sarite, cu exceptia
+//     refresh-ului fortat dupa kMaxLagFrames
+//  2. un patrat intra in cadru si se opreste -> blocurile lui raman procesate cat timp
+//     difera de fundal (referinta e fundalul, nu cadrul anterior), track-ul nu pierde obiectul
+//  3. patratul pleaca -> locul lui e procesat (fundalul inca il contine partial)
+//
+//   block_gate_test
+// Exit 0 = tot a trecut.
+
+#include "../block_gate.h"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int gFailures = 0;
+
+static void fail(const std::string& what) {
+    ++gFailures;
+    if (gFailures <= 20) std::cerr << "[GateTest] FAIL " << what << std::endl;
+}
+
+static constexpr int kWidth = 320;
+static constexpr int kHeight = 240;
+static constexpr double kRate = 0.01; // CameraConfig::bgLearningRate implicit
+
+// Fundal texturat + zgomot +-1, patratul (daca e dat) peste el
+static void makeFrame(cv::Mat& f, std::mt19937& rng, const cv::Rect& square) {
+    f.create(kHeight, kWidth, CV_8UC1);
+    std::uniform_int_distribution<int> noise(-1, 1);
+    for (int y = 0; y < kHeight; ++y) {
+        uint8_t* row = f.ptr<uint8_t>(y);
+        for (int x = 0; x < kWidth; ++x) {
+            const int v = square.contains(cv::Point(x, y)) ? 230 : 64 + (x * 7 + y * 13) % 64;
+            row[x] = (uint8_t)(v + noise(rng));
+        }
+    }
+}
+
+static bool covers(const std::vector<GateRegion>& regions, cv::Point p) {
+    for (const GateRegion& r : regions) {
+        if (r.rect.contains(p)) return true;
+    }
+    return false;
+}
+
+int main() {
+    std::mt19937 rng(7);
+    BlockActivityGate gate;
+    std::vector<GateRegion> regions;
+    cv::Mat frame;
+
+    // 1
+    makeFrame(frame, rng, cv::Rect());
+    if (!gate.analyse(frame, regions, kRate) || regions.size() != 1 ||
+        regions[0].rect != cv::Rect(0, 0, kWidth, kHeight)) {
+        fail("seed frame not processed in full");
+    }
+    const int staticFrames = 2 * BlockActivityGate::kMaxLagFrames;
+    int processed = 0;
+    for (int i = 0; i < staticFrames; ++i) {
+        makeFrame(frame, rng, cv::Rect());
+        if (gate.analyse(frame, regions, kRate)) processed++;
+    }
+    // Doar refresh-urile fortate (o data la kMaxLagFrames + 1 cadre)
+    if (processed > staticFrames / BlockActivityGate::kMaxLagFrames + 1) {
+        fail("static scene: " + std::to_string(processed) + "/" + std::to_string(staticFrames) + " frames processed");
+    }
+
+    // 2. Intra in 8 cadre, apoi sta pe loc
+    cv::Rect square(20, 90, 48, 48);
+    for (int i = 0; i < 8; ++i) {
+        square.x += 12;
+        makeFrame(frame, rng, square);
+        gate.analyse(frame, regions, kRate);
+    }
+    const cv::Point centre(square.x + square.width / 2, square.y + square.height / 2);
+    const int stoppedFrames = 60;
+    int missed = 0;
+    for (int i = 0; i < stoppedFrames; ++i) {
+        makeFrame(frame, rng, square);
+        if (!gate.analyse(frame, regions, kRate) || !covers(regions, centre)) missed++;
+    }
+    if (missed) fail("stopped object: skipped in " + std::to_string(missed) + "/" + std::to_string(stoppedFrames) + " frames");
+
+    // 3
+    makeFrame(frame, rng, cv::Rect());
+    if (!gate.analyse(frame, regions, kRate) || !covers(regions, centre)) fail("area left by the object not processed");
+
+    std::cout << "[GateTest] static: " << processed << "/" << staticFrames << " frames processed, stopped object: "
+              << (stoppedFrames - missed) << "/" << stoppedFrames << " frames processed" << std::endl;
+    std::cout << "[GateTest] " << (gFailures ? "FAILED, " + std::to_string(gFailures) + " failures" : std::string("OK"))
+              << std::endl;
+    return gFailures ? 1 : 0;
+}
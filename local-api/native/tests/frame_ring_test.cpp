@@ -0,0 +1,164 @@
+// Test pentru inelul de cadre in memorie partajata (frame_ring.h), rulat de ctest.
+//
+//  1. publicare: inel gol -> nimic; dupa 5 cadre consumatorul vede doar ultimul, o data
+//  2. varsta: un cadru mai vechi decat maxAgeMs e sarit
+//  3. lap: producatorul rescrie slotul citit -> stillValid / copyFrame refuza cadrul
+//  4. concurent: producator in loc (beginWrite / commit) la viteza maxima, consumatorul
+//     copiaza (ca process_frame_ring) -> nicio copie acceptata nu e amestecata
+//  5. I420 cu latime impara: croma are (w + 1) / 2 octeti pe rand, publish dintr-un buffer
+//     cu alt stride pastreaza si ultima coloana de croma
+//
+//   frame_ring_test
+// Exit 0 = tot a trecut, 77 = fara memorie partajata POSIX (ctest: skipped).
+
+#include "../frame_ring.h"
+#include "../raw_frame.h"
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+static int gFailures = 0;
+
+static void fail(const std::string& what) {
+    ++gFailures;
+    std::cerr << "[RingTest] FAIL " << what << std::endl;
+}
+
+static bool allEqual(const uint8_t* p, size_t n, uint8_t v) {
+    for (size_t i = 0; i < n; ++i) {
+        if (p[i] != v) return false;
+    }
+    return true;
+}
+
+int main() {
+    const std::string name = "/dss_ring_test_" + std::to_string(getpid());
+    const int slots = kFrameRingMinSlots;
+    FrameRingWriter w;
+    if (!w.create(name, 320, 240, 0, PIXFMT_I420, slots)) {
+        std::cout << "[RingTest] SKIP: cannot create " << name << std::endl;
+        return 77;
+    }
+    FrameRingReader r;
+    if (!r.open(name)) {
+        fail("open reader");
+        w.close(true);
+        return 1;
+    }
+    const size_t bytes = w.header().frameBytes;
+    std::vector<uint8_t> f(bytes);
+
+    // 1
+    RingFrameView v;
+    if (r.latest(v, 0)) fail("empty ring returned a frame");
+    for (int i = 1; i <= 5; ++i) {
+        std::fill(f.begin(), f.end(), (uint8_t)i);
+        w.publish(f.data(), 0, frameRingNowMs());
+    }
+    if (!r.latest(v, 1000)) {
+        fail("no frame after 5 publishes");
+    } else {
+        if (v.frameNumber != 5) fail("latest frame " + std::to_string(v.frameNumber) + ", expected 5");
+        if (!allEqual(v.data, bytes, 5)) fail("latest view does not hold frame 5");
+        if (!r.stillValid(v)) fail("fresh view not valid");
+        const uint8_t* copy = r.copyFrame(v);
+        if (!copy || !allEqual(copy, bytes, 5)) fail("copy of an untouched slot rejected or wrong");
+    }
+    if (r.latest(v, 0)) fail("same frame returned twice");
+
+    // 2
+    std::fill(f.begin(), f.end(), (uint8_t)6);
+    w.publish(f.data(), 0, frameRingNowMs() - 5000);
+    RingFrameView old;
+    if (r.latest(old, 1000)) fail("frame older than maxAgeMs returned");
+
+    // 3
+    std::fill(f.begin(), f.end(), (uint8_t)7);
+    w.publish(f.data(), 0, frameRingNowMs());
+    RingFrameView lapped;
+    if (!r.latest(lapped, 0)) {
+        fail("no frame before the lap");
+    } else {
+        for (int i = 0; i < slots; ++i) w.publish(f.data(), 0, frameRingNowMs());
+        if (r.stillValid(lapped)) fail("lapped view still valid");
+        if (r.copyFrame(lapped)) fail("copy of a lapped slot accepted");
+    }
+
+    // 4
+    std::atomic<bool> stop{false};
+    long ok = 0, torn = 0, mixed = 0;
+    std::thread producer([&] {
+        for (int i = 0; i < 20000; ++i) {
+            uint8_t* d = w.beginWrite();
+            std::memset(d, i & 255, bytes);
+            w.commit(frameRingNowMs());
+        }
+        stop = true;
+    });
+    while (!stop) {
+        RingFrameView x;
+        if (!r.latest(x, 0)) continue;
+        const uint8_t* copy = r.copyFrame(x);
+        if (!copy) {
+            torn++;
+            continue;
+        }
+        if (allEqual(copy, bytes, copy[0])) ok++;
+        else mixed++;
+    }
+    producer.join();
+    std::cout << "[RingTest] concurrent: " << ok << " copies ok, " << torn << " torn (rejected), "
+              << mixed << " mixed" << std::endl;
+    if (mixed) fail(std::to_string(mixed) + " accepted copies mix two frames");
+    if (ok == 0) fail("no frame consumed during the concurrent run");
+
+    w.close(true);
+
+    // 5
+    {
+        const int ow = 321, oh = 241, srcStride = 336, cw = (ow + 1) / 2, ch = (oh + 1) / 2;
+        FrameRingWriter odd;
+        if (!odd.create(name + "_odd", ow, oh, ow, PIXFMT_I420, slots)) {
+            fail("create odd-width ring");
+        } else {
+            if (odd.header().frameBytes != (uint64_t)ow * oh + 2ull * cw * ch) {
+                fail("odd-width I420 frameBytes " + std::to_string(odd.header().frameBytes));
+            }
+            // Sursa: Y = 1, U = 2, V = 3 pe latimea utila, 0 in padding
+            std::vector<uint8_t> src((size_t)srcStride * oh + 2 * (size_t)((srcStride + 1) / 2) * ch, 0);
+            for (int y = 0; y < oh; ++y) std::fill_n(&src[(size_t)y * srcStride], ow, (uint8_t)1);
+            uint8_t* su = &src[(size_t)srcStride * oh];
+            uint8_t* sv = su + (size_t)((srcStride + 1) / 2) * ch;
+            for (int y = 0; y < ch; ++y) {
+                std::fill_n(su + (size_t)y * ((srcStride + 1) / 2), cw, (uint8_t)2);
+                std::fill_n(sv + (size_t)y * ((srcStride + 1) / 2), cw, (uint8_t)3);
+            }
+            odd.publish(src.data(), srcStride, frameRingNowMs());
+
+            FrameRingReader oddReader;
+            RingFrameView oddView;
+            RawYuvPlanes p;
+            if (!oddReader.open(name + "_odd") || !oddReader.latest(oddView, 0)) {
+                fail("no frame from the odd-width ring");
+            } else if (!wrapRawYuv(oddView.data, ow, oh, ow, PIXFMT_I420, p) || p.strideUV != cw) {
+                fail("odd-width I420 chroma stride " + std::to_string(p.strideUV) + ", expected " + std::to_string(cw));
+            } else {
+                bool good = true;
+                for (int y = 0; y < oh && good; ++y) good = allEqual(p.y + (size_t)y * p.strideY, ow, 1);
+                for (int y = 0; y < ch && good; ++y) {
+                    good = allEqual(p.u + (size_t)y * p.strideUV, cw, 2) && allEqual(p.v + (size_t)y * p.strideUV, cw, 3);
+                }
+                if (!good) fail("odd-width I420 planes damaged by publish");
+            }
+            odd.close(true);
+        }
+    }
+
+    std::cout << "[RingTest] " << (gFailures ? "FAILED, " + std::to_string(gFailures) + " failures" : std::string("OK"))
+              << std::endl;
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,307 @@
+// Test pentru kernelul fuzionat (motion_kernel.h), rulat de ctest.
+//
+//  1. primitive: fiecare ISA suportat de CPU (SSE4 / AVX2 / NEON) produce exact aceiasi
+//     octeti ca setul scalar de referinta, pe randuri de lungimi aleatoare (cozile incluse),
+//     cu bgUpdate pana la alpha = 1 (ratele de recuperare ale block gate-ului)
+//  2. kernel complet: cadre gray/BGR aleatoare, regiuni aleatoare, rate mari si ponderi
+//     per bloc -> masca si fundalul identice cu scalarul; benzile cu haloBg (StripePool)
+//     identice cu un singur sweep pe tot cadrul
+//  3. referinta OpenCV: blur-ul Q8 21 tap fata de cv::GaussianBlur(21x21, sigma 0) si
+//     masca fata de absdiff + prag + dilate 5x5, in toleranta (tap-uri cuantizate in Q8)
+//
+//   motion_kernel_test [--seed N]
+// Exit 0 = tot a trecut; fiecare esec e raportat pe stderr cu ISA-ul si cazul.
+
+#include "../motion_kernel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int gFailures = 0;
+
+static void fail(const std::string& what) {
+    ++gFailures;
+    if (gFailures <= 20) std::cerr << "[KernelTest] FAIL " << what << std::endl;
+}
+
+static std::vector<KernelIsa> simdIsas() {
+    std::vector<KernelIsa> out;
+    for (KernelIsa isa : {KernelIsa::SSE4, KernelIsa::AVX2, KernelIsa::NEON}) {
+        if (motionKernelIsaSupported(isa)) out.push_back(isa);
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// 1. Primitive
+// ---------------------------------------------------------------------------
+
+static void testPrimitives(std::mt19937& rng, const MotionKernelOps& simd) {
+    const MotionKernelOps& ref = motionKernelOps(KernelIsa::Scalar);
+    const std::string isa = simd.name;
+
+    for (int iter = 0; iter < 400; ++iter) {
+        const int n = (int)(rng() % 300);
+
+        std::vector<uint8_t> padded(n + kBlurTaps);
+        for (uint8_t& v : padded) v = (uint8_t)rng();
+        std::vector<int16_t> h0(n), h1(n);
+        ref.hblur(padded.data(), h0.data(), n);
+        simd.hblur(padded.data(), h1.data(), n);
+        if (h0 != h1) fail(isa + " hblur n=" + std::to_string(n));
+
+        // Randuri Q7 realiste: blur orizontal al unor randuri gray aleatoare
+        std::vector<std::vector<int16_t>> rows(kBlurTaps, std::vector<int16_t>(n));
+        const int16_t* rp[kBlurTaps];
+        for (int k = 0; k < kBlurTaps; ++k) {
+            for (uint8_t& v : padded) v = (uint8_t)rng();
+            ref.hblur(padded.data(), rows[k].data(), n);
+            rp[k] = rows[k].data();
+        }
+        std::vector<uint16_t> v0(n), v1(n);
+        ref.vblur(rp, v0.data(), n);
+        simd.vblur(rp, v1.data(), n);
+        if (v0 != v1) fail(isa + " vblur n=" + std::to_string(n));
+
+        // Extremele Q8 (0 / 65280) in ambele sensuri, apoi valori aleatoare
+        std::vector<uint16_t> blur(n), bg(n);
+        for (int i = 0; i < n; ++i) {
+            const int mode = (int)(rng() % 4);
+            blur[i] = mode == 0 ? 65280 : mode == 1 ? 0 : (uint16_t)(rng() % 65281);
+            bg[i] = mode == 0 ? 0 : mode == 1 ? 65280 : (uint16_t)(rng() % 65281);
+        }
+        const int thrQ8 = (int)(rng() % 256) * 256;
+        std::vector<uint8_t> t0(n), t1(n);
+        ref.diffThreshold(blur.data(), bg.data(), t0.data(), n, thrQ8);
+        simd.diffThreshold(blur.data(), bg.data(), t1.data(), n, thrQ8);
+        if (t0 != t1) fail(isa + " diffThreshold n=" + std::to_string(n));
+
+        for (int alpha : {0, 1, 328, 16384, 30474, 32767, 32768, (int)(rng() % 32769)}) {
+            std::vector<uint16_t> b0(n), b1(n);
+            ref.bgUpdate(blur.data(), bg.data(), b0.data(), n, alpha);
+            simd.bgUpdate(blur.data(), bg.data(), b1.data(), n, alpha);
+            if (b0 != b1) fail(isa + " bgUpdate alphaQ15=" + std::to_string(alpha) + " n=" + std::to_string(n));
+            // Fundalul ramane intre valoarea veche si cea noua (fara wrap)
+            for (int i = 0; i < n; ++i) {
+                if (b0[i] < std::min(blur[i], bg[i]) || b0[i] > std::max(blur[i], bg[i])) {
+                    fail("scalar bgUpdate out of range alphaQ15=" + std::to_string(alpha));
+                    break;
+                }
+            }
+        }
+
+        std::vector<uint8_t> thr(n + 4);
+        for (uint8_t& v : thr) v = rng() % 3 ? 0 : 255;
+        std::vector<uint8_t> m0(n), m1(n);
+        ref.hmax5(thr.data(), m0.data(), n);
+        simd.hmax5(thr.data(), m1.data(), n);
+        if (m0 != m1) fail(isa + " hmax5 n=" + std::to_string(n));
+
+        std::vector<std::vector<uint8_t>> mr(5, std::vector<uint8_t>(n));
+        const uint8_t* mp[5];
+        for (int k = 0; k < 5; ++k) {
+            for (uint8_t& v : mr[k]) v = rng() % 3 ? 0 : 255;
+            mp[k] = mr[k].data();
+        }
+        ref.vmax5(mp, m0.data(), n);
+        simd.vmax5(mp, m1.data(), n);
+        if (m0 != m1) fail(isa + " vmax5 n=" + std::to_string(n));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 2. Kernel complet
+// ---------------------------------------------------------------------------
+
+// Scena: textura + dreptunghiuri care se misca + zgomot, gray sau BGR
+static void makeFrame(std::mt19937& rng, cv::Mat& f, int frameNo) {
+    const int ch = f.channels();
+    for (int y = 0; y < f.rows; ++y) {
+        uint8_t* p = f.ptr<uint8_t>(y);
+        for (int x = 0; x < f.cols; ++x) {
+            int v = 40 + ((x / 11 + y / 7) % 6) * 25 + (int)(rng() % 6);
+            const int ox = (frameNo * 9) % std::max(1, f.cols), oy = (frameNo * 5) % std::max(1, f.rows);
+            if (x >= ox && x < ox + f.cols / 4 && y >= oy && y < oy + f.rows / 4) v = 230;
+            for (int c = 0; c < ch; ++c) p[x * ch + c] = (uint8_t)std::min(255, v + c * 7);
+        }
+    }
+}
+
+static bool sameMats(const cv::Mat& a, const cv::Mat& b, size_t rowBytes) {
+    if (a.rows != b.rows) return false;
+    for (int y = 0; y < a.rows; ++y) {
+        if (std::memcmp(a.ptr<uint8_t>(y), b.ptr<uint8_t>(y), rowBytes) != 0) return false;
+    }
+    return true;
+}
+
+// Ca CpuMaskBackend::runRegion: benzi orizontale, halo-ul de fundal fotografiat inainte
+static void runStriped(const cv::Mat& f, cv::Mat& bg, cv::Mat& mask, const MotionKernelParams& p,
+                       const cv::Rect& region, int stripes, const MotionKernelOps& ops) {
+    std::vector<cv::Rect> rects(stripes);
+    std::vector<cv::Mat> halo(stripes);
+    for (int i = 0; i < stripes; ++i) {
+        const int y0 = region.y + region.height * i / stripes;
+        const int y1 = region.y + region.height * (i + 1) / stripes;
+        rects[i] = cv::Rect(region.x, y0, region.width, y1 - y0);
+        halo[i].create(2 * kDilateRadius, f.cols, CV_16UC1);
+        for (int j = 0; j < kDilateRadius; ++j) {
+            const int above = y0 - kDilateRadius + j;
+            const int below = y1 + j;
+            if (above >= 0) std::memcpy(halo[i].ptr(j), bg.ptr(above), (size_t)f.cols * 2);
+            if (below < f.rows) std::memcpy(halo[i].ptr(kDilateRadius + j), bg.ptr(below), (size_t)f.cols * 2);
+        }
+    }
+    // Benzile in ordine inversa pe un fir: fara snapshot ar citi fundalul deja actualizat
+    MotionKernelScratch scratch;
+    for (int i = stripes - 1; i >= 0; --i) {
+        runMotionKernel(f, bg, mask, p, scratch, false, rects[i], &ops, &halo[i]);
+    }
+}
+
+static void testKernel(std::mt19937& rng, const std::vector<KernelIsa>& isas) {
+    const MotionKernelOps& ref = motionKernelOps(KernelIsa::Scalar);
+    std::vector<const MotionKernelOps*> all = {&ref};
+    for (KernelIsa isa : isas) all.push_back(&motionKernelOps(isa));
+
+    for (int iter = 0; iter < 80; ++iter) {
+        const int W = 24 + (int)(rng() % 280);
+        const int H = 24 + (int)(rng() % 200);
+        const int type = iter % 3 == 0 ? CV_8UC3 : CV_8UC1;
+        const std::string tag = "iter " + std::to_string(iter) + " " + std::to_string(W) + "x" + std::to_string(H);
+
+        // Ponderi per bloc (lazy background): nominal pe cele mai multe, recuperare pe unele
+        const int bs = 16, bcols = (W + bs - 1) / bs, brows = (H + bs - 1) / bs;
+        std::vector<uint16_t> blockAlpha((size_t)bcols * brows);
+        for (uint16_t& a : blockAlpha) a = rng() % 4 ? 328 : (uint16_t)(16384 + rng() % 16385);
+
+        std::vector<cv::Mat> bgs(all.size()), masks(all.size());
+        cv::Mat bgStriped, maskStriped;
+        MotionKernelScratch scratch;
+        cv::Mat frame(H, W, type);
+        for (int fr = 0; fr < 5; ++fr) {
+            makeFrame(rng, frame, fr + iter);
+            const bool init = fr == 0;
+
+            MotionKernelParams p;
+            p.threshold = 5 + (int)(rng() % 40);
+            const double rates[] = {0.01, 0.05, 0.5, 0.93, 1.0};
+            p.learningRate = rates[rng() % 5];
+            if (fr >= 3) {
+                p.blockAlphaQ15 = blockAlpha.data();
+                p.blockSize = bs;
+                p.blockCols = bcols;
+            }
+            cv::Rect region(0, 0, W, H);
+            if (!init && rng() % 2) {
+                const int x = (int)(rng() % (W / 2)), y = (int)(rng() % (H / 2));
+                region = cv::Rect(x, y, 1 + (int)(rng() % (W - x)), 1 + (int)(rng() % (H - y)));
+            }
+
+            for (size_t k = 0; k < all.size(); ++k) {
+                runMotionKernel(frame, bgs[k], masks[k], p, scratch, init, region, all[k]);
+            }
+            for (size_t k = 1; k < all.size(); ++k) {
+                if (!sameMats(bgs[0], bgs[k], (size_t)W * 2) || !sameMats(masks[0], masks[k], (size_t)W)) {
+                    fail(std::string(all[k]->name) + " kernel != scalar, " + tag + " frame " + std::to_string(fr) +
+                         " rate " + std::to_string(p.learningRate));
+                }
+            }
+
+            // Benzi cu haloBg: acelasi rezultat ca un sweep (ISA aleator)
+            const MotionKernelOps& ops = *all[rng() % all.size()];
+            if (init) {
+                runMotionKernel(frame, bgStriped, maskStriped, p, scratch, true, region, &ops);
+            } else {
+                runStriped(frame, bgStriped, maskStriped, p, region, 1 + (int)(rng() % std::min(8, region.height)), ops);
+            }
+            if (!sameMats(bgs[0], bgStriped, (size_t)W * 2) || !sameMats(masks[0], maskStriped, (size_t)W)) {
+                fail(std::string(ops.name) + " striped (haloBg) != full sweep, " + tag + " frame " + std::to_string(fr));
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 3. Referinta OpenCV
+// ---------------------------------------------------------------------------
+
+static void testAgainstOpenCv(std::mt19937& rng) {
+    const int W = 320, H = 240;
+    for (int iter = 0; iter < 6; ++iter) {
+        const int type = iter % 2 ? CV_8UC3 : CV_8UC1;
+        cv::Mat a(H, W, type), b(H, W, type);
+        makeFrame(rng, a, iter);
+        makeFrame(rng, b, iter + 3);
+
+        cv::Mat grayA = a, grayB = b;
+        if (type == CV_8UC3) {
+            cv::cvtColor(a, grayA, cv::COLOR_BGR2GRAY);
+            cv::cvtColor(b, grayB, cv::COLOR_BGR2GRAY);
+        }
+        cv::Mat fa, fb, refA, refB;
+        grayA.convertTo(fa, CV_32F);
+        grayB.convertTo(fb, CV_32F);
+        cv::GaussianBlur(fa, refA, cv::Size(kBlurTaps, kBlurTaps), 0, 0, cv::BORDER_REFLECT_101);
+        cv::GaussianBlur(fb, refB, cv::Size(kBlurTaps, kBlurTaps), 0, 0, cv::BORDER_REFLECT_101);
+
+        // Blur: fundalul seed-uit (Q8) fata de GaussianBlur in float
+        MotionKernelParams p;
+        p.threshold = 25;
+        p.learningRate = 0.0; // fundalul ramane blur(a), comparabil cu refA
+        MotionKernelScratch scratch;
+        cv::Mat bg, mask;
+        runMotionKernel(a, bg, mask, p, scratch, true);
+        cv::Mat bgF, err;
+        bg.convertTo(bgF, CV_32F, 1.0 / 256.0);
+        cv::absdiff(bgF, refA, err);
+        double maxErr = 0.0;
+        cv::minMaxLoc(err, nullptr, &maxErr);
+        const double meanErr = cv::mean(err)[0];
+        if (maxErr > 2.0 || meanErr > 0.35) {
+            fail("blur vs cv::GaussianBlur, iter " + std::to_string(iter) + ": max " + std::to_string(maxErr) +
+                 " mean " + std::to_string(meanErr));
+        }
+
+        // Masca: absdiff + prag + dilate 5x5 pe blur-urile OpenCV
+        runMotionKernel(b, bg, mask, p, scratch, false);
+        cv::Mat diff, thr, dilated, mismatch;
+        cv::absdiff(refB, refA, diff);
+        cv::compare(diff, (double)p.threshold, thr, cv::CMP_GT);
+        cv::dilate(thr, dilated, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5)));
+        cv::compare(dilated, mask, mismatch, cv::CMP_NE);
+        const double frac = (double)cv::countNonZero(mismatch) / (double)(W * H);
+        if (frac > 0.002) {
+            fail("mask vs absdiff/threshold/dilate, iter " + std::to_string(iter) + ": " +
+                 std::to_string(frac * 100.0) + "% pixels differ");
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned seed = 1234;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+    }
+    std::mt19937 rng(seed);
+
+    const std::vector<KernelIsa> isas = simdIsas();
+    std::cout << "[KernelTest] seed " << seed << ", ISAs vs scalar:";
+    for (KernelIsa isa : isas) std::cout << " " << motionKernelOps(isa).name;
+    std::cout << (isas.empty() ? " none" : "") << std::endl;
+
+    for (KernelIsa isa : isas) testPrimitives(rng, motionKernelOps(isa));
+    testKernel(rng, isas);
+    testAgainstOpenCv(rng);
+
+    std::cout << "[KernelTest] " << (gFailures ? "FAILED, " + std::to_string(gFailures) + " failures" : std::string("OK"))
+              << std::endl;
+    return gFailures ? 1 : 0;
+}
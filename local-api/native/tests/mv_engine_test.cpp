@@ -0,0 +1,333 @@
+// Test offline pentru motorul pe vectori de miscare (mv_engine.h), rulat de ctest
+// (doar cu DSS_ENABLE_LIBAV).
+//
+//  1. clip sintetic encodat aici (libx264, altfel encoderul mpeg4 din FFmpeg) si scris ca
+//     segmentele recorderului (mp4 fragmentat, seg_<epoch>_<n>.mp4): un patrat texturat
+//     care se misca peste un fundal static -> track valid peste patrat in cadrele P,
+//     fara detectii in alta parte; track-ul continua in segmentul urmator (acelasi id)
+//  2. acelasi fundal fara patrat -> nicio detectie; clipul cu patrat si drumul lui intr-o
+//     zona exclusa -> nicio detectie
+//  3. un codec fara export de vectori (HEVC, daca exista libx265) -> open() refuza
+//  4. processFrame(cv::Mat) -> false (motorul nu are vectori pe pixeli)
+//  5. optional, segmente reale: --segments <dir> (sau DSS_MV_TEST_SEGMENTS) -> fiecare
+//     segment H.264 se deschide si are cadre cu vectori
+//
+//   mv_engine_test [--segments DIR]
+// Exit 0 = tot a trecut, 77 = fara encoder utilizabil (ctest: skipped).
+
+#include "../mv_engine.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static int gFailures = 0;
+
+static void fail(const std::string& what) {
+    ++gFailures;
+    std::cerr << "[MvTest] FAIL " << what << std::endl;
+}
+
+static constexpr int kWidth = 640;
+static constexpr int kHeight = 360;
+static constexpr int kFps = 25;
+static constexpr int kSegmentFrames = 50; // 2 s, un GOP per segment (ca recorderul)
+static constexpr int kSquare = 80;
+
+// Pozitia patratului in cadrul global `n` (segmentele continua miscarea)
+static cv::Rect squareAt(int n) {
+    return cv::Rect(40 + 4 * n, 100 + n, kSquare, kSquare);
+}
+
+// Fundal static texturat: encoderul are ce potrivi, vectorii raman ~0
+static void fillFrame(AVFrame* f, int n, bool withSquare) {
+    for (int y = 0; y < kHeight; ++y) {
+        uint8_t* row = f->data[0] + (size_t)y * f->linesize[0];
+        for (int x = 0; x < kWidth; ++x) {
+            row[x] = (uint8_t)(128 + 50 * std::sin(x * 0.09) * std::cos(y * 0.07) + ((x / 16 + y / 16) & 1) * 20);
+        }
+    }
+    for (int y = 0; y < kHeight / 2; ++y) {
+        std::fill(f->data[1] + (size_t)y * f->linesize[1], f->data[1] + (size_t)y * f->linesize[1] + kWidth / 2, 128);
+        std::fill(f->data[2] + (size_t)y * f->linesize[2], f->data[2] + (size_t)y * f->linesize[2] + kWidth / 2, 128);
+    }
+    if (!withSquare) return;
+
+    // Tabla de sah 8x8 in patrat: textura cu muchii, vectorii se gasesc usor
+    const cv::Rect r = squareAt(n) & cv::Rect(0, 0, kWidth, kHeight);
+    const cv::Rect s = squareAt(n);
+    for (int y = r.y; y < r.y + r.height; ++y) {
+        uint8_t* row = f->data[0] + (size_t)y * f->linesize[0];
+        for (int x = r.x; x < r.x + r.width; ++x) {
+            row[x] = (((x - s.x) / 8 + (y - s.y) / 8) & 1) ? 235 : 20;
+        }
+    }
+}
+
+static void drainEncoder(AVCodecContext* enc, AVFormatContext* oc, AVStream* st, AVPacket* pkt) {
+    while (avcodec_receive_packet(enc, pkt) == 0) {
+        av_packet_rescale_ts(pkt, enc->time_base, st->time_base);
+        pkt->stream_index = st->index;
+        av_interleaved_write_frame(oc, pkt);
+    }
+}
+
+// Scrie `frames` cadre incepand cu cadrul global `first`. False daca encoderul lipseste.
+static bool writeClip(const std::string& path, const AVCodec* codec, int first, int frames, bool withSquare) {
+    AVFormatContext* oc = nullptr;
+    if (avformat_alloc_output_context2(&oc, nullptr, "mp4", path.c_str()) < 0 || !oc) return false;
+
+    AVCodecContext* enc = avcodec_alloc_context3(codec);
+    enc->width = kWidth;
+    enc->height = kHeight;
+    enc->pix_fmt = AV_PIX_FMT_YUV420P;
+    enc->time_base = AVRational{1, kFps};
+    enc->framerate = AVRational{kFps, 1};
+    enc->gop_size = kSegmentFrames;
+    enc->max_b_frames = 0;
+    enc->bit_rate = 4000000;
+    if (oc->oformat->flags & AVFMT_GLOBALHEADER) enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    AVDictionary* encOpts = nullptr;
+    if (std::string(codec->name) == "libx264" || std::string(codec->name) == "libx265") {
+        av_dict_set(&encOpts, "preset", "veryfast", 0);
+    }
+    const int r = avcodec_open2(enc, codec, &encOpts);
+    av_dict_free(&encOpts);
+    if (r < 0) {
+        avcodec_free_context(&enc);
+        avformat_free_context(oc);
+        return false;
+    }
+
+    AVStream* st = avformat_new_stream(oc, nullptr);
+    avcodec_parameters_from_context(st->codecpar, enc);
+    st->time_base = enc->time_base;
+
+    bool ok = avio_open(&oc->pb, path.c_str(), AVIO_FLAG_WRITE) >= 0;
+    AVDictionary* muxOpts = nullptr;
+    av_dict_set(&muxOpts, "movflags", "+frag_keyframe+empty_moov+default_base_moof", 0); // ca segment_muxer
+    ok = ok && avformat_write_header(oc, &muxOpts) >= 0;
+    av_dict_free(&muxOpts);
+
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    frame->format = enc->pix_fmt;
+    frame->width = kWidth;
+    frame->height = kHeight;
+    ok = ok && av_frame_get_buffer(frame, 0) >= 0;
+    for (int i = 0; ok && i < frames; ++i) {
+        av_frame_make_writable(frame);
+        fillFrame(frame, first + i, withSquare);
+        frame->pts = i;
+        ok = avcodec_send_frame(enc, frame) >= 0;
+        drainEncoder(enc, oc, st, pkt);
+    }
+    if (ok) {
+        avcodec_send_frame(enc, nullptr);
+        drainEncoder(enc, oc, st, pkt);
+        av_write_trailer(oc);
+    }
+
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&enc);
+    if (oc->pb) avio_closep(&oc->pb);
+    avformat_free_context(oc);
+    return ok;
+}
+
+static const AVCodec* mvEncoder() {
+    const AVCodec* c = avcodec_find_encoder_by_name("libx264");
+    return c ? c : avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+}
+
+static CameraConfig testConfig() {
+    // Ca aiRequest.getDetector in productie
+    CameraConfig cfg;
+    cfg.minAreaRatio = 0.005;
+    cfg.minFrames = 1;
+    cfg.maxStaticVariance = 25.0;
+    return cfg;
+}
+
+static double overlap(const cv::Rect& a, const cv::Rect& truth) {
+    return truth.area() > 0 ? (double)(a & truth).area() / truth.area() : 0.0;
+}
+
+// ---------------------------------------------------------------------------
+// 1. Patrat in miscare, doua segmente consecutive
+// ---------------------------------------------------------------------------
+
+static void testMovingSquare(MvMotionEngine& engine, const std::vector<std::string>& segments) {
+    int frameNo = 0, interFrames = 0, hits = 0, falseFrames = 0;
+    std::vector<int> lastIdInSegment(segments.size(), -1), firstIdInSegment(segments.size(), -1);
+    std::vector<EncodedROI> rois;
+
+    for (size_t seg = 0; seg < segments.size(); ++seg) {
+        if (!engine.open(segments[seg])) {
+            fail("open " + segments[seg]);
+            return;
+        }
+        const uint64_t mv0 = engine.mvFrames();
+        for (;;) {
+            rois.clear();
+            const uint64_t before = engine.mvFrames();
+            if (!engine.processNext(rois)) break;
+            const int n = frameNo++;
+            if (engine.mvFrames() == before) continue; // I-frame, track-uri tinute
+
+            const cv::Rect truth = squareAt(n);
+            bool hit = false, stray = false;
+            for (int slot : engine.validTracks()) {
+                const cv::Rect& bb = engine.tracks().bbox[slot];
+                if (overlap(bb, truth) >= 0.5) {
+                    hit = true;
+                    lastIdInSegment[seg] = (int)engine.tracks().id[slot];
+                    if (firstIdInSegment[seg] < 0) firstIdInSegment[seg] = lastIdInSegment[seg];
+                } else if ((bb & truth).area() == 0) {
+                    stray = true;
+                }
+            }
+            if (hit && rois.empty()) fail("valid track without ROI JPEG at frame " + std::to_string(n));
+            if (n < 3) continue; // primele cadre P: track-ul abia se formeaza
+            interFrames++;
+            if (hit) hits++;
+            if (stray) falseFrames++;
+        }
+        if (engine.mvFrames() == mv0) fail("no frame with motion vectors in " + segments[seg]);
+    }
+
+    // Acelasi obiect peste granita de segment = acelasi id (open() nu reseteaza tracker-ul)
+    for (size_t seg = 1; seg < segments.size(); ++seg) {
+        if (firstIdInSegment[seg] >= 0 && firstIdInSegment[seg] != lastIdInSegment[seg - 1]) {
+            fail("track id changed across segments: " + std::to_string(lastIdInSegment[seg - 1]) + " -> " +
+                 std::to_string(firstIdInSegment[seg]));
+        }
+    }
+
+    const double hitRate = interFrames ? (double)hits / interFrames : 0.0;
+    std::cout << "[MvTest] moving square: " << hits << "/" << interFrames << " inter frames tracked, "
+              << falseFrames << " with stray tracks" << std::endl;
+    if (hitRate < 0.8) fail("moving square tracked in " + std::to_string(hitRate * 100) + "% of inter frames");
+    if (falseFrames > interFrames / 20) fail(std::to_string(falseFrames) + " frames with tracks away from the square");
+}
+
+int main(int argc, char** argv) {
+    std::string segmentsDir;
+    if (const char* env = std::getenv("DSS_MV_TEST_SEGMENTS")) segmentsDir = env;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--segments") segmentsDir = argv[++i];
+    }
+    av_log_set_level(AV_LOG_ERROR);
+
+    const AVCodec* codec = mvEncoder();
+    if (!codec) {
+        std::cout << "[MvTest] SKIP: no libx264 / mpeg4 encoder in this FFmpeg build" << std::endl;
+        return 77;
+    }
+
+    const fs::path dir = fs::temp_directory_path() / ("dss_mv_test_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+    const long long epoch = 1700000000;
+    std::vector<std::string> moving, still;
+    for (int s = 0; s < 2; ++s) {
+        const std::string p = (dir / ("seg_" + std::to_string(epoch + 2 * s) + "_" + std::to_string(s) + ".mp4")).string();
+        if (!writeClip(p, codec, s * kSegmentFrames, kSegmentFrames, true)) {
+            std::cout << "[MvTest] SKIP: encoder " << codec->name << " cannot write " << p << std::endl;
+            fs::remove_all(dir);
+            return 77;
+        }
+        moving.push_back(p);
+    }
+    still.push_back((dir / "still.mp4").string());
+    if (!writeClip(still[0], codec, 0, kSegmentFrames, false)) fail("cannot write the static clip");
+    std::cout << "[MvTest] clips encoded with " << codec->name << std::endl;
+
+    // 1 + continuitatea intre segmente
+    {
+        MvMotionEngine engine;
+        engine.setConfig(testConfig());
+        testMovingSquare(engine, moving);
+    }
+
+    // 2
+    {
+        MvMotionEngine engine;
+        engine.setConfig(testConfig());
+        std::vector<EncodedROI> rois;
+        int detections = 0;
+        if (!engine.open(still[0])) fail("open static clip");
+        while (engine.processNext(rois)) detections += engine.validTracks().empty() ? 0 : 1;
+        if (detections) fail("static clip: " + std::to_string(detections) + " frames with valid tracks");
+        if (!rois.empty()) fail("static clip produced ROI JPEGs");
+
+        // Drumul patratului plus un macrobloc, nealiniat la celula (x, y impare): celulele
+        // atinse doar partial sunt sterse si ele
+        const cv::Rect path = squareAt(0) | squareAt(kSegmentFrames - 1);
+        CameraConfig cfg = testConfig();
+        cfg.excludedZones.push_back({cv::Rect(path.x - 17, path.y - 17, path.width + 34, path.height + 34)});
+        MvMotionEngine excluded;
+        excluded.setConfig(cfg);
+        detections = 0;
+        if (!excluded.open(moving[0])) fail("open moving clip");
+        while (excluded.processNext(rois)) detections += excluded.validTracks().empty() ? 0 : 1;
+        if (detections) fail("excluded zone: " + std::to_string(detections) + " frames with valid tracks");
+    }
+
+    // 3
+    if (const AVCodec* hevc = avcodec_find_encoder_by_name("libx265")) {
+        const std::string p = (dir / "hevc.mp4").string();
+        if (writeClip(p, hevc, 0, 10, true)) {
+            MvMotionEngine engine;
+            if (engine.open(p)) fail("open() accepted HEVC, whose decoder exports no motion vectors");
+        }
+    } else {
+        std::cout << "[MvTest] no libx265, HEVC refusal not exercised" << std::endl;
+    }
+
+    // 4
+    {
+        MvMotionEngine engine;
+        std::vector<EncodedROI> rois;
+        if (engine.processFrame(cv::Mat(kHeight, kWidth, CV_8UC1, cv::Scalar(0)), rois)) {
+            fail("processFrame(cv::Mat) reported success without motion vectors");
+        }
+    }
+
+    // 5
+    if (!segmentsDir.empty()) {
+        std::error_code ec;
+        int tested = 0;
+        for (fs::recursive_directory_iterator it(segmentsDir, ec), end; it != end && !ec; it.increment(ec)) {
+            if (!it->is_regular_file(ec) || it->path().extension() != ".mp4") continue;
+            AvStreamReader probe;
+            if (!probe.open(it->path().string()) || probe.codecId() != AV_CODEC_ID_H264) continue;
+            probe.close();
+
+            MvMotionEngine engine;
+            engine.setConfig(testConfig());
+            engine.setEncodeRois(false);
+            std::vector<EncodedROI> rois;
+            if (!engine.open(it->path().string())) {
+                fail("open recorder segment " + it->path().string());
+                continue;
+            }
+            while (engine.processNext(rois)) {}
+            if (engine.mvFrames() == 0) fail("no motion vectors in recorder segment " + it->path().string());
+            tested++;
+        }
+        std::cout << "[MvTest] " << tested << " recorder segments from " << segmentsDir << std::endl;
+    }
+
+    fs::remove_all(dir);
+    std::cout << "[MvTest] " << (gFailures ? "FAILED, " + std::to_string(gFailures) + " failures" : std::string("OK"))
+              << std::endl;
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+// dss-frame-ring-feed: producator pentru inelul de cadre in memorie partajata (frame_ring.h).
+//
+//   dss-frame-ring-feed --camera <id> <url|fisier>      decodare libav (RTSP restream, .mp4)
+//   dss-frame-ring-feed --camera <id> --synthetic WxH   generator de test (patrat in miscare, GRAY8)
+//     --fps F      rata maxima publicata (implicit 5; 0 = fiecare cadru decodat)
+//     --slots N    sloturi in inel (implicit 4)
+//     --loop       fisierele o iau de la capat la sfarsit
+//
+// Inelul se numeste /dss_ring_<camera>, ca in aiRequest.js (DSS_FRAME_RING=1).
+// Cadrele YUV 4:2:0 sunt publicate ca I420 (Y urmat de U si V), restul formatelor sunt sarite.
+
+#include "../frame_ring.h"
+#include "../av_stream.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::atomic<bool> gStop{false};
+static void onSignal(int) { gStop = true; }
+
+static void usage() {
+    std::cerr << "usage: dss-frame-ring-feed --camera <id> [--fps F] [--slots N] [--loop] <url | file>\n"
+                 "       dss-frame-ring-feed --camera <id> [--fps F] [--slots N] --synthetic WxH" << std::endl;
+}
+
+static void sleepUntil(std::chrono::steady_clock::time_point& next, double fps) {
+    if (fps <= 0.0) return;
+    next += std::chrono::microseconds((int64_t)(1e6 / fps));
+    std::this_thread::sleep_until(next);
+}
+
+static int runSynthetic(const std::string& name, int w, int h, double fps, int slots) {
+    FrameRingWriter ring;
+    if (!ring.create(name, w, h, w, PIXFMT_GRAY8, slots)) return 1;
+
+    auto next = std::chrono::steady_clock::now();
+    const int side = std::max(8, w / 10);
+    for (uint64_t i = 0; !gStop; ++i) {
+        uint8_t* d = ring.beginWrite();
+        std::memset(d, 110, ring.header().frameBytes);
+        const int x = (int)(i * 4 % (uint64_t)std::max(1, w - side));
+        const int y = h / 3;
+        for (int r = y; r < std::min(h, y + side); ++r) std::memset(d + (size_t)r * w + x, 230, side);
+        ring.commit(frameRingNowMs());
+        sleepUntil(next, fps > 0.0 ? fps : 25.0);
+    }
+    ring.close(true);
+    return 0;
+}
+
+static int runDecoder(const std::string& name, const std::string& url, double fps, int slots, bool loop) {
+    FrameRingWriter ring;
+    AvStreamReader reader;
+    std::vector<uint8_t> scratch;
+    int backoffMs = 1000;
+
+    while (!gStop) {
+        if (!reader.open(url)) {
+            std::cerr << "[Ring] Cannot open " << url << ", retry in " << backoffMs << " ms" << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+            backoffMs = std::min(backoffMs * 2, 30000);
+            continue;
+        }
+        backoffMs = 1000;
+
+        const double period = fps > 0.0 ? 1.0 / fps : 0.0;
+        double nextDue = -1.0;
+        int r = 0;
+        while (!gStop) {
+            AVFrame* frame = nullptr;
+            r = reader.next(frame);
+            if (r != 0 || !frame) break;
+
+            double t = reader.frameTimeSec(frame);
+            if (period > 0.0 && t >= 0.0) {
+                if (nextDue >= 0.0 && t < nextDue && nextDue - t < 10.0 * period) continue;
+                nextDue = (nextDue < 0.0 || t - nextDue > period || nextDue - t >= 10.0 * period)
+                              ? t + period : nextDue + period;
+            }
+
+            cv::Mat luma;
+            RawYuvPlanes yuv;
+            if (!wrapAvFrame(frame, luma, yuv)) continue;
+            const int w = luma.cols, h = luma.rows;
+            if (!ring.isOpen() || ring.header().width != w || ring.header().height != h) {
+                if (!ring.create(name, w, h, w, PIXFMT_I420, slots)) return 1;
+            }
+
+            // Planurile decoderului (stride-uri proprii, NV12 sau I420) -> layout-ul I420 al inelului
+            uint8_t* d = ring.beginWrite();
+            for (int y = 0; y < h; ++y) std::memcpy(d + (size_t)y * w, yuv.y + (size_t)y * yuv.strideY, w);
+            uint8_t* u = d + (size_t)w * h;
+            const int cw = (w + 1) / 2, ch = (h + 1) / 2;
+            uint8_t* v = u + (size_t)cw * ch;
+            for (int y = 0; y < ch; ++y) {
+                const uint8_t* su = yuv.u + (size_t)y * yuv.strideUV;
+                if (yuv.nv12) {
+                    for (int x = 0; x < cw; ++x) {
+                        u[(size_t)y * cw + x] = su[2 * x];
+                        v[(size_t)y * cw + x] = su[2 * x + 1];
+                    }
+                } else {
+                    std::memcpy(u + (size_t)y * cw, su, cw);
+                    std::memcpy(v + (size_t)y * cw, yuv.v + (size_t)y * yuv.strideUV, cw);
+                }
+            }
+            ring.commit(frameRingNowMs());
+        }
+        reader.close();
+        if (r == 1 && !loop && url.find("://") == std::string::npos) break;
+    }
+    ring.close(true);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::string camera, url, synthetic;
+    double fps = 5.0;
+    int slots = 4;
+    bool loop = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--loop") { loop = true; continue; }
+        if (a.rfind("--", 0) != 0) { url = a; continue; }
+        if (i + 1 >= argc) { usage(); return 2; }
+        const char* v = argv[++i];
+        if (a == "--camera") camera = v;
+        else if (a == "--fps") fps = std::atof(v);
+        else if (a == "--slots") slots = std::atoi(v);
+        else if (a == "--synthetic") synthetic = v;
+        else { usage(); return 2; }
+    }
+    if (camera.empty() || (url.empty() && synthetic.empty())) {
+        usage();
+        return 2;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    const std::string name = "/dss_ring_" + camera;
+
+    if (!synthetic.empty()) {
+        int w = 0, h = 0;
+        if (std::sscanf(synthetic.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) {
+            usage();
+            return 2;
+        }
+        return runSynthetic(name, w, h, fps, slots);
+    }
+    return runDecoder(name, url, fps, slots, loop);
+}
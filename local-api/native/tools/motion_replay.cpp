@@ -0,0 +1,441 @@
+// dss-motion-replay: ruleaza detectorul offline peste segmentele inregistrate,
+// cat de repede permite CPU-ul, cu aceeasi configuratie ca in productie.
+//
+// Intrari: directorul de stocare al unei camere (<cam>/<data>/seg_<epoch>_<n>.mp4,
+// layout-ul recorderului), un director cu mai multe zile sau o lista de fisiere.
+// Segmentele unei camere sunt continue, deci sunt procesate in ordine cronologica
+// cu acelasi detector (track-urile trec dintr-un segment in altul). Cu --jobs N
+// lista e impartita in N bucati contigue, fiecare cu detectorul ei pe un fir separat
+// (state-ul se rupe doar la granita dintre bucati).
+//
+// Raport: cadre/s per core (timp CPU al firelor), timp per etapa (decode, masca,
+// bloburi, tracker, encode), cadre cu detectii valide si ROI-urile care ar fi
+// plecat spre AI hub (JPEG din planurile YUV la rezolutia sursei, ca stream_ingest).
+//
+//   dss-motion-replay [optiuni] <dir|fisier.mp4>...
+//     --fps F              analizeaza F cadre/s din timpul video (implicit 0 = toate cadrele)
+//     --jobs N             fire de lucru (implicit 1)
+//     --analysis-width W   latimea de analiza (implicit 640, ca ai_server.analysis_width)
+//     --min-area R         minAreaRatio (implicit 0.005, ca aiRequest.getDetector)
+//     --min-frames N       minFrames (implicit 1)
+//     --max-variance V     maxStaticVariance (implicit 25)
+//     --threshold T        diffThreshold (implicit 25)
+//     --learning-rate A    bgLearningRate (implicit 0.01)
+//     --parallel-min-px N  parallelMinPixels: benzi paralele de la N pixeli (implicit 4000000, 0 = oprit;
+//                          reducerea sursei la analiza, masca + bloburile doar la analiza mare)
+//     --tracker greedy|global
+//     --exclude x,y,w,h    zona exclusa in spatiul de analiza, cu --engine mv in pixelii
+//                          stream-ului (repetabil)
+//     --engine auto|cpu|opencl|cuda|mv   etapa de masca (auto = calibrare, ca create_detector;
+//                          mv = vectorii de miscare ai decoderului, MvMotionEngine: fiecare cadru,
+//                          fara --fps / --analysis-width, doar H.264 / MPEG-4 / MPEG-2)
+//     --no-encode          fara encodarea ROI-urilor (doar detectie)
+//     --json               raportul ca un singur obiect JSON pe stdout
+
+#include "../motion_detector.h"
+#include "../engine_calibration.h"
+#include "../engine_factory.h"
+#include "../av_stream.h"
+#include "../roi_crop.h"
+#include "../jpeg_decode.h"
+#include "../jpeg_encode.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct ReplayOptions {
+    double fps = 0.0;
+    int jobs = 1;
+    int analysisWidth = 640;
+    bool autoEngine = false;
+    bool mvEngine = false;         // compressed domain, MvMotionEngine instead of MotionDetector
+    EngineKind engine = EngineKind::Cpu;
+    bool encode = true;
+    bool json = false;
+    CameraConfig cfg;
+};
+
+struct ReplayTotals {
+    uint64_t files = 0;
+    uint64_t failedFiles = 0;
+    uint64_t decodedFrames = 0;
+    uint64_t analysedFrames = 0;
+    uint64_t detectionFrames = 0;   // frames with at least one valid track
+    uint64_t validObjects = 0;
+    uint64_t rois = 0;              // ROI JPEGs that would go to the AI hub
+    uint64_t roiBytes = 0;
+    double videoSec = 0.0;          // footage covered (pts span per file)
+    double cpuSec = 0.0;            // thread CPU time, all workers
+    uint64_t stageUs[STAGE_COUNT] = {};
+    uint64_t stageCount[STAGE_COUNT] = {};
+
+    void merge(const ReplayTotals& o) {
+        files += o.files;
+        failedFiles += o.failedFiles;
+        decodedFrames += o.decodedFrames;
+        analysedFrames += o.analysedFrames;
+        detectionFrames += o.detectionFrames;
+        validObjects += o.validObjects;
+        rois += o.rois;
+        roiBytes += o.roiBytes;
+        videoSec += o.videoSec;
+        cpuSec += o.cpuSec;
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            stageUs[s] += o.stageUs[s];
+            stageCount[s] += o.stageCount[s];
+        }
+    }
+};
+
+static double threadCpuSec() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// --- Intrari -----------------------------------------------------------------------
+
+// seg_<epoch>_<n>.mp4 -> (epoch, n); alte nume sortate dupa ele, alfabetic
+static bool segmentKey(const fs::path& p, long long& epoch, long long& index) {
+    const std::string name = p.filename().string();
+    return std::sscanf(name.c_str(), "seg_%lld_%lld.mp4", &epoch, &index) == 2;
+}
+
+static bool segmentLess(const fs::path& a, const fs::path& b) {
+    // Directorul de zi (YYYY-MM-DD) se sorteaza corect lexicografic
+    if (a.parent_path() != b.parent_path()) return a.parent_path() < b.parent_path();
+    long long ea, ia, eb, ib;
+    const bool sa = segmentKey(a, ea, ia);
+    const bool sb = segmentKey(b, eb, ib);
+    if (sa != sb) return sa;
+    if (sa) return ea != eb ? ea < eb : ia < ib;
+    return a.filename() < b.filename();
+}
+
+static void collectInputs(const std::string& arg, std::vector<std::string>& files) {
+    std::error_code ec;
+    if (!fs::is_directory(arg, ec)) {
+        files.push_back(arg);
+        return;
+    }
+    std::vector<fs::path> found;
+    for (fs::recursive_directory_iterator it(arg, ec), end; it != end && !ec; it.increment(ec)) {
+        if (it->is_regular_file(ec) && it->path().extension() == ".mp4") found.push_back(it->path());
+    }
+    std::sort(found.begin(), found.end(), segmentLess);
+    for (const fs::path& p : found) files.push_back(p.string());
+}
+
+// --- Replay ------------------------------------------------------------------------
+
+class ReplayWorker {
+public:
+    ReplayWorker(const ReplayOptions& o, cv::Size analysis)
+        : opt(o), detector(o.cfg, analysis, o.engine) {
+        if (o.analysisWidth <= 0) detector.setAnalysisSize(cv::Size()); // no reduction
+        if (o.mvEngine) {
+            mv = createMotionVectorEngine();
+            if (mv) {
+                mv->setConfig(o.cfg);
+                mv->setEncodeRois(o.encode);
+            }
+        }
+    }
+
+    void run(const std::vector<std::string>& files, size_t begin, size_t end) {
+        const double cpu0 = threadCpuSec();
+        for (size_t i = begin; i < end; ++i) replayFile(files[i]);
+        totals.cpuSec = threadCpuSec() - cpu0;
+
+        DetectorStats& st = detector.stats();
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            const int base = STAT_STAGE_BASE + s * kStatsPerStage;
+            totals.stageCount[s] = st.get(base);
+            totals.stageUs[s] = st.get(base + 1);
+        }
+    }
+
+    const ReplayTotals& result() const { return totals; }
+
+private:
+    void replayFile(const std::string& path) {
+        if (opt.mvEngine) {
+            replayFileMv(path);
+            return;
+        }
+        AvStreamReader reader;
+        AvStreamOptions avOpt;
+        avOpt.decoderThreads = 1; // cadrele/s raportate sunt per core
+        if (!reader.open(path, avOpt)) {
+            std::cerr << "[Replay] Cannot open " << path << std::endl;
+            totals.failedFiles++;
+            return;
+        }
+        totals.files++;
+
+        const double period = opt.fps > 0.0 ? 1.0 / opt.fps : 0.0;
+        double nextDue = -1.0, firstPts = -1.0, lastPts = -1.0;
+        uint64_t fileFrames = 0;
+
+        for (;;) {
+            AVFrame* frame = nullptr;
+            const uint64_t t0 = motionNowUs();
+            const int r = reader.next(frame);
+            if (r != 0 || !frame) {
+                if (r < 0) std::cerr << "[Replay] Decode error " << r << " in " << path << std::endl;
+                break;
+            }
+            detector.stats().addStage(STAGE_DECODE, motionNowUs() - t0);
+            totals.decodedFrames++;
+            fileFrames++;
+
+            // Esantionare dupa timpul video; fara pts, dupa rata nominala
+            double t = reader.frameTimeSec(frame);
+            if (t < 0.0) t = reader.frameRate() > 0.0 ? (fileFrames - 1) / reader.frameRate() : 0.0;
+            if (firstPts < 0.0) firstPts = t;
+            lastPts = std::max(lastPts, t);
+            if (period > 0.0) {
+                if (nextDue >= 0.0 && t < nextDue) continue;
+                nextDue = (nextDue < 0.0 || t - nextDue > period) ? t + period : nextDue + period;
+            }
+            analyse(frame);
+        }
+        if (lastPts > firstPts) {
+            const double frameSec = reader.frameRate() > 0.0 ? 1.0 / reader.frameRate() : 0.0;
+            totals.videoSec += lastPts - firstPts + frameSec;
+        }
+    }
+
+    // Motorul pe vectori decodeaza singur si vede fiecare cadru (vectorii sunt relativi
+    // la cadrul anterior, esantionarea --fps nu se aplica). Etapele nu sunt separate:
+    // decodarea + masca + tracker-ul sunt raportate ca "mask".
+    void replayFileMv(const std::string& path) {
+        if (!mv || !mv->open(path)) {
+            std::cerr << "[Replay] Cannot open " << path << " with the motion vector engine" << std::endl;
+            totals.failedFiles++;
+            return;
+        }
+        totals.files++;
+
+        double firstPts = -1.0, lastPts = -1.0;
+        uint64_t fileFrames = 0;
+        std::vector<EncodedROI> rois;
+        for (;;) {
+            rois.clear();
+            const uint64_t t0 = motionNowUs();
+            if (!mv->processNext(rois)) break;
+            detector.stats().addStage(STAGE_MASK, motionNowUs() - t0);
+            totals.decodedFrames++;
+            totals.analysedFrames++;
+            fileFrames++;
+
+            double t = mv->frameTimeSec();
+            if (t < 0.0) t = mv->frameRate() > 0.0 ? (fileFrames - 1) / mv->frameRate() : 0.0;
+            if (firstPts < 0.0) firstPts = t;
+            lastPts = std::max(lastPts, t);
+
+            const std::vector<int>& valid = mv->validTracks();
+            if (valid.empty()) continue;
+            totals.detectionFrames++;
+            totals.validObjects += valid.size();
+            for (const EncodedROI& r : rois) {
+                totals.rois++;
+                totals.roiBytes += r.jpeg.size();
+            }
+        }
+        if (lastPts > firstPts) {
+            const double frameSec = mv->frameRate() > 0.0 ? 1.0 / mv->frameRate() : 0.0;
+            totals.videoSec += lastPts - firstPts + frameSec;
+        }
+    }
+
+    void analyse(const AVFrame* frame) {
+        cv::Mat luma;
+        RawYuvPlanes yuv;
+        if (!wrapAvFrame(frame, luma, yuv)) {
+            detector.stats().add(STAT_SKIPPED_FRAMES, 1);
+            return;
+        }
+        totals.analysedFrames++;
+
+        const std::vector<int>& valid = detector.processFrame(luma);
+        if (valid.empty()) return;
+        totals.detectionFrames++;
+        totals.validObjects += valid.size();
+        if (!opt.encode) return;
+
+        // Acelasi drum ca stream_ingest: bbox scalat la sursa, crop netezit, JPEG din YUV
+        const uint64_t t0 = motionNowUs();
+        const double scale = detector.sourceScale();
+        TrackTable& tt = detector.tracks();
+        for (int slot : valid) {
+            cv::Rect crop;
+            cv::Mat roi = cropROI(luma, scaleRect(tt.bbox[slot], scale), opt.cfg.roiPadding, tt.smoothRoi[slot], &crop);
+            if (roi.empty() || !encodeJPEGYuv420(yuv, crop, jpeg, 85)) continue;
+            totals.rois++;
+            totals.roiBytes += jpeg.size();
+        }
+        detector.stats().addStage(STAGE_ENCODE, motionNowUs() - t0);
+    }
+
+    const ReplayOptions& opt;
+    MotionDetector detector;           // pixel engine; with --engine mv only its stage stats
+    std::unique_ptr<MvMotionEngine> mv;
+    std::vector<uchar> jpeg;
+    ReplayTotals totals;
+};
+
+// --- Raport ------------------------------------------------------------------------
+
+static const char* kStageNames[STAGE_COUNT] = {"decode", "mask", "blob", "track", "encode"};
+
+static const char* engineLabel(const ReplayOptions& opt) {
+    return opt.mvEngine ? "mv" : engineKindName(opt.engine);
+}
+
+static void printReport(const ReplayTotals& t, double wallSec, const ReplayOptions& opt) {
+    const double perCore = t.cpuSec > 0.0 ? t.analysedFrames / t.cpuSec : 0.0;
+    const double decodedPerCore = t.cpuSec > 0.0 ? t.decodedFrames / t.cpuSec : 0.0;
+    const double realtime = wallSec > 0.0 ? t.videoSec / wallSec : 0.0;
+
+    if (opt.json) {
+        std::ostringstream o;
+        o.setf(std::ios::fixed);
+        o.precision(3);
+        o << "{\"files\":" << t.files << ",\"failed_files\":" << t.failedFiles
+          << ",\"jobs\":" << opt.jobs << ",\"engine\":\"" << engineLabel(opt) << "\""
+          << ",\"decoded_frames\":" << t.decodedFrames << ",\"analysed_frames\":" << t.analysedFrames
+          << ",\"video_sec\":" << t.videoSec << ",\"wall_sec\":" << wallSec << ",\"cpu_sec\":" << t.cpuSec
+          << ",\"analysed_fps_per_core\":" << perCore << ",\"decoded_fps_per_core\":" << decodedPerCore
+          << ",\"realtime_factor\":" << realtime
+          << ",\"detection_frames\":" << t.detectionFrames << ",\"valid_objects\":" << t.validObjects
+          << ",\"rois\":" << t.rois << ",\"roi_bytes\":" << t.roiBytes << ",\"stages\":{";
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            const double avg = t.stageCount[s] ? (double)t.stageUs[s] / t.stageCount[s] : 0.0;
+            o << (s ? "," : "") << "\"" << kStageNames[s] << "\":{\"count\":" << t.stageCount[s]
+              << ",\"total_us\":" << t.stageUs[s] << ",\"avg_us\":" << avg << "}";
+        }
+        o << "}}";
+        std::cout << o.str() << std::endl;
+        return;
+    }
+
+    std::cout << "[Replay] " << t.files << " files (" << t.failedFiles << " failed), "
+              << (long)t.videoSec << " s of video in " << wallSec << " s wall, "
+              << opt.jobs << " job(s), mask on " << engineLabel(opt) << "\n"
+              << "[Replay] decoded " << t.decodedFrames << " frames, analysed " << t.analysedFrames
+              << " -> " << (long)perCore << " analysed fps/core (" << (long)decodedPerCore
+              << " decoded fps/core), " << realtime << "x realtime\n"
+              << "[Replay] " << t.detectionFrames << " frames with detections, " << t.validObjects
+              << " valid objects, " << t.rois << " ROIs to the AI hub (" << t.roiBytes / 1024 << " KiB)\n";
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        if (!t.stageCount[s]) continue;
+        std::cout << "[Replay]   " << kStageNames[s] << ": " << t.stageUs[s] / t.stageCount[s] << " us avg, "
+                  << t.stageUs[s] / 1000 << " ms total\n";
+    }
+    std::cout.flush();
+}
+
+// --- main --------------------------------------------------------------------------
+
+static void usage() {
+    std::cerr << "usage: dss-motion-replay [--fps F] [--jobs N] [--analysis-width W] [--min-area R]\n"
+                 "                         [--min-frames N] [--max-variance V] [--threshold T]\n"
+                 "                         [--learning-rate A] [--parallel-min-px N] [--tracker greedy|global]\n"
+                 "                         [--exclude x,y,w,h]...\n"
+                 "                         [--engine auto|cpu|opencl|cuda|mv] [--no-encode] [--json]\n"
+                 "                         <camera dir | segment.mp4>..." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    ReplayOptions opt;
+    // Valorile cu care aiRequest.getDetector creeaza detectorul in productie
+    opt.cfg.minAreaRatio = 0.005;
+    opt.cfg.minFrames = 1;
+    opt.cfg.maxStaticVariance = 25.0;
+
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--no-encode") { opt.encode = false; continue; }
+        if (a == "--json") { opt.json = true; continue; }
+        if (a == "-h" || a == "--help") { usage(); return 0; }
+        if (a.rfind("--", 0) != 0) { collectInputs(a, files); continue; }
+
+        if (i + 1 >= argc) { usage(); return 2; }
+        const char* v = argv[++i];
+        if (a == "--fps") opt.fps = std::atof(v);
+        else if (a == "--jobs") opt.jobs = std::max(1, std::atoi(v));
+        else if (a == "--analysis-width") opt.analysisWidth = std::atoi(v);
+        else if (a == "--min-area") opt.cfg.minAreaRatio = std::atof(v);
+        else if (a == "--min-frames") opt.cfg.minFrames = std::atoi(v);
+        else if (a == "--max-variance") opt.cfg.maxStaticVariance = std::atof(v);
+        else if (a == "--threshold") opt.cfg.diffThreshold = std::atoi(v);
+        else if (a == "--learning-rate") opt.cfg.bgLearningRate = std::atof(v);
+        else if (a == "--parallel-min-px") opt.cfg.parallelMinPixels = std::max(0, std::atoi(v));
+        else if (a == "--tracker") opt.cfg.trackerMode = std::string(v) == "greedy" ? TrackerMode::Greedy : TrackerMode::Global;
+        else if (a == "--exclude") {
+            ExcludedZone z;
+            if (std::sscanf(v, "%d,%d,%d,%d", &z.zone.x, &z.zone.y, &z.zone.width, &z.zone.height) != 4) {
+                usage();
+                return 2;
+            }
+            opt.cfg.excludedZones.push_back(z);
+        }
+        else if (a == "--engine") {
+            const std::string e = v;
+            if (e == "auto") opt.autoEngine = true;
+            else if (e == "cpu") opt.engine = EngineKind::Cpu;
+            else if (e == "opencl") opt.engine = EngineKind::OpenCL;
+            else if (e == "cuda") opt.engine = EngineKind::Cuda;
+            else if (e == "mv") opt.mvEngine = true;
+            else { usage(); return 2; }
+        }
+        else { usage(); return 2; }
+    }
+    if (files.empty()) {
+        usage();
+        return 2;
+    }
+
+    // Un fir OpenCV per job: paralelismul e intre fisiere, cifrele raman per core
+    cv::setNumThreads(1);
+
+    // Latimea decide; inaltimea urmeaza aspectul cadrelor (toAnalysis)
+    const int aw = opt.analysisWidth > 0 ? opt.analysisWidth : 640;
+    const cv::Size analysis(aw, aw * 9 / 16);
+    if (opt.mvEngine && opt.fps > 0.0) {
+        std::cerr << "[Replay] --fps is ignored with --engine mv (every frame is analysed)" << std::endl;
+        opt.fps = 0.0;
+    }
+    if (opt.autoEngine && !opt.mvEngine) opt.engine = calibratedEngine(analysis).kind;
+
+    opt.jobs = (int)std::min<size_t>(opt.jobs, files.size());
+    std::vector<std::unique_ptr<ReplayWorker>> workers;
+    std::vector<std::thread> threads;
+    const auto wall0 = std::chrono::steady_clock::now();
+    for (int j = 0; j < opt.jobs; ++j) {
+        const size_t begin = files.size() * j / opt.jobs;
+        const size_t end = files.size() * (j + 1) / opt.jobs;
+        workers.push_back(std::make_unique<ReplayWorker>(opt, analysis));
+        threads.emplace_back(&ReplayWorker::run, workers.back().get(), std::cref(files), begin, end);
+    }
+    for (std::thread& t : threads) t.join();
+    const double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+
+    ReplayTotals total;
+    for (const auto& w : workers) total.merge(w->result());
+    printReport(total, wallSec, opt);
+    return total.files > 0 ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+constexpr int kTrackHistory = 30;   // centroizi pastrati per track
+constexpr int kMaxTracks    = 256;  // capacitate fixa, rezervata la constructie
+
+// Istoric de centroizi cu capacitate fixa (inline, fara heap) si
+// medie/varianta Welford pe fereastra glisanta, actualizate in O(1).
+struct CentroidRing {
+    cv::Point2f pts[kTrackHistory];
+    int head = 0;   // next write position
+    int count = 0;
+    double meanX = 0, meanY = 0;
+    double m2X = 0, m2Y = 0;
+
+    void clear() {
+        head = count = 0;
+        meanX = meanY = m2X = m2Y = 0;
+    }
+
+    const cv::Point2f& back() const {
+        return pts[(head + kTrackHistory - 1) % kTrackHistory];
+    }
+
+    void push(const cv::Point2f& p) {
+        if (count == kTrackHistory) {
+            // Drop the oldest sample from the running stats first
+            const cv::Point2f& old = pts[head];
+            const double n = count;
+            double nMeanX = (n * meanX - old.x) / (n - 1);
+            double nMeanY = (n * meanY - old.y) / (n - 1);
+            m2X -= (old.x - meanX) * (old.x - nMeanX);
+            m2Y -= (old.y - meanY) * (old.y - nMeanY);
+            meanX = nMeanX;
+            meanY = nMeanY;
+            --count;
+        }
+        pts[head] = p;
+        head = (head + 1) % kTrackHistory;
+        ++count;
+
+        double dX = p.x - meanX;
+        double dY = p.y - meanY;
+        meanX += dX / count;
+        meanY += dY / count;
+        m2X += dX * (p.x - meanX);
+        m2Y += dY * (p.y - meanY);
+        m2X = std::max(0.0, m2X);
+        m2Y = std::max(0.0, m2Y);
+    }
+
+    // Mean squared distance from the centroid of the window
+    double variance() const {
+        return count > 0 ? (m2X + m2Y) / count : 0.0;
+    }
+};
+
+// Tabela de track-uri in format structure-of-arrays.
+// Sloturile sunt indici in coloane; raman stabile pana la urmatorul compact().
+// Nicio alocare dupa constructie: coloanele sunt rezervate la kMaxTracks.
+class TrackTable {
+public:
+    TrackTable() {
+        id.reserve(kMaxTracks);
+        bbox.reserve(kMaxTracks);
+        framesAlive.reserve(kMaxTracks);
+        missedFrames.reserve(kMaxTracks);
+        isStatic.reserve(kMaxTracks);
+        valid.reserve(kMaxTracks);
+        smoothRoi.reserve(kMaxTracks);
+        velocity.reserve(kMaxTracks);
+        history.reserve(kMaxTracks);
+        keep.reserve(kMaxTracks);
+    }
+
+    int size() const { return (int)id.size(); }
+    bool full() const { return size() >= kMaxTracks; }
+
+    // Id the next add() hands out (saved / restored with the detector state)
+    uint32_t nextTrackId() const { return nextId; }
+    void setNextTrackId(uint32_t n) { nextId = n ? n : 1; }
+
+    // Returns the new slot, or -1 when the table is full
+    int add(const cv::Rect& box, const cv::Point2f& c) {
+        if (full()) return -1;
+        id.push_back(nextId++);
+        if (nextId == 0) nextId = 1; // 0 = "no track"
+        bbox.push_back(box);
+        framesAlive.push_back(1);
+        missedFrames.push_back(0);
+        isStatic.push_back(0);
+        valid.push_back(0);
+        smoothRoi.push_back(cv::Rect());
+        velocity.push_back(cv::Point2f(0.f, 0.f));
+        history.emplace_back();
+        history.back().push(c);
+        keep.push_back(1);
+        return size() - 1;
+    }
+
+    // Constant-velocity prediction, `missedFrames` frames after the last observation
+    cv::Point2f predict(int slot) const {
+        float k = (float)(missedFrames[slot] + 1);
+        const cv::Point2f& last = history[slot].back();
+        return cv::Point2f(last.x + velocity[slot].x * k, last.y + velocity[slot].y * k);
+    }
+
+    void update(int slot, const cv::Rect& box, const cv::Point2f& c) {
+        // Velocity: EMA of the displacement per frame (alpha-beta style)
+        const cv::Point2f& last = history[slot].back();
+        float dt = (float)(missedFrames[slot] + 1);
+        cv::Point2f v((c.x - last.x) / dt, (c.y - last.y) / dt);
+        if (framesAlive[slot] > 1) {
+            v.x = 0.5f * v.x + 0.5f * velocity[slot].x;
+            v.y = 0.5f * v.y + 0.5f * velocity[slot].y;
+        }
+        velocity[slot] = v;
+
+        bbox[slot] = box;
+        framesAlive[slot]++;
+        missedFrames[slot] = 0;
+        history[slot].push(c);
+    }
+
+    void clear() {
+        id.clear(); bbox.clear(); framesAlive.clear(); missedFrames.clear();
+        isStatic.clear(); valid.clear(); smoothRoi.clear(); velocity.clear(); history.clear(); keep.clear();
+    }
+
+    // Removes every slot with keep[slot] == 0, preserving order
+    void compact() {
+        int w = 0;
+        for (int r = 0; r < size(); ++r) {
+            if (!keep[r]) continue;
+            if (w != r) {
+                id[w] = id[r];
+                bbox[w] = bbox[r];
+                framesAlive[w] = framesAlive[r];
+                missedFrames[w] = missedFrames[r];
+                isStatic[w] = isStatic[r];
+                valid[w] = valid[r];
+                smoothRoi[w] = smoothRoi[r];
+                velocity[w] = velocity[r];
+                history[w] = history[r];
+            }
+            keep[w] = 1;
+            ++w;
+        }
+        resize(w);
+    }
+
+    // Columns
+    std::vector<uint32_t> id;          // stable integer track id
+    std::vector<cv::Rect> bbox;
+    std::vector<int> framesAlive;
+    std::vector<int> missedFrames;
+    std::vector<uint8_t> isStatic;     // static-dynamic (flag pe ultimul cadru)
+    std::vector<uint8_t> valid;        // passed all filters on the last frame
+    std::vector<cv::Rect> smoothRoi;   // EMA state for ROI stabilization (crop frame coordinates)
+    std::vector<cv::Point2f> velocity; // px / frame
+    std::vector<CentroidRing> history;
+    std::vector<uint8_t> keep;         // scratch for compact()
+
+private:
+    void resize(int n) {
+        id.resize(n); bbox.resize(n); framesAlive.resize(n); missedFrames.resize(n);
+        isStatic.resize(n); valid.resize(n); smoothRoi.resize(n); velocity.resize(n); history.resize(n); keep.resize(n);
+    }
+
+    uint32_t nextId = 1;
+};
@@ -0,0 +1,329 @@
+#include "tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+// Cost for pairs outside the gate: keeps the Hungarian matrix feasible,
+// any assignment at this cost is rejected afterwards
+constexpr double kGatedOut = 1e6;
+// Above this many cells a component is solved greedily on sorted edges
+// (a dense crowd in one cell must not blow the frame budget)
+constexpr int kMaxHungarianCells = 96 * 96;
+}
+
+MotionTracker::MotionTracker() {
+    validSlots.reserve(kMaxTracks);
+    trackMatch.reserve(kMaxTracks);
+}
+
+void MotionTracker::reset() {
+    table.clear();
+    validSlots.clear();
+}
+
+bool MotionTracker::passesSizeFilter(const MotionBlob& blob, cv::Size frameSize, const CameraConfig& cfg) const {
+    double frameArea = (double)frameSize.width * frameSize.height;
+    return (blob.area / frameArea) >= cfg.minAreaRatio;
+}
+
+bool MotionTracker::passesPersistence(int slot, const CameraConfig& cfg) const {
+    return table.framesAlive[slot] >= cfg.minFrames;
+}
+
+bool MotionTracker::isStaticDynamic(int slot, const CameraConfig& cfg) {
+    const CentroidRing& h = table.history[slot];
+    if (h.count < 4) return false; // Need history
+
+    // Variance over the history window, maintained incrementally (Welford)
+    double var = h.variance();
+
+    // User Rule: If variance Low AND exists for long time -> Static Dynamic
+    bool isStatic = var < cfg.maxStaticVariance && table.framesAlive[slot] > cfg.minFrames;
+    table.isStatic[slot] = isStatic ? 1 : 0;
+    return isStatic;
+}
+
+const std::vector<int>& MotionTracker::hold() {
+    validSlots.clear();
+    std::fill(table.valid.begin(), table.valid.end(), 0);
+    return validSlots;
+}
+
+const std::vector<int>& MotionTracker::update(std::vector<MotionBlob>& blobs, cv::Size frameSize,
+                                              const CameraConfig& cfg) {
+    validSlots.clear();
+    std::fill(table.valid.begin(), table.valid.end(), 0);
+
+    const bool global = cfg.trackerMode == TrackerMode::Global;
+
+    // Cap the blob count (largest first) so association cost stays bounded
+    if (global && cfg.maxBlobs > 0 && (int)blobs.size() > cfg.maxBlobs) {
+        std::nth_element(blobs.begin(), blobs.begin() + cfg.maxBlobs, blobs.end(),
+                         [](const MotionBlob& a, const MotionBlob& b) { return a.area > b.area; });
+        blobs.resize(cfg.maxBlobs);
+    }
+
+    // Radius proportional to resolution (e.g. 50px at 640w => ~8%)
+    double gate = (double)frameSize.width * 0.08;
+    if (gate < 20.0) gate = 20.0; // Minimum floor
+
+    trackMatch.assign(table.size(), -1);
+    blobUsed.assign(blobs.size(), 0);
+    if (global) associateGlobal(blobs, gate, frameSize);
+    else associateGreedy(blobs, gate);
+
+    for (int slot = 0; slot < table.size(); ++slot) {
+        int m = trackMatch[slot];
+        if (m >= 0) {
+            const MotionBlob& b = blobs[m];
+            table.update(slot, b.bbox, b.centroid);
+            table.keep[slot] = 1;
+
+            if (passesSizeFilter(b, frameSize, cfg) && passesPersistence(slot, cfg) && !isStaticDynamic(slot, cfg)) {
+                table.valid[slot] = 1;
+            }
+        } else if (global) {
+            // Coasting: keep the track (predicted, not reported) for a few frames
+            table.missedFrames[slot]++;
+            table.keep[slot] = table.missedFrames[slot] <= cfg.maxCoastFrames ? 1 : 0;
+        } else {
+            table.keep[slot] = 0;
+        }
+    }
+    table.compact();
+
+    // Create new tracks for unmatched blobs
+    for (int i = 0; i < (int)blobs.size(); ++i) {
+        if (blobUsed[i]) continue;
+        if (!passesSizeFilter(blobs[i], frameSize, cfg)) continue;
+        if (table.add(blobs[i].bbox, blobs[i].centroid) < 0) break; // table full
+    }
+
+    for (int slot = 0; slot < table.size(); ++slot) {
+        if (table.valid[slot]) validSlots.push_back(slot);
+    }
+    return validSlots;
+}
+
+void MotionTracker::associateGreedy(const std::vector<MotionBlob>& blobs, double maxDist) {
+    // Istoric: fiecare track ia cel mai apropiat blob liber, in ordinea sloturilor
+    for (int slot = 0; slot < table.size(); ++slot) {
+        int best = -1;
+        double minDst = 100000.0;
+        const cv::Point2f last = table.history[slot].back();
+
+        for (int i = 0; i < (int)blobs.size(); ++i) {
+            if (blobUsed[i]) continue;
+            double dist = cv::norm(last - blobs[i].centroid);
+            if (dist < maxDist && dist < minDst) {
+                minDst = dist;
+                best = i;
+            }
+        }
+        if (best != -1) {
+            trackMatch[slot] = best;
+            blobUsed[best] = 1;
+        }
+    }
+}
+
+int MotionTracker::ufFind(int x) {
+    while (uf[x] != x) {
+        uf[x] = uf[uf[x]];
+        x = uf[x];
+    }
+    return x;
+}
+
+void MotionTracker::associateGlobal(const std::vector<MotionBlob>& blobs, double gate, cv::Size frameSize) {
+    const int nT = table.size();
+    const int nB = (int)blobs.size();
+    if (nT == 0 || nB == 0) return;
+
+    // 1. Grid spatial peste centroizii blob-urilor (counting sort pe celule de marimea portii)
+    const double cell = gate;
+    const int gw = std::max(1, (int)std::ceil(frameSize.width / cell));
+    const int gh = std::max(1, (int)std::ceil(frameSize.height / cell));
+    auto cellOf = [&](const cv::Point2f& p, int& cx, int& cy) {
+        cx = std::min(gw - 1, std::max(0, (int)(p.x / cell)));
+        cy = std::min(gh - 1, std::max(0, (int)(p.y / cell)));
+    };
+
+    cellStart.assign(gw * gh + 1, 0);
+    for (int i = 0; i < nB; ++i) {
+        int cx, cy;
+        cellOf(blobs[i].centroid, cx, cy);
+        cellStart[cy * gw + cx + 1]++;
+    }
+    for (int c = 0; c < gw * gh; ++c) cellStart[c + 1] += cellStart[c];
+    cellItems.resize(nB);
+    // Fill using the start offsets, then shift them back
+    for (int i = 0; i < nB; ++i) {
+        int cx, cy;
+        cellOf(blobs[i].centroid, cx, cy);
+        cellItems[cellStart[cy * gw + cx]++] = i;
+    }
+    for (int c = gw * gh; c > 0; --c) cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+
+    // 2. Candidate pairs: blobs within the (miss-widened) gate of the predicted position
+    edges.clear();
+    for (int t = 0; t < nT; ++t) {
+        const cv::Point2f p = table.predict(t);
+        const double g = gate * (1.0 + 0.5 * table.missedFrames[t]);
+        const int r = (int)std::ceil(g / cell);
+        int cx, cy;
+        cellOf(p, cx, cy);
+        for (int y = std::max(0, cy - r); y <= std::min(gh - 1, cy + r); ++y) {
+            for (int x = std::max(0, cx - r); x <= std::min(gw - 1, cx + r); ++x) {
+                const int c = y * gw + x;
+                for (int k = cellStart[c]; k < cellStart[c + 1]; ++k) {
+                    const int b = cellItems[k];
+                    const double d = cv::norm(p - blobs[b].centroid);
+                    if (d < g) edges.push_back({t, b, (float)d, 0});
+                }
+            }
+        }
+    }
+    if (edges.empty()) return;
+
+    // 3. Independent subproblems: connected components of the candidate graph
+    //    (nodes 0..nT-1 = tracks, nT..nT+nB-1 = blobs)
+    uf.resize(nT + nB);
+    std::iota(uf.begin(), uf.end(), 0);
+    for (const Edge& e : edges) {
+        int a = ufFind(e.track);
+        int b = ufFind(nT + e.blob);
+        if (a != b) uf[std::max(a, b)] = std::min(a, b);
+    }
+    for (Edge& e : edges) e.comp = ufFind(e.track);
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+        return a.comp != b.comp ? a.comp < b.comp : a.dist < b.dist;
+    });
+
+    localTrack.assign(nT, -1);
+    localBlob.assign(nB, -1);
+    size_t begin = 0;
+    while (begin < edges.size()) {
+        size_t end = begin + 1;
+        while (end < edges.size() && edges[end].comp == edges[begin].comp) ++end;
+        solveComponent(&edges[begin], (int)(end - begin));
+        begin = end;
+    }
+}
+
+void MotionTracker::solveComponent(const Edge* es, int edgeCount) {
+    // Local indices for the tracks / blobs of this component
+    compTracks.clear();
+    compBlobs.clear();
+    for (int i = 0; i < edgeCount; ++i) {
+        const Edge& e = es[i];
+        if (localTrack[e.track] < 0) {
+            localTrack[e.track] = (int)compTracks.size();
+            compTracks.push_back(e.track);
+        }
+        if (localBlob[e.blob] < 0) {
+            localBlob[e.blob] = (int)compBlobs.size();
+            compBlobs.push_back(e.blob);
+        }
+    }
+
+    const int rows = (int)compTracks.size();
+    const int cols = (int)compBlobs.size();
+    solveAssignment(es, edgeCount, rows, cols);
+
+    for (int t : compTracks) localTrack[t] = -1;
+    for (int b : compBlobs) localBlob[b] = -1;
+}
+
+void MotionTracker::solveAssignment(const Edge* es, int edgeCount, int rows, int cols) {
+    // Trivial / oversized components: edges are sorted by distance -> greedy is exact
+    // for 1x1 and a bounded fallback for dense clusters
+    if (edgeCount == 1 || rows * cols > kMaxHungarianCells) {
+        for (int i = 0; i < edgeCount; ++i) {
+            const Edge& e = es[i];
+            if (trackMatch[e.track] >= 0 || blobUsed[e.blob]) continue;
+            trackMatch[e.track] = e.blob;
+            blobUsed[e.blob] = 1;
+        }
+        return;
+    }
+
+    // Hungarian needs n <= m: transpose when there are more tracks than blobs
+    const bool transpose = rows > cols;
+    const int n = transpose ? cols : rows;
+    const int m = transpose ? rows : cols;
+    cost.assign((size_t)n * m, kGatedOut);
+    for (int i = 0; i < edgeCount; ++i) {
+        int r = localTrack[es[i].track];
+        int c = localBlob[es[i].blob];
+        if (transpose) std::swap(r, c);
+        cost[(size_t)r * m + c] = es[i].dist;
+    }
+
+    hungarian(n, m);
+
+    for (int r = 0; r < n; ++r) {
+        const int c = rowToCol[r];
+        if (c < 0 || cost[(size_t)r * m + c] >= kGatedOut) continue;
+        const int t = compTracks[transpose ? c : r];
+        const int b = compBlobs[transpose ? r : c];
+        trackMatch[t] = b;
+        blobUsed[b] = 1;
+    }
+}
+
+void MotionTracker::hungarian(int n, int m) {
+    // Kuhn-Munkres cu potentiale, O(n^2 m); indici 1-based, coloana 0 = santinela
+    const double inf = std::numeric_limits<double>::max();
+    potU.assign(n + 1, 0.0);
+    potV.assign(m + 1, 0.0);
+    colOwner.assign(m + 1, 0);
+    way.assign(m + 1, 0);
+
+    for (int i = 1; i <= n; ++i) {
+        colOwner[0] = i;
+        int j0 = 0;
+        minv.assign(m + 1, inf);
+        colUsed.assign(m + 1, 0);
+        do {
+            colUsed[j0] = 1;
+            const int i0 = colOwner[j0];
+            double delta = inf;
+            int j1 = 0;
+            for (int j = 1; j <= m; ++j) {
+                if (colUsed[j]) continue;
+                double cur = cost[(size_t)(i0 - 1) * m + (j - 1)] - potU[i0] - potV[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (colUsed[j]) {
+                    potU[colOwner[j]] += delta;
+                    potV[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (colOwner[j0] != 0);
+        do {
+            const int j1 = way[j0];
+            colOwner[j0] = colOwner[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    rowToCol.assign(n, -1);
+    for (int j = 1; j <= m; ++j) {
+        if (colOwner[j] > 0) rowToCol[colOwner[j] - 1] = j - 1;
+    }
+}
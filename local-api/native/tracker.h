@@ -0,0 +1,64 @@
+#pragma once
+#include "motion_types.h"
+#include "camera_config.h"
+#include "track_table.h"
+#include <vector>
+
+// Asocierea blob -> track si filtrele (arie, persistenta, static-dinamic).
+// Doua moduri (CameraConfig::trackerMode):
+//  - Greedy: comportamentul istoric, cel mai apropiat centroid, track pierdut la primul miss
+//  - Global: predictie cu viteza constanta, asignare globala (Hungarian) cu poarta de distanta,
+//    perechile candidate sunt gasite printr-un grid spatial, iar track-urile fara blob
+//    "coasteaza" maxCoastFrames cadre (ocluzie dupa un stalp etc.)
+class MotionTracker {
+public:
+    MotionTracker();
+
+    // Associates one frame of blobs and returns the slots of the valid tracks.
+    // `blobs` may be reordered / truncated to cfg.maxBlobs (largest first).
+    const std::vector<int>& update(std::vector<MotionBlob>& blobs, cv::Size frameSize, const CameraConfig& cfg);
+
+    // Frame skipped by the caller: nothing reported, tracks left untouched
+    const std::vector<int>& hold();
+
+    TrackTable& tracks() { return table; }
+    const TrackTable& tracks() const { return table; }
+    const std::vector<int>& validTracks() const { return validSlots; }
+
+    void reset();
+
+private:
+    struct Edge {
+        int track;
+        int blob;
+        float dist;
+        int comp;   // root of the candidate-graph component
+    };
+
+    void associateGreedy(const std::vector<MotionBlob>& blobs, double maxDist);
+    void associateGlobal(const std::vector<MotionBlob>& blobs, double gate, cv::Size frameSize);
+    void solveComponent(const Edge* edges, int edgeCount);
+    void solveAssignment(const Edge* edges, int edgeCount, int rows, int cols);
+    void hungarian(int n, int m); // cost[n x m], n <= m -> rowToCol
+
+    int ufFind(int x);
+
+    bool passesSizeFilter(const MotionBlob& blob, cv::Size frameSize, const CameraConfig& cfg) const;
+    bool passesPersistence(int slot, const CameraConfig& cfg) const;
+    bool isStaticDynamic(int slot, const CameraConfig& cfg);
+
+    TrackTable table;
+    std::vector<int> validSlots;
+    std::vector<int> trackMatch;   // blob index per slot, -1 = unmatched
+    std::vector<uint8_t> blobUsed;
+
+    // Global assignment scratch (reused, no allocation in steady state)
+    std::vector<int> cellStart, cellItems;
+    std::vector<Edge> edges;
+    std::vector<int> uf;
+    std::vector<int> localTrack, localBlob; // node -> index inside its component
+    std::vector<int> compTracks, compBlobs;
+    std::vector<double> cost, potU, potV, minv;
+    std::vector<int> colOwner, way, rowToCol;
+    std::vector<uint8_t> colUsed;
+};
@@ -24,6 +24,29 @@ const EDGE_CONFIG_PATH = path.join(__dirname, '../../config/edge.json');
 const DEBOUNCE_INTERVAL_MS = 2000;
 const HUB_DEFAULT_URL = "http://192.168.120.205:8080/api/hub/analyze";
 const MIN_ZONE_INTERSECTION = 0.30;
+// Native stream ingest (native/stream_ingest.h)
+const INGEST_FULL_FRAME = 1;
+const INGEST_EVENT_SIZE = 72;   // sizeof(IngestEvent)
+const INGEST_MAX_EVENTS = 64;
+const INGEST_ARENA_SIZE = 8 * 1024 * 1024;
+const INGEST_POLL_MS = 50;
+const DEFAULT_ANALYSIS_WIDTH = 640;
+// Mask stage backend of the native detectors (tracking/filters identical for all): auto = calibrated
+const MOTION_ENGINES = { auto: -1, cpu: 0, opencl: 1, cuda: 2 };
+const MOTION_ENGINE = MOTION_ENGINES.hasOwnProperty(process.env.DSS_MOTION_ENGINE) ? MOTION_ENGINES[process.env.DSS_MOTION_ENGINE] : -1;
+// Shared-memory frame rings (native/frame_ring.h), producer e.g. dss-frame-ring-feed --camera <id>
+const FRAME_RING = process.env.DSS_FRAME_RING === '1';
+const RING_FULL_FRAME = 1;
+const RING_NO_FRAME = -2;
+const RING_MAX_AGE_MS = 3000;       // same freshness bound as the ramdisk snapshots
+const RING_RETRY_MS = 10000;        // re-attach period while a camera has no ring
+const RING_INFO_SIZE = 32;          // sizeof(RingFrameInfo)
+const ROI_RESULT_SIZE = 44;         // sizeof(RoiResult)
+const RING_MAX_ROIS = 16;
+const RING_ARENA_SIZE = 4 * 1024 * 1024;
+// Warm restart of the native detectors (native/detector_state.h): one file per camera
+const MOTION_STATE_DIR = process.env.DSS_MOTION_STATE_DIR || '/opt/dss-edge/config/motion_state';
+const MOTION_STATE_SAVE_MS = (parseInt(process.env.DSS_MOTION_STATE_SAVE_S, 10) || 300) * 1000;
 
 class AIRequestManager extends EventEmitter {
     constructor() {
@@ -40,11 +63,24 @@ class AIRequestManager extends EventEmitter {
         // Native Motion
         this.libMotion = null;
         this.detectors = new Map();
+        this.ingests = new Map(); // camId -> native stream id (camera analysed in-process)
+        this.ingestCams = new Map(); // stream id -> camId
+        this.ingestTimer = null;
+        this.rings = new Map(); // camId -> { handle, busy, lastFrameTs, info, results, arena } | { retryAt }
         this.initNativeFilter();
 
         setInterval(() => this.processQueue(), 100);
         setInterval(() => this.pipelineTick(), 1000);
         setInterval(() => this.loadConfigs(), 60000);
+
+        if (this.fnSaveState) {
+            setInterval(() => this.saveDetectorStates(), MOTION_STATE_SAVE_MS);
+            // Koffi calls are synchronous, so the states can still be written from 'exit'
+            process.on('exit', () => this.saveDetectorStates());
+            ['SIGTERM', 'SIGINT'].forEach(sig => {
+                if (process.listenerCount(sig) === 0) process.once(sig, () => process.exit(0));
+            });
+        }
     }
 
     initNativeFilter() {
@@ -54,8 +90,22 @@ class AIRequestManager extends EventEmitter {
             if (fs.existsSync(libPath)) {
                 this.libMotion = koffi.load(libPath);
                 this.fnCreate = this.libMotion.func('void* create_detector(int width, int height, double minAreaRatio, int minFrames, double maxStaticVariance)');
+                this.fnCreateEngine = this.libMotion.func('void* create_detector_engine(int width, int height, double minAreaRatio, int minFrames, double maxStaticVariance, int engine)');
+                this.fnDetectorEngine = this.libMotion.func('int get_detector_engine(void* handle)');
                 this.fnProcess = this.libMotion.func('int process_frame_file(void* handle, const char* imagePath)');
                 this.fnDestroy = this.libMotion.func('void destroy_detector(void* handle)');
+                this.fnSubmitBatch = this.libMotion.func('int submit_frame_batch(void** handles, const char** imagePaths, int count)');
+                this.fnPollBatch = this.libMotion.func('int poll_frame_batch(int batchId, _Out_ int* results, int count)');
+                this.fnStats = this.libMotion.func('int get_detector_stats(void* handle, _Out_ uint64_t* out, int count)');
+                this.fnStartIngest = this.libMotion.func('int start_stream_ingest(void* handle, const char* url, double analysisFps, int flags)');
+                this.fnStopIngest = this.libMotion.func('void stop_stream_ingest(int streamId)');
+                this.fnIngestState = this.libMotion.func('int get_stream_ingest_state(int streamId)');
+                this.fnPollIngest = this.libMotion.func('int poll_ingest_events(void* events, int maxEvents, uint8_t* arena, int arenaSize)');
+                this.fnOpenRing = this.libMotion.func('void* open_frame_ring(const char* name)');
+                this.fnCloseRing = this.libMotion.func('void close_frame_ring(void* ring)');
+                this.fnProcessRing = this.libMotion.func('int process_frame_ring(void* handle, void* ring, int maxAgeMs, int flags, void* info, void* results, int maxResults, uint8_t* arena, int arenaSize)');
+                this.fnSaveState = this.libMotion.func('int save_detector_state(void* handle, const char* path)');
+                this.fnLoadState = this.libMotion.func('int load_detector_state(void* handle, const char* path)');
                 console.log("[AI] Native Motion Filter: ACTIVE");
             }
         } catch (e) {
@@ -78,64 +128,327 @@ class AIRequestManager extends EventEmitter {
     }
 
     async pipelineTick() {
+        // Previous native batch still running: skip, the strands keep per-camera order anyway
+        if (this.batchInFlight) return;
+
         const cams = cameraStore.list();
+        const ready = [];
         for (const cam of cams) {
-            if (cam.status === "ONLINE") this.runPipelineForCamera(cam.id);
+            if (cam.status !== "ONLINE") continue;
+            // Analysed continuously in-process, the detector belongs to the ingest thread
+            if (this.ingests.has(cam.id)) continue;
+            // Raw frames from shared memory: no snapshot file for this camera
+            if (this.analyseRing(cam.id)) continue;
+            const frame = this.acquireFrame(cam.id);
+            if (frame) ready.push(frame);
+        }
+        if (ready.length === 0) return;
+
+        let nativeResults = null;
+        if (this.libMotion && this.fnSubmitBatch) {
+            this.batchInFlight = true;
+            try { nativeResults = await this.runNativeBatch(ready); }
+            finally { this.batchInFlight = false; }
         }
+
+        ready.forEach((frame, i) => {
+            this.finishPipelineForCamera(frame, nativeResults ? nativeResults[i] > 0 : false);
+        });
     }
 
-    async runPipelineForCamera(camId) {
-        const cam = cameraStore.get(camId);
+    // Submit all cameras in one native call and poll for completion without blocking the loop
+    runNativeBatch(frames) {
+        const handles = frames.map(f => this.getDetector(f.camId));
+        const paths = frames.map(f => f.ramDiskPath);
+
+        const batchId = this.fnSubmitBatch(handles, paths, frames.length);
+        if (batchId < 0) return Promise.resolve(null);
+
+        const results = new Int32Array(frames.length);
+        return new Promise(resolve => {
+            const poll = () => {
+                const st = this.fnPollBatch(batchId, results, frames.length);
+                if (st === 0) return setTimeout(poll, 5);
+                resolve(st === 1 ? results : null);
+            };
+            poll();
+        });
+    }
+
+    getDetector(camId) {
+        let detector = this.detectors.get(camId);
+        if (!detector) {
+            // Analysis resolution per camera (ai_server.analysis_width), independent of the sensor:
+            // the detector reduces every frame to it and maps the ROIs back to source pixels
+            const cam = cameraStore.get(camId);
+            const width = (cam && cam.ai_server && parseInt(cam.ai_server.analysis_width, 10)) || DEFAULT_ANALYSIS_WIDTH;
+            detector = this.fnCreateEngine(width, Math.round(width * 9 / 16), 0.005, 1, 25.0, MOTION_ENGINE);
+            this.detectors.set(camId, detector);
+            // Background + tracks from the previous run: no re-learning after a restart
+            if (this.fnLoadState && this.fnLoadState(detector, this.detectorStatePath(camId)) === 1) {
+                console.log(`[AI] ${camId}: native detector state restored`);
+            }
+            const engine = Object.keys(MOTION_ENGINES).find(k => MOTION_ENGINES[k] === this.fnDetectorEngine(detector));
+            console.log(`[AI] ${camId}: native detector ${width}px wide, mask stage on ${engine}`);
+        }
+        return detector;
+    }
+
+    detectorStatePath(camId) {
+        return path.join(MOTION_STATE_DIR, `${String(camId).replace(/[^A-Za-z0-9_.-]/g, '_')}.state`);
+    }
+
+    saveDetectorStates() {
+        if (!this.fnSaveState || this.detectors.size === 0) return;
+        try {
+            fs.mkdirSync(MOTION_STATE_DIR, { recursive: true });
+        } catch (e) {
+            return;
+        }
+        for (const [camId, detector] of this.detectors) {
+            this.fnSaveState(detector, this.detectorStatePath(camId));
+        }
+    }
+
+    // Continuous native analysis of a stream (RTSP restream or file), replaces the snapshot path
+    // for this camera. Returns false when the native library or libav support is missing.
+    startStreamIngest(camId, url, analysisFps = 5) {
+        if (!this.fnStartIngest) return false;
+        if (this.ingests.has(camId)) return true;
+
+        const streamId = this.fnStartIngest(this.getDetector(camId), url, analysisFps, INGEST_FULL_FRAME);
+        if (streamId <= 0) return false;
+        this.ingests.set(camId, streamId);
+        this.ingestCams.set(streamId, camId);
+
+        if (!this.ingestTimer) {
+            this.ingestEvents = Buffer.alloc(INGEST_EVENT_SIZE * INGEST_MAX_EVENTS);
+            this.ingestArena = Buffer.alloc(INGEST_ARENA_SIZE);
+            this.ingestTimer = setInterval(() => this.pollIngest(), INGEST_POLL_MS);
+        }
+        console.log(`[AI] ${camId}: native stream ingest #${streamId} (${url})`);
+        return true;
+    }
+
+    stopStreamIngest(camId) {
+        const streamId = this.ingests.get(camId);
+        if (streamId === undefined) return;
+        this.fnStopIngest(streamId);
+        this.ingests.delete(camId);
+        this.ingestCams.delete(streamId);
+
+        if (this.ingests.size === 0 && this.ingestTimer) {
+            clearInterval(this.ingestTimer);
+            this.ingestTimer = null;
+        }
+    }
+
+    // 1 connecting, 2 running, 3 file ended, 0 stopped / not ingested
+    getStreamIngestState(camId) {
+        const streamId = this.ingests.get(camId);
+        return streamId === undefined ? 0 : this.fnIngestState(streamId);
+    }
+
+    pollIngest() {
+        for (;;) {
+            const n = this.fnPollIngest(this.ingestEvents, INGEST_MAX_EVENTS, this.ingestArena, INGEST_ARENA_SIZE);
+            if (n <= 0) return;
+
+            for (let i = 0; i < n; i++) {
+                // IngestEvent layout: streamId, kind, timestampMs, frameSeq, RoiResult (roi_result.h)
+                const b = this.ingestEvents, o = i * INGEST_EVENT_SIZE;
+                const camId = this.ingestCams.get(b.readInt32LE(o));
+                if (camId === undefined) continue;
+                const offset = b.readInt32LE(o + 60), len = b.readInt32LE(o + 64);
+                if (offset < 0) continue; // larger than the arena
+                const jpeg = Buffer.from(this.ingestArena.subarray(offset, offset + len));
+                const timestamp = Number(b.readBigInt64LE(o + 8));
+
+                if (b.readInt32LE(o + 4) === 1) {
+                    this.onIngestFrame(camId, jpeg, timestamp);
+                } else {
+                    this.emit('nativeRoi', {
+                        camId,
+                        timestamp,
+                        frameSeq: Number(b.readBigInt64LE(o + 16)),
+                        trackId: b.readUInt32LE(o + 24),
+                        bbox: { x: b.readInt32LE(o + 28), y: b.readInt32LE(o + 32), w: b.readInt32LE(o + 36), h: b.readInt32LE(o + 40) },
+                        crop: { x: b.readInt32LE(o + 44), y: b.readInt32LE(o + 48), w: b.readInt32LE(o + 52), h: b.readInt32LE(o + 56) },
+                        jpeg
+                    });
+                }
+            }
+            if (n < INGEST_MAX_EVENTS) return;
+        }
+    }
+
+    // Full frame with valid native tracks: same gating and job as the snapshot pipeline
+    onIngestFrame(camId, jpeg, timestamp) {
+        const cam = this.checkTrigger(camId);
         if (!cam) return;
 
+        const state = this.cameraStates.get(camId) || { lastTriggerTs: 0, prevBuffer: null };
+        console.log(`[AI] [MOTION AUTHORIZED] ${camId} (Method: NATIVE_STREAM) -> AI REQUEST`);
+        state.lastTriggerTs = Date.now();
+        this.cameraStates.set(camId, state);
+
+        this.queue.push({ camId, timestamp, camConfig: cam, buffer: jpeg });
+        if (this.queue.length > 5) this.queue.shift();
+    }
+
+    // Attached ring of the camera (lazy, retried every RING_RETRY_MS), or null
+    getRing(camId) {
+        if (!FRAME_RING || !this.fnOpenRing) return null;
+        let ring = this.rings.get(camId);
+        if (ring && ring.handle) return ring;
+        if (ring && Date.now() < ring.retryAt) return null;
+
+        const handle = this.fnOpenRing(`/dss_ring_${camId}`);
+        if (!handle) {
+            this.rings.set(camId, { retryAt: Date.now() + RING_RETRY_MS });
+            return null;
+        }
+        ring = {
+            handle, busy: false, lastFrameTs: Date.now(),
+            info: Buffer.alloc(RING_INFO_SIZE),
+            results: Buffer.alloc(ROI_RESULT_SIZE * RING_MAX_ROIS),
+            arena: Buffer.alloc(RING_ARENA_SIZE)
+        };
+        this.rings.set(camId, ring);
+        console.log(`[AI] ${camId}: attached to frame ring /dss_ring_${camId}`);
+        return ring;
+    }
+
+    // Newest ring frame through the native detector, off the event loop (koffi async).
+    // False when the camera has no ring: the caller falls back to the snapshot path.
+    analyseRing(camId) {
+        const ring = this.getRing(camId);
+        if (!ring) return false;
+        if (ring.busy) return true;
+
+        const cam = this.checkTrigger(camId);
+        if (!cam) return true;
+
+        ring.busy = true;
+        this.fnProcessRing.async(this.getDetector(camId), ring.handle, RING_MAX_AGE_MS, RING_FULL_FRAME,
+            ring.info, ring.results, RING_MAX_ROIS, ring.arena, RING_ARENA_SIZE, (err, n) => {
+                ring.busy = false;
+                if (err) return;
+                if (n === RING_NO_FRAME) {
+                    // Producer gone (or restarted with a new ring): re-attach
+                    if (Date.now() - ring.lastFrameTs > RING_MAX_AGE_MS * 2) this.detachRing(camId);
+                    return;
+                }
+                ring.lastFrameTs = Date.now();
+                if (n <= 0) return; // no valid tracks, or torn by the producer
+
+                // RingFrameInfo: frameSeq, timestampMs, width, height, fullOffset, fullLen
+                const fullOffset = ring.info.readInt32LE(24), fullLen = ring.info.readInt32LE(28);
+                if (fullOffset < 0) return;
+                const jpeg = Buffer.from(ring.arena.subarray(fullOffset, fullOffset + fullLen));
+                this.onIngestFrame(camId, jpeg, Number(ring.info.readBigInt64LE(8)));
+            });
+        return true;
+    }
+
+    detachRing(camId) {
+        const ring = this.rings.get(camId);
+        if (ring && ring.handle && !ring.busy) this.fnCloseRing(ring.handle);
+        this.rings.set(camId, { retryAt: Date.now() + RING_RETRY_MS });
+    }
+
+    // Native per-camera metrics (layout: native/detector_stats.h). Lock-free snapshot, cheap to call.
+    getNativeStats(camId) {
+        const detector = this.detectors.get(camId);
+        if (!detector || !this.fnStats) return null;
+
+        const STAGES = ['decode', 'mask', 'blob', 'track', 'encode'];
+        const BUCKETS = 22, PER_STAGE = 3 + BUCKETS, BASE = 9;
+        const raw = new BigUint64Array(BASE + STAGES.length * PER_STAGE);
+        const n = this.fnStats(detector, raw, raw.length);
+        if (n < raw.length) return null;
+
+        const v = i => Number(raw[i]);
+        const stats = {
+            frames: v(0), blobs: v(1), tracks: v(2), validObjects: v(3), skippedFrames: v(4), nonZero: v(5), gatedFrames: v(6),
+            lightingEvents: v(7), shakeEvents: v(8),
+            stages: {}
+        };
+        STAGES.forEach((name, s) => {
+            const b = BASE + s * PER_STAGE;
+            const count = v(b);
+            stats.stages[name] = {
+                count,
+                avgUs: count ? v(b + 1) / count : 0,
+                maxUs: v(b + 2),
+                histLog2Us: Array.from(raw.subarray(b + 3, b + 3 + BUCKETS), Number)
+            };
+        });
+        return stats;
+    }
+
+    // Steps 1-3: config, arming, debounce. Returns the camera when a trigger may fire.
+    checkTrigger(camId) {
+        const cam = cameraStore.get(camId);
+        if (!cam) return null;
+
         // 1. CONFIG CHECK
         if (!cam.ai_server || !cam.ai_server.enabled) {
             // Only log this rarely or once per startup to avoid spam, but for debug now:
             // console.log(`[AI] ${camId}: AI Disabled`);
-            return;
+            return null;
         }
         if (!cam.ai_server.zones || cam.ai_server.zones.length === 0) {
             // console.log(`[AI] ${camId}: No Zones Defined`);
-            return;
+            return null;
         }
 
         // 2. ARMING CHECK
         if (!isArmed(cam)) {
             // Debug log to see WHY it's disarmed
             // console.log(`[AI] ${camId}: Camera Disarmed`);
-            return;
+            return null;
         }
 
         // 3. DEBOUNCE
         const now = Date.now();
         let state = this.cameraStates.get(camId) || { lastTriggerTs: 0, prevBuffer: null };
-        if (now - state.lastTriggerTs < DEBOUNCE_INTERVAL_MS) return; // Debounce silent
+        if (now - state.lastTriggerTs < DEBOUNCE_INTERVAL_MS) return null; // Debounce silent
+
+        return cam;
+    }
+
+    // Steps 1-4: trigger checks and a fresh snapshot on the ramdisk
+    acquireFrame(camId) {
+        const cam = this.checkTrigger(camId);
+        if (!cam) return null;
 
         // 4. FRAME ACQUISITION
+        const now = Date.now();
         const ramDiskPath = path.resolve(__dirname, '../../recorder/ramdisk/snapshots', `${camId}.jpg`);
-        if (!fs.existsSync(ramDiskPath)) return;
+        if (!fs.existsSync(ramDiskPath)) return null;
         const stats = fs.statSync(ramDiskPath);
         if (now - stats.mtimeMs > 3000) {
             // console.log(`[AI] ${camId}: Stale Snapshot (>3s)`);
-            return;
+            return null;
         }
 
+        return { camId, cam, ramDiskPath };
+    }
+
+    finishPipelineForCamera(frame, nativeMotion) {
+        const { camId, cam, ramDiskPath } = frame;
+        const now = Date.now();
+        let state = this.cameraStates.get(camId) || { lastTriggerTs: 0, prevBuffer: null };
+
         // 5. MOTION DETECTION (Hybrid)
         let motionDetected = false;
         let method = "NONE";
 
-        // Native
-        if (this.libMotion) {
-            let detector = this.detectors.get(camId);
-            if (!detector) {
-                detector = this.fnCreate(640, 360, 0.005, 1, 25.0);
-                this.detectors.set(camId, detector);
-            }
-            const res = this.fnProcess(detector, ramDiskPath);
-            if (res > 0) {
-                motionDetected = true;
-                method = "NATIVE";
-            }
+        // Native (computed in the batch)
+        if (nativeMotion) {
+            motionDetected = true;
+            method = "NATIVE";
         }
 
         // Software Fallback
@@ -1,11 +1,16 @@
 const { spawn } = require("child_process");
 const fs = require("fs");
+const net = require("net");
 const path = require("path");
 const sqlite3 = require("sqlite3");
 
 const CONFIG_PATH = "/opt/dss-edge/config/cameras.json";
 const STORAGE_ROOT = "/opt/dss-edge/storage";
 const RECORDER_BIN = "/opt/dss-edge/recorder_cpp/build/recorder";
+// DSS_RECORDER_SERVE=1: one recorder process for every camera (recorder --serve),
+// cameras added/removed through its control socket instead of one process per camera
+const SERVE_MODE = process.env.DSS_RECORDER_SERVE === "1";
+const CONTROL_SOCKET = process.env.DSS_RECORDER_CONTROL || "/tmp/dss_recorder.sock";
 
 let RECORDERS = {};
 let lastWriteAt = {};
@@ -45,10 +50,9 @@ function getDb(camId) {
     return db;
 }
 
-function addSegmentToDb(camId, segmentFile, endTs) {
+function addSegmentToDb(camId, segmentFile, startTs, endTs) {
     const db = getDb(camId);
-    const durationCount = 3000; // 3s
-    const start = endTs - durationCount;
+    const start = startTs != null ? startTs : endTs - 3000; // 3s
 
     db.run(
         "INSERT OR REPLACE INTO segments (file, start_ts, end_ts) VALUES (?, ?, ?)",
@@ -59,8 +63,94 @@ function addSegmentToDb(camId, segmentFile, endTs) {
     );
 }
 
+function handleRecorderLine(line) {
+    if (!line.trim()) return;
+    try {
+        const msg = JSON.parse(line);
+        if (msg.event === "segment_written" && msg.camera) {
+            // Emitted when the segment is finalized, with its exact start/end (ms)
+            lastWriteAt[msg.camera] = Date.now();
+            const end = msg.end_ts != null ? msg.end_ts : msg.ts * 1000;
+            addSegmentToDb(msg.camera, msg.file, msg.start_ts, end);
+        }
+    } catch (e) {
+        // partial json or log line
+    }
+}
+
+// --- Serve mode: a single recorder process --------------------------------------
+
+let service = null;
+
+function startService() {
+    if (service) return;
+    console.log(`[Orchestrator] Starting recorder service (${CONTROL_SOCKET})`);
+    const proc = spawn(RECORDER_BIN, ["--serve", "--out", STORAGE_ROOT, "--control", CONTROL_SOCKET]);
+    service = proc;
+
+    let pending = "";
+    proc.stdout.on("data", data => {
+        const lines = (pending + data.toString()).split('\n');
+        pending = lines.pop();
+        lines.forEach(handleRecorderLine);
+    });
+
+    proc.on("exit", (code) => {
+        console.log(`[Orchestrator] Recorder service exited with code ${code}`);
+        if (service === proc) service = null;
+        // Every camera goes with it; the next sync adds them to the new process
+        Object.keys(RECORDERS).forEach(id => delete RECORDERS[id]);
+    });
+
+    proc.on("error", (err) => {
+        console.error("[Orchestrator] Recorder service error:", err);
+        if (service === proc) service = null;
+    });
+}
+
+// One command per connection, resolves with the JSON reply
+function controlCommand(line) {
+    return new Promise((resolve, reject) => {
+        const sock = net.createConnection(CONTROL_SOCKET);
+        let reply = "";
+        sock.setTimeout(5000, () => sock.destroy(new Error("control socket timeout")));
+        sock.on("connect", () => sock.write(line + "\n"));
+        sock.on("data", d => {
+            reply += d.toString();
+            if (reply.includes("\n")) {
+                sock.end();
+                try { resolve(JSON.parse(reply)); } catch (e) { reject(e); }
+            }
+        });
+        sock.on("error", reject);
+    });
+}
+
+function addToService(cam, rtspUrl) {
+    RECORDERS[cam.id] = { service: true };
+    lastWriteAt[cam.id] = Date.now();
+    controlCommand(`add ${cam.id} ${rtspUrl}`).then(r => {
+        if (!r.ok && r.error !== "already recording") {
+            console.error(`[Orchestrator] add ${cam.id}: ${r.error}`);
+            delete RECORDERS[cam.id]; // retried on the next sync
+        }
+    }).catch(err => {
+        console.error(`[Orchestrator] add ${cam.id}:`, err.message);
+        delete RECORDERS[cam.id];
+    });
+}
+
+function removeFromService(id) {
+    delete RECORDERS[id];
+    controlCommand(`remove ${id}`).catch(err => console.error(`[Orchestrator] remove ${id}:`, err.message));
+}
+
 function startRecorder(cam, rtspUrl) {
     if (RECORDERS[cam.id]) return;
+    if (SERVE_MODE) {
+        if (service) addToService(cam, rtspUrl);
+        return;
+    }
 
     console.log(`[Orchestrator] Starting recorder for ${cam.id} -> ${rtspUrl}`);
     const proc = spawn(RECORDER_BIN, [
@@ -73,20 +163,7 @@ function startRecorder(cam, rtspUrl) {
     lastWriteAt[cam.id] = Date.now();
 
     proc.stdout.on("data", data => {
-        const lines = data.toString().split('\n');
-        for (let line of lines) {
-            if (!line.trim()) continue;
-            try {
-                const msg = JSON.parse(line);
-                if (msg.event === "segment_written") {
-                    lastWriteAt[cam.id] = Date.now();
-                    const end = msg.ts * 1000;
-                    addSegmentToDb(cam.id, msg.file, end);
-                }
-            } catch (e) {
-                // partial json or log line
-            }
-        }
+        data.toString().split('\n').forEach(handleRecorderLine);
     });
 
     proc.on("exit", (code) => {
@@ -110,6 +187,7 @@ function sync() {
     isSyncing = true;
 
     try {
+        if (SERVE_MODE) startService();
         const cameras = loadCameras();
         const enabledCams = new Set();
 
@@ -128,6 +206,7 @@ function sync() {
         Object.keys(RECORDERS).forEach(id => {
             if (!enabledCams.has(id)) {
                 console.log(`[Orchestrator] Stopping disabled camera ${id}`);
+                if (SERVE_MODE) return removeFromService(id);
                 RECORDERS[id].kill("SIGTERM");
                 delete RECORDERS[id];
             }
@@ -138,6 +217,7 @@ function sync() {
         Object.keys(RECORDERS).forEach(id => {
             if (now - lastWriteAt[id] > 60000) {
                 console.warn(`[Orchestrator] Camera ${id} STUCK (no segments). Restarting...`);
+                if (SERVE_MODE) return removeFromService(id); // re-added by the next sync
                 RECORDERS[id].kill("SIGKILL");
                 delete RECORDERS[id];
             }
@@ -152,7 +232,8 @@ function sync() {
 
 // Global Cleanup
 process.on('SIGTERM', () => {
-    Object.values(RECORDERS).forEach(p => p.kill());
+    if (service) service.kill("SIGTERM");
+    Object.values(RECORDERS).forEach(p => p.kill && p.kill());
     process.exit(0);
 });
 
@@ -182,6 +263,7 @@ function killGhosts() {
         // Actually, we want to kill PIDs that are NOT in our RECORDERS map.
 
         const knownPids = new Set();
+        if (service && service.pid) knownPids.add(service.pid);
         Object.values(RECORDERS).forEach(proc => {
             if (proc && proc.pid) knownPids.add(proc.pid);
         });
@@ -0,0 +1,187 @@
+#include "camera_recorder.h"
+#include "recorder_events.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <sstream>
+
+extern "C" {
+#include <libavutil/time.h>
+}
+
+static constexpr int64_t kOpenTimeoutUs = 15 * 1000000LL;
+static constexpr int64_t kReadTimeoutUs = 10 * 1000000LL;
+static constexpr int64_t kMinBackoffMs = 1000;
+static constexpr int64_t kMaxBackoffMs = 30000;
+static constexpr int64_t kStableSessionMs = 30000;
+
+static const char* kStateNames[] = {"connecting", "recording", "backoff", "stopped"};
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static bool isLive(const std::string& url) {
+    return url.rfind("rtsp://", 0) == 0;
+}
+
+static std::string avError(int err) {
+    char buf[128] = {0};
+    av_strerror(err, buf, sizeof(buf));
+    return buf;
+}
+
+CameraRecorder::CameraRecorder(CameraSpec spec, WriterPool& writers)
+    : cam(std::move(spec)), writers(writers) {
+    strand = writers.createStrand(cam.maxQueuedPackets);
+
+    SegmentMuxerConfig mc;
+    mc.cameraId = cam.id;
+    mc.outRoot = cam.outRoot;
+    mc.segmentSec = cam.segmentSec;
+    mc.liveClock = isLive(cam.url);
+    muxer = std::make_unique<SegmentMuxer>(mc, [this](const SegmentEvent& e) {
+        ++segments;
+        emitSegment(cam.id, e);
+    });
+}
+
+CameraRecorder::~CameraRecorder() {
+    stop();
+    if (reader.joinable()) reader.join();
+}
+
+void CameraRecorder::start() {
+    reader = std::thread(&CameraRecorder::readerLoop, this);
+}
+
+void CameraRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(waitMtx);
+        stopping = true;
+    }
+    waitCv.notify_all();
+}
+
+int CameraRecorder::interruptCallback(void* opaque) {
+    const CameraRecorder* self = static_cast<const CameraRecorder*>(opaque);
+    return self->stopping.load() || av_gettime_relative() > self->deadlineUs.load();
+}
+
+void CameraRecorder::readerLoop() {
+    int64_t backoffMs = kMinBackoffMs;
+    while (!stopping) {
+        stateValue = (int)State::Connecting;
+        const int64_t started = nowMs();
+        bool delivered = false;
+        std::string error;
+        try {
+            error = runSession(delivered);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        if (stopping) break;
+
+        // A session that recorded for a while means the camera is healthy again
+        if (delivered && nowMs() - started >= kStableSessionMs) backoffMs = kMinBackoffMs;
+        ++failures;
+        emitError(cam.id, error + ", reconnect in " + std::to_string(backoffMs / 1000) + "s");
+
+        stateValue = (int)State::Backoff;
+        {
+            std::unique_lock<std::mutex> lock(waitMtx);
+            waitCv.wait_for(lock, std::chrono::milliseconds(backoffMs), [this] { return stopping.load(); });
+        }
+        backoffMs = std::min(backoffMs * 2, kMaxBackoffMs);
+    }
+    stateValue = (int)State::Stopped;
+    done = true;
+}
+
+std::string CameraRecorder::runSession(bool& delivered) {
+    deadlineUs = av_gettime_relative() + kOpenTimeoutUs;
+    AVFormatContext* in = avformat_alloc_context();
+    in->interrupt_callback.callback = interruptCallback;
+    in->interrupt_callback.opaque = this;
+
+    AVDictionary* opts = nullptr;
+    if (isLive(cam.url)) av_dict_set(&opts, "rtsp_transport", "tcp", 0);
+    int ret = avformat_open_input(&in, cam.url.c_str(), nullptr, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) return "open " + cam.url + ": " + avError(ret);
+    if ((ret = avformat_find_stream_info(in, nullptr)) < 0) {
+        avformat_close_input(&in);
+        return "stream info: " + avError(ret);
+    }
+
+    // The strand was drained at the end of the previous session: safe from this thread
+    if (!muxer->begin(in)) {
+        avformat_close_input(&in);
+        return muxer->lastError();
+    }
+    stateValue = (int)State::Recording;
+    writeFailed = false;
+
+    const bool live = isLive(cam.url);
+    std::string error;
+    bool resync = false;
+    AVPacket* pkt = av_packet_alloc();
+    while (!stopping && !writeFailed) {
+        deadlineUs = av_gettime_relative() + kReadTimeoutUs;
+        ret = av_read_frame(in, pkt);
+        if (ret < 0) {
+            if (ret == AVERROR_EOF && !live) {
+                stopping = true; // a file input is recorded once
+            } else if (!stopping) {
+                error = "input " + cam.url + ": " + avError(ret);
+            }
+            break;
+        }
+        delivered = true;
+        const int64_t ms = nowMs();
+        lastPacketMs = ms;
+
+        // After a dropped packet the video resumes at the next keyframe (no broken GOP)
+        const bool video = in->streams[pkt->stream_index]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO;
+        if (resync && video) resync = !(pkt->flags & AV_PKT_FLAG_KEY);
+        if (resync) {
+            av_packet_unref(pkt);
+            continue;
+        }
+
+        AVPacket* queued = av_packet_alloc();
+        av_packet_move_ref(queued, pkt);
+        SegmentMuxer* m = muxer.get();
+        const bool accepted = writers.submit(strand, [this, m, queued, ms]() mutable {
+            if (!writeFailed && !m->push(queued, ms)) writeFailed = true;
+            av_packet_free(&queued);
+        });
+        if (!accepted) {
+            // Disk slower than the camera: bounded backlog, drop instead of growing
+            av_packet_free(&queued);
+            ++queueDrops;
+            resync = true;
+        }
+    }
+    av_packet_free(&pkt);
+
+    // Queued packets first, then the open segment is finalized here
+    writers.drain(strand);
+    muxer->finish();
+    if (writeFailed) error = muxer->lastError();
+    avformat_close_input(&in);
+    return error;
+}
+
+std::string CameraRecorder::statusJson() const {
+    std::ostringstream ss;
+    ss << "{\"id\":\"" << cam.id
+       << "\",\"url\":\"" << cam.url
+       << "\",\"state\":\"" << kStateNames[stateValue.load()]
+       << "\",\"failures\":" << failures.load()
+       << ",\"segments\":" << segments.load()
+       << ",\"queue_drops\":" << queueDrops.load()
+       << ",\"last_packet_ts\":" << lastPacketMs.load() << "}";
+    return ss.str();
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "segment_muxer.h"
+#include "writer_pool.h"
+
+struct CameraSpec {
+    std::string id;
+    std::string url;          // rtsp:// URL or a local file (recorded once, then Stopped)
+    std::string outRoot;
+    int segmentSec = 3;
+    size_t maxQueuedPackets = 4096; // writer backlog before packets are dropped
+};
+
+// One camera inside the multi-camera recorder (--serve). The demux runs on the camera's
+// own reader thread; muxing and disk writes go to its strand on the shared WriterPool.
+// Failures stay inside the camera: the reader reconnects with exponential backoff
+// (1 s .. 30 s, back to 1 s after a session that recorded for 30 s).
+class CameraRecorder {
+public:
+    enum class State { Connecting = 0, Recording = 1, Backoff = 2, Stopped = 3 };
+
+    CameraRecorder(CameraSpec spec, WriterPool& writers);
+    ~CameraRecorder(); // stop() + join
+    CameraRecorder(const CameraRecorder&) = delete;
+    CameraRecorder& operator=(const CameraRecorder&) = delete;
+
+    void start();
+    // Asks the reader to stop; finished() turns true once the open segment is finalized
+    void stop();
+    bool finished() const { return done.load(); }
+
+    const CameraSpec& spec() const { return cam; }
+    State state() const { return (State)stateValue.load(); }
+    std::string statusJson() const;
+
+private:
+    void readerLoop();
+    // Connect + demux until failure or stop. Returns the error ("" on stop).
+    std::string runSession(bool& delivered);
+    static int interruptCallback(void* opaque);
+
+    CameraSpec cam;
+    WriterPool& writers;
+    std::shared_ptr<WriterPool::Strand> strand;
+    // Used on the writer strand; the reader only touches it while the strand is drained
+    std::unique_ptr<SegmentMuxer> muxer;
+    std::thread reader;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> done{false};
+    std::atomic<bool> writeFailed{false};
+    std::atomic<int> stateValue{(int)State::Connecting};
+    std::atomic<int64_t> deadlineUs{0};
+    std::mutex waitMtx;               // backoff sleep, woken by stop()
+    std::condition_variable waitCv;
+
+    std::atomic<int> failures{0};
+    std::atomic<int> segments{0};
+    std::atomic<uint64_t> queueDrops{0};
+    std::atomic<int64_t> lastPacketMs{0};
+};
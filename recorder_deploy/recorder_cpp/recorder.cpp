@@ -1,46 +1,92 @@
 #include <iostream>
 #include <filesystem>
 #include <chrono>
-#include <ctime>
-#include <iomanip>
-#include <fstream>
-#include <sstream>
-#include <thread>
+#include <string>
 #include <vector>
 #include <csignal>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/wait.h>
+#include "segment_muxer.h"
+#include "recorder_events.h"
+#include "recorder_service.h"
+
+extern "C" {
+#include <libavutil/time.h>
+}
 
 namespace fs = std::filesystem;
 
-static bool running = true;
-void signalHandler(int signum) { running = false; }
+// No packet for this long -> the input is considered dead (orchestrator restarts us)
+static constexpr int64_t kOpenTimeoutUs = 15 * 1000000LL;
+static constexpr int64_t kReadTimeoutUs = 10 * 1000000LL;
 
-std::string todayDate() {
-    auto now = std::time(nullptr);
-    std::tm tm = *std::localtime(&now);
-    std::ostringstream ss;
-    ss << std::put_time(&tm, "%Y-%m-%d");
-    return ss.str();
+static volatile std::sig_atomic_t running = 1;
+void signalHandler(int signum) { running = 0; }
+
+// Blocking libavformat calls (connect, read) give up on stop or when the deadline passes
+static int interruptCallback(void* opaque) {
+    const int64_t deadline = *static_cast<const int64_t*>(opaque);
+    return !running || av_gettime_relative() > deadline;
 }
 
-int main(int argc, char* argv[]) {
-    std::signal(SIGINT, signalHandler);
-    std::signal(SIGTERM, signalHandler);
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string avError(int err) {
+    char buf[128] = {0};
+    av_strerror(err, buf, sizeof(buf));
+    return buf;
+}
+
+// Every camera in this process (recorder_service.h), cameras added through the control socket
+// or given as --camera <id>=<url>
+static int serve(const ServiceOptions& opt, const std::vector<std::string>& cameras) {
+    av_log_set_level(AV_LOG_ERROR);
+    avformat_network_init();
+
+    RecorderService service(opt);
+    for (const std::string& c : cameras) {
+        const size_t eq = c.find('=');
+        const std::string id = c.substr(0, eq);
+        const std::string err = eq == std::string::npos ? "expected <id>=<url>"
+                                                        : service.addCamera(id, c.substr(eq + 1), opt.segmentSec);
+        if (!err.empty()) emitError(id, err);
+    }
+    return service.run();
+}
 
+int main(int argc, char* argv[]) {
     std::string cameraId, rtspUrl, outRoot;
     int segmentSec = 3;
+    bool serveMode = false;
+    ServiceOptions serveOpt;
+    std::vector<std::string> serveCameras;
 
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
         if (arg == "--camera-id" && i + 1 < argc) cameraId = argv[++i];
-        else if (arg == "--rtsp" && i + 1 < argc) rtspUrl = argv[++i];
+        else if ((arg == "--rtsp" || arg == "--input") && i + 1 < argc) rtspUrl = argv[++i]; // rtsp:// URL or a local file
         else if (arg == "--out" && i + 1 < argc) outRoot = argv[++i];
         else if (arg == "--segment" && i + 1 < argc) segmentSec = std::stoi(argv[++i]);
+        else if (arg == "--serve") serveMode = true;
+        else if (arg == "--control" && i + 1 < argc) serveOpt.controlPath = argv[++i];
+        else if (arg == "--writers" && i + 1 < argc) serveOpt.writers = std::stoi(argv[++i]);
+        else if (arg == "--camera" && i + 1 < argc) serveCameras.push_back(argv[++i]);
     }
 
-    if (cameraId.empty() || rtspUrl.empty() || outRoot.empty()) return 1;
+    if (serveMode) {
+        if (outRoot.empty() || segmentSec <= 0) return 1;
+        serveOpt.outRoot = outRoot;
+        serveOpt.segmentSec = segmentSec;
+        return serve(serveOpt, serveCameras);
+    }
+
+    // Single camera per process (the orchestrator's default mode)
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+    if (cameraId.empty() || rtspUrl.empty() || outRoot.empty() || segmentSec <= 0) return 1;
 
     // PID Lock
     fs::path lockPath = fs::path("/tmp") / ("recorder_" + cameraId + ".lock");
@@ -50,45 +96,64 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    std::string date = todayDate();
-    fs::path dir = fs::path(outRoot) / cameraId / date;
+    fs::path dir = fs::path(outRoot) / cameraId;
     fs::create_directories(dir);
+    std::cout << "{\"event\":\"recorder_starting\",\"camera\":\"" << cameraId << "\",\"path\":\"" << dir.string() << "\"}" << std::endl;
 
-    std::ostringstream cmd;
-    cmd << "ffmpeg -y -rtsp_transport tcp -i \"" << rtspUrl << "\" "
-        << "-c:v copy -c:a copy "
-        << "-f segment -segment_time " << segmentSec << " "
-        << "-segment_format mp4 -segment_atclocktime 1 -reset_timestamps 1 "
-        << "-movflags +faststart+frag_keyframe+empty_moov "
-        << "\"" << dir.string() << "/seg_" << std::time(nullptr) << "_%d.mp4\" "
-        << "-loglevel info 2>&1";
+    // RTSP demux + -c copy segmentation in-process (segment_muxer.h), no ffmpeg child
+    av_log_set_level(AV_LOG_ERROR);
+    avformat_network_init();
+    const bool live = rtspUrl.rfind("rtsp://", 0) == 0;
 
-    std::cout << "{\"event\":\"recorder_starting\",\"camera\":\"" << cameraId << "\",\"path\":\"" << dir.string() << "\"}" << std::endl;
+    int64_t deadline = av_gettime_relative() + kOpenTimeoutUs;
+    AVFormatContext* in = avformat_alloc_context();
+    in->interrupt_callback.callback = interruptCallback;
+    in->interrupt_callback.opaque = &deadline;
 
-    FILE* pipe = popen(cmd.str().c_str(), "r");
-    if (!pipe) return 1;
-
-    char buffer[1024];
-    while (running && fgets(buffer, sizeof(buffer), pipe)) {
-        std::string line(buffer);
-        if (line.find("Opening '") != std::string::npos && line.find(".mp4'") != std::string::npos) {
-            size_t start = line.find("seg_");
-            size_t end = line.find(".mp4'", start);
-            if (start != std::string::npos && end != std::string::npos) {
-                std::string fileOnly = line.substr(start, end - start + 4);
-                std::cout << "{\"event\":\"segment_written\",\"camera\":\"" << cameraId 
-                          << "\",\"file\":\"" << date << "/" << fileOnly 
-                          << "\",\"ts\":" << std::time(nullptr) << "}" << std::endl;
+    AVDictionary* opts = nullptr;
+    if (live) av_dict_set(&opts, "rtsp_transport", "tcp", 0);
+    int ret = avformat_open_input(&in, rtspUrl.c_str(), nullptr, &opts);
+    av_dict_free(&opts);
+    if (ret >= 0) ret = avformat_find_stream_info(in, nullptr);
+
+    int exitCode = 1;
+    if (ret < 0) {
+        emitError(cameraId, "open " + rtspUrl + ": " + avError(ret));
+    } else {
+        SegmentMuxerConfig mc;
+        mc.cameraId = cameraId;
+        mc.outRoot = outRoot;
+        mc.segmentSec = segmentSec;
+        mc.liveClock = live;
+        SegmentMuxer muxer(mc, [&cameraId](const SegmentEvent& e) { emitSegment(cameraId, e); });
+
+        if (!muxer.begin(in)) {
+            emitError(cameraId, muxer.lastError());
+        } else {
+            AVPacket* pkt = av_packet_alloc();
+            while (running) {
+                deadline = av_gettime_relative() + kReadTimeoutUs;
+                ret = av_read_frame(in, pkt);
+                if (ret < 0) break;
+                const bool ok = muxer.push(pkt, nowMs());
+                av_packet_unref(pkt);
+                if (!ok) break;
+            }
+            av_packet_free(&pkt);
+            muxer.finish();
+
+            if (!muxer.lastError().empty()) {
+                emitError(cameraId, muxer.lastError());
+            } else if (!running || (!live && ret == AVERROR_EOF)) {
+                exitCode = 0; // stopped, or the whole file was recorded
+            } else {
+                emitError(cameraId, "input " + rtspUrl + ": " + avError(ret));
             }
         }
     }
 
-    int result = pclose(pipe);
+    avformat_close_input(&in);
     close(fd);
     fs::remove(lockPath);
-
-    if (WIFEXITED(result)) {
-        return WEXITSTATUS(result);
-    }
-    return 1;
+    return exitCode;
 }
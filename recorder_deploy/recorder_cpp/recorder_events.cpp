@@ -0,0 +1,32 @@
+#include "recorder_events.h"
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+static std::mutex outMutex;
+
+void emitEvent(const std::string& json) {
+    std::lock_guard<std::mutex> lock(outMutex);
+    std::cout << json << std::endl;
+}
+
+void emitError(const std::string& cameraId, const std::string& message) {
+    emitEvent("{\"event\":\"error\",\"camera\":\"" + cameraId + "\",\"message\":\"" + message + "\"}");
+}
+
+void emitSegment(const std::string& cameraId, const SegmentEvent& e) {
+    std::ostringstream ss;
+    ss << "{\"event\":\"segment_written\",\"camera\":\"" << cameraId
+       << "\",\"file\":\"" << e.file
+       << "\",\"path\":\"" << e.path
+       << "\",\"ts\":" << e.endMs / 1000
+       << ",\"start_ts\":" << e.startMs
+       << ",\"end_ts\":" << e.endMs
+       << ",\"start_pts\":" << e.startPts
+       << ",\"end_pts\":" << e.endPts
+       << ",\"time_base\":\"" << e.timeBase.num << "/" << e.timeBase.den
+       << "\",\"bytes\":" << e.bytes
+       << ",\"keyframes\":" << e.keyframes
+       << ",\"packets\":" << e.packets << "}";
+    emitEvent(ss.str());
+}
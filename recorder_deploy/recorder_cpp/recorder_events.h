@@ -0,0 +1,10 @@
+#pragma once
+#include <string>
+#include "segment_muxer.h"
+
+// JSON lines on stdout, read by the orchestrator. Safe to call from any thread
+// (one camera per process or many cameras in --serve mode).
+void emitEvent(const std::string& json);
+void emitError(const std::string& cameraId, const std::string& message);
+// Emitted once the segment is finalized (trailer written, file closed)
+void emitSegment(const std::string& cameraId, const SegmentEvent& e);
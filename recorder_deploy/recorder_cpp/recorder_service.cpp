@@ -0,0 +1,272 @@
+#include "recorder_service.h"
+#include "recorder_events.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static constexpr size_t kMaxLine = 4096;
+
+static bool validCameraId(const std::string& id) {
+    if (id.empty() || id.size() > 64) return false;
+    return std::all_of(id.begin(), id.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+    });
+}
+
+static std::string reply(const std::string& error) {
+    return error.empty() ? "{\"ok\":true}" : "{\"ok\":false,\"error\":\"" + error + "\"}";
+}
+
+RecorderService::RecorderService(ServiceOptions o) : opt(std::move(o)) {
+    // Signals go to the signalfd of the loop: block them before any thread is started
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    writers = std::make_unique<WriterPool>(opt.writers);
+}
+
+RecorderService::~RecorderService() {
+    // Readers first (each finalizes its segment through the pool), then the pool
+    for (auto& kv : registry) kv.second->stop();
+    for (auto& r : retiring) r->stop();
+    registry.clear();
+    retiring.clear();
+    writers.reset();
+
+    for (auto& kv : clients) close(kv.first);
+    for (int fd : {listenFd, signalFd, timerFd, epollFd}) {
+        if (fd >= 0) close(fd);
+    }
+    if (listenFd >= 0) unlink(opt.controlPath.c_str());
+    if (lockFd >= 0) {
+        close(lockFd);
+        unlink((opt.controlPath + ".lock").c_str());
+    }
+}
+
+bool RecorderService::setup() {
+    const std::string lockPath = opt.controlPath + ".lock";
+    lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (lockFd < 0 || lockf(lockFd, F_TLOCK, 0) < 0) {
+        emitError("", "Already running on " + opt.controlPath);
+        if (lockFd >= 0) close(lockFd);
+        lockFd = -1;
+        return false;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (opt.controlPath.size() >= sizeof(addr.sun_path)) {
+        emitError("", "control socket path too long");
+        return false;
+    }
+    std::strncpy(addr.sun_path, opt.controlPath.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(opt.controlPath.c_str()); // stale socket of a previous run (we hold the lock)
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 16) < 0) {
+        emitError("", "control socket " + opt.controlPath + ": " + std::strerror(errno));
+        return false;
+    }
+    chmod(opt.controlPath.c_str(), 0660);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    itimerspec period{};
+    period.it_interval.tv_sec = 1;
+    period.it_value.tv_sec = 1;
+    if (timerFd >= 0) timerfd_settime(timerFd, 0, &period, nullptr);
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (signalFd < 0 || timerFd < 0 || epollFd < 0) {
+        emitError("", std::string("event loop: ") + std::strerror(errno));
+        return false;
+    }
+    for (int fd : {listenFd, signalFd, timerFd}) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    return true;
+}
+
+int RecorderService::run() {
+    if (!setup()) return 1;
+    emitEvent("{\"event\":\"service_started\",\"control\":\"" + opt.controlPath +
+              "\",\"writers\":" + std::to_string(writers->threadCount()) + "}");
+
+    epoll_event events[32];
+    bool quit = false;
+    while (!quit) {
+        const int n = epoll_wait(epollFd, events, 32, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            emitError("", std::string("epoll: ") + std::strerror(errno));
+            return 1;
+        }
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptClients();
+            } else if (fd == signalFd) {
+                signalfd_siginfo si;
+                while (read(signalFd, &si, sizeof(si)) == (ssize_t)sizeof(si)) quit = true;
+            } else if (fd == timerFd) {
+                uint64_t expirations;
+                while (read(timerFd, &expirations, sizeof(expirations)) > 0) {}
+                tick();
+            } else {
+                readClient(fd);
+            }
+        }
+    }
+
+    emitEvent("{\"event\":\"service_stopping\",\"cameras\":" + std::to_string(registry.size()) + "}");
+    return 0;
+}
+
+void RecorderService::acceptClients() {
+    for (;;) {
+        const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN: all accepted
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            continue;
+        }
+        clients[fd].clear();
+    }
+}
+
+void RecorderService::closeClient(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    clients.erase(fd);
+}
+
+void RecorderService::readClient(int fd) {
+    auto it = clients.find(fd);
+    if (it == clients.end()) return;
+
+    char buf[1024];
+    for (;;) {
+        const ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            it->second.append(buf, (size_t)n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closeClient(fd); // EOF or error
+        return;
+    }
+
+    std::string& pending = it->second;
+    size_t eol;
+    while ((eol = pending.find('\n')) != std::string::npos) {
+        std::string line = pending.substr(0, eol);
+        pending.erase(0, eol + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        // Responses are small; a client that does not read them is dropped
+        const std::string out = handleCommand(line) + "\n";
+        if (send(fd, out.data(), out.size(), MSG_NOSIGNAL | MSG_DONTWAIT) != (ssize_t)out.size()) {
+            closeClient(fd);
+            return;
+        }
+    }
+    if (pending.size() > kMaxLine) closeClient(fd);
+}
+
+std::string RecorderService::handleCommand(const std::string& line) {
+    std::istringstream in(line);
+    std::string cmd;
+    in >> cmd;
+
+    if (cmd == "add") {
+        std::string id, url;
+        int segmentSec = opt.segmentSec;
+        in >> id >> url;
+        if (!(in >> segmentSec)) segmentSec = opt.segmentSec;
+        return reply(addCamera(id, url, segmentSec));
+    }
+    if (cmd == "remove") {
+        std::string id;
+        in >> id;
+        return reply(removeCamera(id));
+    }
+    if (cmd == "list") {
+        std::string out = "{\"ok\":true,\"cameras\":[";
+        bool first = true;
+        for (const auto& kv : registry) {
+            if (!first) out += ",";
+            out += kv.second->statusJson();
+            first = false;
+        }
+        return out + "]}";
+    }
+    return reply("unknown command");
+}
+
+std::string RecorderService::addCamera(const std::string& id, const std::string& url, int segmentSec) {
+    if (!validCameraId(id)) return "invalid camera id";
+    if (url.empty()) return "missing url";
+    if (segmentSec <= 0) return "invalid segment length";
+    if (registry.count(id)) return "already recording";
+    for (const auto& r : retiring) {
+        if (r->spec().id == id) return "still stopping, retry";
+    }
+
+    CameraSpec spec;
+    spec.id = id;
+    spec.url = url;
+    spec.outRoot = opt.outRoot;
+    spec.segmentSec = segmentSec;
+    spec.maxQueuedPackets = opt.maxQueuedPackets;
+    auto cam = std::make_unique<CameraRecorder>(spec, *writers);
+    cam->start();
+    registry.emplace(id, std::move(cam));
+
+    emitEvent("{\"event\":\"recorder_starting\",\"camera\":\"" + id + "\",\"path\":\"" + opt.outRoot + "/" + id + "\"}");
+    return "";
+}
+
+std::string RecorderService::removeCamera(const std::string& id) {
+    auto it = registry.find(id);
+    if (it == registry.end()) return "unknown camera";
+
+    // The reader finalizes the open segment on its own thread; joined from tick()
+    it->second->stop();
+    retiring.push_back(std::move(it->second));
+    registry.erase(it);
+    emitEvent("{\"event\":\"recorder_stopping\",\"camera\":\"" + id + "\"}");
+    return "";
+}
+
+void RecorderService::tick() {
+    retiring.erase(std::remove_if(retiring.begin(), retiring.end(),
+                                  [](const std::unique_ptr<CameraRecorder>& r) { return r->finished(); }),
+                   retiring.end());
+}
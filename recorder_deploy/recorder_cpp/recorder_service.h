@@ -0,0 +1,61 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "camera_recorder.h"
+#include "writer_pool.h"
+
+struct ServiceOptions {
+    std::string outRoot;
+    std::string controlPath = "/tmp/dss_recorder.sock";
+    int writers = 2;
+    int segmentSec = 3;
+    size_t maxQueuedPackets = 4096;
+};
+
+// Multi-camera recorder (recorder --serve): one process for every camera.
+// An epoll loop owns the control socket, the signals and a 1 s supervision timer;
+// each camera demuxes on its own reader thread and writes through the shared WriterPool.
+// The registry (camera id -> recorder) replaces the per-camera /tmp/recorder_<id>.lock
+// files; a single lock next to the control socket keeps one service per socket.
+//
+// Control protocol: one command per line, one JSON line back.
+//   add <id> <url> [segmentSec]   start recording (id: [A-Za-z0-9_-])
+//   remove <id>                   finalize the open segment and stop
+//   list                          state, failures, segments, drops per camera
+class RecorderService {
+public:
+    explicit RecorderService(ServiceOptions opt);
+    ~RecorderService();
+    RecorderService(const RecorderService&) = delete;
+    RecorderService& operator=(const RecorderService&) = delete;
+
+    // Runs until SIGINT/SIGTERM; returns the process exit code
+    int run();
+
+    // "" on success, the error otherwise (also used for cameras given on the command line)
+    std::string addCamera(const std::string& id, const std::string& url, int segmentSec);
+    std::string removeCamera(const std::string& id);
+
+private:
+    bool setup();
+    void acceptClients();
+    void readClient(int fd);
+    void closeClient(int fd);
+    std::string handleCommand(const std::string& line);
+    void tick();
+
+    ServiceOptions opt;
+    std::unique_ptr<WriterPool> writers; // created after the signals are blocked
+    std::map<std::string, std::unique_ptr<CameraRecorder>> registry;
+    std::vector<std::unique_ptr<CameraRecorder>> retiring; // stopping, finalizing their segment
+
+    int epollFd = -1;
+    int listenFd = -1;
+    int signalFd = -1;
+    int timerFd = -1;
+    int lockFd = -1;
+    std::unordered_map<int, std::string> clients; // fd -> unterminated input
+};
@@ -0,0 +1,229 @@
+#include "segment_muxer.h"
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// Beyond this the camera timeline is no longer trusted for the wall clock
+static constexpr int64_t kMaxClockDriftMs = 2000;
+static const AVRational kMsTb{1, 1000};
+
+static std::string dateOf(int64_t epochSec) {
+    std::time_t t = (std::time_t)epochSec;
+    // localtime_r: muxers for different cameras run concurrently on WriterPool threads
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    std::ostringstream ss;
+    ss << std::put_time(&tm, "%Y-%m-%d");
+    return ss.str();
+}
+
+SegmentMuxer::SegmentMuxer(SegmentMuxerConfig cfg, EventFn onSegment)
+    : cfg(std::move(cfg)), onSegment(std::move(onSegment)) {}
+
+SegmentMuxer::~SegmentMuxer() {
+    finish();
+    for (AVCodecParameters*& p : outParams) avcodec_parameters_free(&p);
+}
+
+bool SegmentMuxer::begin(const AVFormatContext* in) {
+    streams.assign(in->nb_streams, StreamMap());
+    for (AVCodecParameters*& p : outParams) avcodec_parameters_free(&p);
+    outParams.clear();
+    videoIndex = -1;
+
+    for (unsigned i = 0; i < in->nb_streams; ++i) {
+        if (in->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            videoIndex = (int)i;
+            break;
+        }
+    }
+    if (videoIndex < 0) {
+        error = "no video stream";
+        return false;
+    }
+
+    // Video first, then every audio stream (like -c:v copy -c:a copy); data streams are skipped
+    auto add = [&](unsigned i) {
+        AVCodecParameters* p = avcodec_parameters_alloc();
+        avcodec_parameters_copy(p, in->streams[i]->codecpar);
+        p->codec_tag = 0; // the RTSP/MP4 tags differ, let the muxer choose
+        streams[i].out = (int)outParams.size();
+        streams[i].inTb = in->streams[i]->time_base;
+        outParams.push_back(p);
+    };
+    add((unsigned)videoIndex);
+    for (unsigned i = 0; i < in->nb_streams; ++i) {
+        if (in->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) add(i);
+    }
+    videoTb = in->streams[videoIndex]->time_base;
+    anchored = false;
+    return true;
+}
+
+int64_t SegmentMuxer::wallClock(int64_t pts, int64_t nowMs) {
+    if (!anchored) {
+        anchored = true;
+        anchorPts = pts;
+        anchorMs = nowMs;
+    }
+    int64_t ms = anchorMs + av_rescale_q(pts - anchorPts, videoTb, kMsTb);
+    if (cfg.liveClock && std::llabs(ms - nowMs) > kMaxClockDriftMs) {
+        anchorPts = pts;
+        anchorMs = nowMs;
+        ms = nowMs;
+    }
+    return ms;
+}
+
+bool SegmentMuxer::fail(const std::string& what, int err) {
+    char buf[128] = {0};
+    av_strerror(err, buf, sizeof(buf));
+    error = what + ": " + buf;
+    return false;
+}
+
+bool SegmentMuxer::openSegment(const AVPacket* key, int64_t wallMs) {
+    const int64_t startSec = wallMs / 1000;
+    const std::string date = dateOf(startSec);
+    const std::string name = "seg_" + std::to_string(startSec) + "_" + std::to_string(segmentIndex++) + ".mp4";
+    const fs::path dir = fs::path(cfg.outRoot) / cfg.cameraId / date;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    current = SegmentEvent();
+    current.path = (dir / name).string();
+    current.file = date + "/" + name;
+    current.startPts = key->pts != AV_NOPTS_VALUE ? key->pts : key->dts;
+    current.timeBase = videoTb;
+    current.startMs = wallMs;
+
+    int ret = avformat_alloc_output_context2(&out, nullptr, "mp4", current.path.c_str());
+    if (ret < 0 || !out) {
+        out = nullptr;
+        return fail("alloc output " + current.path, ret);
+    }
+    for (const AVCodecParameters* p : outParams) {
+        AVStream* st = avformat_new_stream(out, nullptr);
+        if (!st || (ret = avcodec_parameters_copy(st->codecpar, p)) < 0) {
+            avformat_free_context(out);
+            out = nullptr;
+            return fail("output stream", ret < 0 ? ret : AVERROR(ENOMEM));
+        }
+    }
+    if ((ret = avio_open(&out->pb, current.path.c_str(), AVIO_FLAG_WRITE)) < 0) {
+        avformat_free_context(out);
+        out = nullptr;
+        return fail("open " + current.path, ret);
+    }
+
+    // Fragmented MP4: playable while being written, nothing to rewrite at the end
+    AVDictionary* opts = nullptr;
+    av_dict_set(&opts, "movflags", "+frag_keyframe+empty_moov+default_base_moof", 0);
+    ret = avformat_write_header(out, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        avio_closep(&out->pb);
+        avformat_free_context(out);
+        out = nullptr;
+        return fail("write header " + current.path, ret);
+    }
+
+    // reset_timestamps: the cutting keyframe becomes t = 0 in every stream. Its dts is used,
+    // so with B-frames the pts stay >= 0; audio from before the cut is dropped.
+    const int64_t keyTs = key->dts != AV_NOPTS_VALUE ? key->dts : key->pts;
+    for (StreamMap& s : streams) {
+        s.offset = av_rescale_q(keyTs, videoTb, s.inTb);
+        s.lastDts = AV_NOPTS_VALUE;
+    }
+
+    const int64_t segMs = (int64_t)cfg.segmentSec * 1000;
+    boundaryMs = (wallMs / segMs + 1) * segMs;
+    lastVideoEnd = AV_NOPTS_VALUE;
+    return true;
+}
+
+void SegmentMuxer::closeSegment(int64_t endPts) {
+    if (!out) return;
+
+    int ret = av_write_trailer(out);
+    if (ret < 0) fail("write trailer " + current.path, ret);
+    avio_closep(&out->pb);
+    avformat_free_context(out);
+    out = nullptr;
+
+    if (endPts == AV_NOPTS_VALUE) endPts = lastVideoEnd != AV_NOPTS_VALUE ? lastVideoEnd : current.startPts;
+    current.endPts = endPts;
+    current.endMs = current.startMs + av_rescale_q(endPts - current.startPts, videoTb, kMsTb);
+    std::error_code ec;
+    current.bytes = fs::file_size(current.path, ec);
+    if (ec) current.bytes = 0;
+
+    if (onSegment) onSegment(current);
+}
+
+bool SegmentMuxer::push(AVPacket* pkt, int64_t nowMs) {
+    if (pkt->stream_index < 0 || pkt->stream_index >= (int)streams.size()) return true;
+    StreamMap& s = streams[pkt->stream_index];
+    if (s.out < 0) return true;
+
+    const bool isVideo = pkt->stream_index == videoIndex;
+    const int64_t pts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+    if (pts == AV_NOPTS_VALUE) {
+        ++dropped; // cannot be placed on the timeline
+        return true;
+    }
+
+    if (isVideo && (pkt->flags & AV_PKT_FLAG_KEY)) {
+        // Cut on the first keyframe at or after the clock-aligned boundary
+        const int64_t wall = wallClock(pts, nowMs);
+        if (!out || wall >= boundaryMs) {
+            closeSegment(pts);
+            if (!openSegment(pkt, wall)) return false;
+        }
+    } else if (isVideo) {
+        wallClock(pts, nowMs);
+    }
+    if (!out) return true; // waiting for the first keyframe
+
+    if (pkt->dts == AV_NOPTS_VALUE) pkt->dts = pts;
+    if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= s.offset;
+    pkt->dts -= s.offset;
+    if (pkt->dts < 0) {
+        ++dropped; // before the cut
+        return true;
+    }
+
+    if (isVideo) {
+        if (pkt->flags & AV_PKT_FLAG_KEY) ++current.keyframes;
+        lastVideoEnd = pts + pkt->duration;
+    }
+
+    const AVRational outTb = out->streams[s.out]->time_base;
+    av_packet_rescale_ts(pkt, s.inTb, outTb);
+    // The MP4 muxer rejects non-increasing dts (camera timestamp glitches)
+    if (s.lastDts != AV_NOPTS_VALUE && pkt->dts <= s.lastDts) {
+        ++dropped;
+        return true;
+    }
+    s.lastDts = pkt->dts;
+    pkt->stream_index = s.out;
+    ++current.packets;
+
+    int ret = av_interleaved_write_frame(out, pkt);
+    if (ret < 0) {
+        fail("write " + current.path, ret);
+        const std::string writeError = error;
+        closeSegment(AV_NOPTS_VALUE);
+        error = writeError;
+        return false;
+    }
+    return true;
+}
+
+void SegmentMuxer::finish() {
+    closeSegment(AV_NOPTS_VALUE);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+// A segment that was finalized: trailer written, file closed, size known.
+struct SegmentEvent {
+    std::string path;          // absolute path of the .mp4
+    std::string file;          // relative to <out>/<camera>: <date>/seg_<epoch>_<n>.mp4
+    int64_t startPts = 0;      // first keyframe, source video time base
+    int64_t endPts = 0;        // next segment's first keyframe (or last frame + duration)
+    AVRational timeBase{1, 90000};
+    int64_t startMs = 0;       // wall clock, epoch ms
+    int64_t endMs = 0;
+    uint64_t bytes = 0;
+    int keyframes = 0;
+    int packets = 0;
+};
+
+struct SegmentMuxerConfig {
+    std::string cameraId;
+    std::string outRoot;       // segments go to <outRoot>/<cameraId>/<date>/
+    int segmentSec = 3;
+    // Live input: the pts -> wall clock mapping is re-anchored when it drifts from the
+    // real clock (camera clock skew, timestamp jumps). Files keep the pts timeline.
+    bool liveClock = true;
+};
+
+// In-process replacement for `ffmpeg -c copy -f segment -segment_atclocktime 1
+// -reset_timestamps 1 -movflags frag_keyframe+empty_moov`: packets of the input streams
+// are copied into fragmented MP4 segments, cut on the first video keyframe at or after
+// each clock-aligned boundary (multiple of segmentSec). Each segment starts at timestamp 0.
+class SegmentMuxer {
+public:
+    using EventFn = std::function<void(const SegmentEvent&)>;
+
+    SegmentMuxer(SegmentMuxerConfig cfg, EventFn onSegment);
+    ~SegmentMuxer();
+    SegmentMuxer(const SegmentMuxer&) = delete;
+    SegmentMuxer& operator=(const SegmentMuxer&) = delete;
+
+    // Takes the codec parameters of the video stream and of the audio streams of `in`.
+    // False: no video stream.
+    bool begin(const AVFormatContext* in);
+    // One demuxed packet (source time base); its payload is handed to the output muxer,
+    // the caller still unrefs it. nowMs: wall clock at arrival, epoch ms.
+    // False on a write error (segment closed, error in lastError()).
+    bool push(AVPacket* pkt, int64_t nowMs);
+    // Finalizes the open segment, if any (end of input, stop)
+    void finish();
+
+    const std::string& lastError() const { return error; }
+    int droppedPackets() const { return dropped; }
+
+private:
+    struct StreamMap {
+        int out = -1;          // output stream index, -1 = not recorded
+        AVRational inTb{1, 1};
+        int64_t offset = 0;    // cutting keyframe in this stream's time base (reset_timestamps)
+        int64_t lastDts = AV_NOPTS_VALUE; // output time base
+    };
+
+    bool openSegment(const AVPacket* key, int64_t wallMs);
+    void closeSegment(int64_t endPts);
+    int64_t wallClock(int64_t pts, int64_t nowMs);
+    bool fail(const std::string& what, int err);
+
+    SegmentMuxerConfig cfg;
+    EventFn onSegment;
+    std::string error;
+
+    std::vector<StreamMap> streams;
+    std::vector<AVCodecParameters*> outParams; // per output stream, owned
+    int videoIndex = -1;
+    AVRational videoTb{1, 90000};
+
+    // pts -> wall clock
+    bool anchored = false;
+    int64_t anchorPts = 0;
+    int64_t anchorMs = 0;
+
+    AVFormatContext* out = nullptr;
+    SegmentEvent current;
+    int64_t boundaryMs = 0;    // next clock-aligned cut
+    int64_t lastVideoEnd = AV_NOPTS_VALUE;
+    int segmentIndex = 0;
+    int dropped = 0;
+};
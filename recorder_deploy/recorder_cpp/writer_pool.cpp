@@ -0,0 +1,79 @@
+#include "writer_pool.h"
+#include <exception>
+#include <iostream>
+
+static constexpr int kBatch = 64;
+
+WriterPool::WriterPool(int threads) {
+    if (threads < 1) threads = 1;
+    workers.reserve(threads);
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(&WriterPool::workerLoop, this);
+    }
+}
+
+WriterPool::~WriterPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cvWork.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+std::shared_ptr<WriterPool::Strand> WriterPool::createStrand(size_t maxQueued) {
+    auto strand = std::make_shared<Strand>();
+    strand->maxQueued = maxQueued;
+    return strand;
+}
+
+bool WriterPool::submit(const std::shared_ptr<Strand>& strand, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (strand->tasks.size() >= strand->maxQueued) return false;
+        strand->tasks.push_back(std::move(task));
+        if (strand->scheduled) return true;
+        strand->scheduled = true;
+        readyQueue.push_back(strand);
+    }
+    cvWork.notify_one();
+    return true;
+}
+
+void WriterPool::drain(const std::shared_ptr<Strand>& strand) {
+    std::unique_lock<std::mutex> lock(mtx);
+    cvIdle.wait(lock, [&strand] { return !strand->scheduled; });
+}
+
+void WriterPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        cvWork.wait(lock, [this] { return stopping || !readyQueue.empty(); });
+        if (readyQueue.empty()) return; // stopping, nothing left
+
+        std::shared_ptr<Strand> strand = std::move(readyQueue.front());
+        readyQueue.pop_front();
+
+        // A batch of the strand on this worker (per-camera order is preserved), then it goes
+        // to the back of the queue so one busy camera cannot hold a writer forever
+        for (int n = 0; n < kBatch && !strand->tasks.empty(); ++n) {
+            std::function<void()> task = std::move(strand->tasks.front());
+            strand->tasks.pop_front();
+            lock.unlock();
+            try {
+                task();
+            } catch (const std::exception& e) {
+                std::cerr << "[WriterPool] Task failed: " << e.what() << std::endl;
+            }
+            lock.lock();
+        }
+        if (!strand->tasks.empty()) {
+            readyQueue.push_back(std::move(strand));
+            continue;
+        }
+        strand->scheduled = false;
+        cvIdle.notify_all();
+    }
+}
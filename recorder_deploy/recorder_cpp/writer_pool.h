@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small pool of writer threads shared by every camera of the process (muxing + disk I/O).
+// Each camera owns a strand: its tasks run strictly in submission order, one at a time,
+// while different cameras are written in parallel. A camera whose disk writes stall only
+// fills its own bounded queue.
+class WriterPool {
+public:
+    class Strand;
+
+    explicit WriterPool(int threads);
+    ~WriterPool();
+    WriterPool(const WriterPool&) = delete;
+    WriterPool& operator=(const WriterPool&) = delete;
+
+    // maxQueued: tasks beyond this are rejected (submit returns false)
+    std::shared_ptr<Strand> createStrand(size_t maxQueued);
+    bool submit(const std::shared_ptr<Strand>& strand, std::function<void()> task);
+    // Blocks until every task already submitted to the strand has run
+    void drain(const std::shared_ptr<Strand>& strand);
+
+    int threadCount() const { return (int)workers.size(); }
+
+    class Strand {
+        friend class WriterPool;
+        std::deque<std::function<void()>> tasks;
+        size_t maxQueued = 0;
+        bool scheduled = false; // in readyQueue or running on a worker
+    };
+
+private:
+    void workerLoop();
+
+    std::mutex mtx;
+    std::condition_variable cvWork;
+    std::condition_variable cvIdle;
+    std::deque<std::shared_ptr<Strand>> readyQueue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};